@@ -0,0 +1,73 @@
+/*
+ * Copyright 2021 Xavier Hosxe
+ *
+ * Author: Xavier Hosxe (xavier <dot> hosxe (at) g m a i l <dot> com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#ifndef FIRMWAREUPDATE_H_
+#define FIRMWAREUPDATE_H_
+
+#include <stdint.h>
+
+typedef enum {
+    UPDATE_SKIPPED = 0,
+    UPDATE_PROGRAMMED,
+    UPDATE_READ_ERROR,
+    UPDATE_ERASE_ERROR,
+    UPDATE_PROGRAM_ERROR
+} FirmwareUpdateResult;
+
+void crc32Init();
+// Standard CRC32 : start with 0xffffffff and invert the final value
+uint32_t crc32Update(uint32_t crc, const uint8_t *data, uint32_t length);
+
+/*
+ * Compare the firmware file with the flash one sector at a time,
+ * only the sectors that differ are erased and programmed.
+ * Each sector is read once from the file into sectorBuffer, that is then programmed.
+ * No HAL nor FatFS here : the bootloader gives the SD card and the flash,
+ * scripts/firmwareUpdateTest.cpp gives a file and a flash in memory.
+ */
+class FirmwareUpdate {
+public:
+    // sectorBuffer holds sectorSize bytes
+    FirmwareUpdate(uint32_t imageSize, uint32_t sectorSize, uint8_t *sectorBuffer);
+    virtual ~FirmwareUpdate() {}
+
+    uint32_t getNumberOfSectors() const;
+    // Bytes of the image in the sector, the last one can be partial
+    uint32_t getSectorSize(uint32_t sector) const;
+    // The file must be at the beginning of the sector, it is at the beginning of the next one after.
+    FirmwareUpdateResult updateSector(uint32_t sector);
+    // CRC32 of the file read so far, not inverted
+    uint32_t getFileCrc() const { return fileCrc_; }
+
+protected:
+    // Next block of the file into block, at most maxSize bytes. false on error or end of file
+    virtual bool readBlock(uint8_t *block, uint32_t maxSize, uint32_t *blockSize) = 0;
+    // Current content of the flash, offset is from the beginning of the image
+    virtual const uint8_t* getFlash(uint32_t offset) = 0;
+    virtual bool eraseSector(uint32_t sector) = 0;
+    virtual bool program(uint32_t offset, const uint8_t *block, uint32_t size) = 0;
+
+private:
+    uint32_t imageSize_;
+    uint32_t sectorSize_;
+    uint8_t *sectorBuffer_;
+    uint32_t fileCrc_;
+};
+
+#endif /* FIRMWAREUPDATE_H_ */
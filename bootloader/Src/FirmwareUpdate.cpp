@@ -0,0 +1,94 @@
+/*
+ * Copyright 2021 Xavier Hosxe
+ *
+ * Author: Xavier Hosxe (xavier <dot> hosxe (at) g m a i l <dot> com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <string.h>
+#include "FirmwareUpdate.h"
+
+static uint32_t crc32Table[256];
+
+void crc32Init() {
+    for (uint32_t n = 0; n < 256; n++) {
+        uint32_t c = n;
+        for (int k = 0; k < 8; k++) {
+            c = (c & 1) ? (0xEDB88320 ^ (c >> 1)) : (c >> 1);
+        }
+        crc32Table[n] = c;
+    }
+}
+
+uint32_t crc32Update(uint32_t crc, const uint8_t *data, uint32_t length) {
+    for (uint32_t i = 0; i < length; i++) {
+        crc = crc32Table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+    }
+    return crc;
+}
+
+
+FirmwareUpdate::FirmwareUpdate(uint32_t imageSize, uint32_t sectorSize, uint8_t *sectorBuffer) {
+    imageSize_ = imageSize;
+    sectorSize_ = sectorSize;
+    sectorBuffer_ = sectorBuffer;
+    fileCrc_ = 0xffffffff;
+    crc32Init();
+}
+
+uint32_t FirmwareUpdate::getNumberOfSectors() const {
+    return (imageSize_ + sectorSize_ - 1) / sectorSize_;
+}
+
+uint32_t FirmwareUpdate::getSectorSize(uint32_t sector) const {
+    uint32_t sectorOffset = sector * sectorSize_;
+    if (sectorOffset >= imageSize_) {
+        return 0;
+    }
+    uint32_t size = imageSize_ - sectorOffset;
+    return size > sectorSize_ ? sectorSize_ : size;
+}
+
+FirmwareUpdateResult FirmwareUpdate::updateSector(uint32_t sector) {
+    uint32_t sectorOffset = sector * sectorSize_;
+    uint32_t size = getSectorSize(sector);
+    uint32_t blockSize;
+
+    // The blocks stay in sectorBuffer : a sector that differs is programmed without reading the file again
+    bool sectorDiffers = false;
+    for (uint32_t offset = 0; offset < size; offset += blockSize) {
+        uint8_t *block = sectorBuffer_ + offset;
+        if (!readBlock(block, size - offset, &blockSize) || blockSize == 0) {
+            return UPDATE_READ_ERROR;
+        }
+        fileCrc_ = crc32Update(fileCrc_, block, blockSize);
+        if (!sectorDiffers && memcmp(getFlash(sectorOffset + offset), block, blockSize) != 0) {
+            sectorDiffers = true;
+        }
+    }
+
+    if (!sectorDiffers) {
+        return UPDATE_SKIPPED;
+    }
+
+    if (!eraseSector(sector)) {
+        return UPDATE_ERASE_ERROR;
+    }
+
+    // A programming error doesn't stop the other sectors, the verification will fail
+    if (!program(sectorOffset, sectorBuffer_, size)) {
+        return UPDATE_PROGRAM_ERROR;
+    }
+    return UPDATE_PROGRAMMED;
+}
@@ -23,6 +23,7 @@
 #include "ili9341.h"
 #include "Encoders.h"
 #include "FirmwareFile.h"
+#include "FirmwareUpdate.h"
 #include "usb_device.h"
 
 Encoders encoders;
@@ -32,7 +33,11 @@ FirmwareFile firmwares;
 
 #define BLOCK_SIZE_UINT32 4096
 #define BLOCK_SIZE_UINT8 (BLOCK_SIZE_UINT32 * 4)
-__attribute__((section(".ram_d2"))) uint32_t d2Buffer[BLOCK_SIZE_UINT32];
+// One flash sector of the file, read once then programmed if it differs. RAM_D2B is not used by anything else here
+__attribute__((section(".ram_d2b"))) uint32_t sectorBuffer[FLASH_SECTOR_SIZE / 4];
+
+// Flashing progress is not displayed more often than that
+#define PROGRESS_REFRESH_MILLIS 100
 
 
 char sdAccessAnimation[4] = {'-', '\\', '|', '/' };
@@ -87,7 +92,6 @@ BootloaderEncoderListener bootloaderEncoderListener;
 
 
 void flashFirmware(const FirmwarePFM3File *pfm2File);
-void formatFlash(int firmwareSize);
 void jumpToBootloader();
 void reboot();
 void SDCardAccess();
@@ -247,7 +251,6 @@ void bootloaderLoop() {
                 if (sdError == 0 && firmwares.getNumberOfFiles() >= 1) {
                     // Button 1
                     // Flash
-                    formatFlash(firmwares.getFile(fileSelect)->size);
                     flashFirmware(firmwares.getFile(fileSelect));
                 }
                 break;
@@ -311,110 +314,206 @@ void bootJumpToApplication(uint32_t applicationAddress) {
 }
 
 
-void flashFirmware(const FirmwarePFM3File *pfm2File) {
-    FIL firmwareFile;
-    FRESULT fatFSResult = f_open(&firmwareFile, firmwares.getFullName(pfm2File->name), FA_READ);
-    tft.setCharBackgroundColor(COLOR_BLACK);
-    tft.setCharColor(COLOR_YELLOW);
-    uint32_t size = pfm2File->size;
-    uint32_t offset = 0;
-    UINT byteRead;
-    uint32_t flashAdress = 0x8020000;
-    uint32_t sizeToFlash;
-    uint32_t retFlash;
-
-    if (fatFSResult == FR_OK) {
-        tft.setCursor(6, 10);
-        tft.print("Flashing");
-        HAL_Delay(20);
-        tft.setCharColor(COLOR_LIGHT_GRAY);
-
-        while (offset < size) {
-            float percent = offset * 100 / size;
-            tft.setCursor(9, 11);
-            tft.print((int)percent);
-            tft.print("%");
-            HAL_Delay(10);
+void printHex32(uint32_t value) {
+    char hex[9];
+    for (int d = 7; d >= 0; d--) {
+        uint8_t digit = value & 0xf;
+        hex[d] = digit < 10 ? '0' + digit : 'A' + digit - 10;
+        value >>= 4;
+    }
+    hex[8] = '\0';
+    tft.print(hex);
+}
 
-            f_read(&firmwareFile, (void*)d2Buffer, BLOCK_SIZE_UINT8, &byteRead);
-            sizeToFlash = ((byteRead + 3) / 4);
-            retFlash = FLASH_If_Write(flashAdress, d2Buffer, sizeToFlash);
-            if (retFlash != FLASHIF_OK) {
-                tft.setCharColor(COLOR_RED);
-                tft.setCursor(6, 12);
-                tft.print("#Error#");
-                tft.print((int)retFlash);
-                HAL_Delay(50);
-            }
-            offset += byteRead;
-            flashAdress += BLOCK_SIZE_UINT8;
-        }
+/*
+ * Read back the programmed image and compare its CRC32 with the one of the file.
+ * Returns true if they match.
+ */
+bool verifyFirmware(uint32_t fileCrc, uint32_t size) {
+    tft.setCharColor(COLOR_YELLOW);
+    tft.setCursor(6, 12);
+    tft.print("Verifying");
 
-        tft.setCursor(9, 11);
-        tft.print("100%");
-        HAL_Delay(10);
+    uint32_t flashCrc = crc32Update(0xffffffff, (const uint8_t*) APPLICATION_ADDRESS, size) ^ 0xffffffff;
 
+    tft.fillArea(0, 240, 240, 80, COLOR_BLACK);
+    if (flashCrc == fileCrc) {
         tft.setCharColor(COLOR_GREEN);
-        tft.setCursor(7, 12);
-        tft.print("Success");
-        tft.setCharColor(COLOR_WHITE);
-        reboot();
-    } else {
-        tft.setCharColor(COLOR_RED);
-        tft.setCursor(6, 12);
-        tft.print("#Error#");
-        while (1);
+        tft.setCursor(6, 13);
+        tft.print("Verify OK");
+        tft.setCharColor(COLOR_LIGHT_GRAY);
+        tft.setCursor(5, 14);
+        tft.print("CRC ");
+        printHex32(flashCrc);
+        return true;
     }
 
+    tft.setCharColor(COLOR_RED);
+    tft.setCursor(4, 12);
+    tft.print("Verify FAILED");
+    tft.setCharColor(COLOR_LIGHT_GRAY);
+    tft.setCursor(3, 13);
+    tft.print("File  ");
+    printHex32(fileCrc);
+    tft.setCursor(3, 14);
+    tft.print("Flash ");
+    printHex32(flashCrc);
+    tft.setCharColor(COLOR_YELLOW);
+    tft.setCursor(2, 15);
+    tft.print("Press any button");
+    return false;
+}
 
-
+void printFlashError(const char *error, int code) {
+    tft.setCharColor(COLOR_RED);
+    tft.setCursor(6, 12);
+    tft.print(error);
+    tft.print(code);
 }
 
-void formatFlash(int firmwareSize) {
-    FLASH_EraseInitTypeDef pEraseInit;
-    uint32_t SectorError;
+/*
+ * FirmwareUpdate on the SD card file and the application flash
+ */
+class SdCardFirmwareUpdate : public FirmwareUpdate {
+public:
+    SdCardFirmwareUpdate(FIL *firmwareFile, uint32_t size) : FirmwareUpdate(size, FLASH_SECTOR_SIZE, (uint8_t*)sectorBuffer) {
+        firmwareFile_ = firmwareFile;
+        size_ = size;
+        filePosition_ = 0;
+        lastPercent_ = 0xffffffff;
+        progressMillis_ = 0;
+    }
 
+    void printProgress() {
+        uint32_t percent = filePosition_ * 100 / size_;
+        if (percent != lastPercent_ && (HAL_GetTick() - progressMillis_) >= PROGRESS_REFRESH_MILLIS) {
+            lastPercent_ = percent;
+            progressMillis_ = HAL_GetTick();
+            tft.setCharColor(COLOR_LIGHT_GRAY);
+            tft.setCursor(9, 11);
+            tft.print((int)percent);
+            tft.print("%");
+        }
+    }
 
-    tft.setCharBackgroundColor(COLOR_BLACK);
-    tft.setCharColor(COLOR_YELLOW);
-    tft.setCursor(6, 10);
-    tft.print("Formatting");
-    HAL_Delay(20);
+protected:
+    bool readBlock(uint8_t *block, uint32_t maxSize, uint32_t *blockSize) {
+        printProgress();
+        UINT byteRead;
+        FRESULT fatFSResult = f_read(firmwareFile_, (void*)block, maxSize < BLOCK_SIZE_UINT8 ? maxSize : BLOCK_SIZE_UINT8, &byteRead);
+        if (fatFSResult != FR_OK || byteRead == 0) {
+            printFlashError("#Read Error#", (int)fatFSResult);
+            return false;
+        }
+        *blockSize = byteRead;
+        filePosition_ += byteRead;
+        return true;
+    }
 
+    const uint8_t* getFlash(uint32_t offset) {
+        return (const uint8_t*)(APPLICATION_ADDRESS + offset);
+    }
 
-    // Use firmware size, no need to format more
-    int number = firmwareSize / 131072 + 1;
-    for (int k=0; k < number; k++) {
-        tft.setCharColor(COLOR_LIGHT_GRAY);
-        tft.setCursor(9, 11);
-        tft.print((k + 1));
-        tft.print("/");
-        tft.print(number);
-        HAL_Delay(30);
+    bool eraseSector(uint32_t sector) {
+        FLASH_EraseInitTypeDef pEraseInit;
+        uint32_t SectorError;
 
         HAL_FLASH_Unlock();
         FLASH_If_Init();
 
+        // First sector of the application is sector 1
         pEraseInit.TypeErase = FLASH_TYPEERASE_SECTORS;
-        pEraseInit.Sector = k + 1;
+        pEraseInit.Sector = sector + 1;
         pEraseInit.NbSectors = 1;
         pEraseInit.VoltageRange = FLASH_VOLTAGE_RANGE_3;
         pEraseInit.Banks = FLASH_BANK_1;
 
-        if (HAL_FLASHEx_Erase(&pEraseInit, &SectorError) != HAL_OK)
-        {
-            tft.setCharColor(COLOR_RED);
-            tft.setCursor(6, 12);
-            tft.print("#Error#");
-            tft.print((int)SectorError);
-            while (1);
+        HAL_StatusTypeDef status = HAL_FLASHEx_Erase(&pEraseInit, &SectorError);
+        HAL_FLASH_Lock();
+        if (status != HAL_OK) {
+            printFlashError("#Error#", (int)SectorError);
+            return false;
         }
+        return true;
+    }
 
-        HAL_FLASH_Lock();
+    bool program(uint32_t offset, const uint8_t *block, uint32_t size) {
+        // block is sectorBuffer
+        uint32_t retFlash = FLASH_If_Write(APPLICATION_ADDRESS + offset, (uint32_t*)block, (size + 3) / 4);
+        if (retFlash != FLASHIF_OK) {
+            printFlashError("#Error#", (int)retFlash);
+            HAL_Delay(50);
+            return false;
+        }
+        return true;
     }
 
-    tft.fillArea(0, 200, 240, 60, COLOR_BLACK);
-    HAL_Delay(5);
+private:
+    FIL *firmwareFile_;
+    uint32_t size_;
+    uint32_t filePosition_;
+    uint32_t lastPercent_;
+    uint32_t progressMillis_;
+};
+
+/*
+ * The file is compared with the flash one sector at a time.
+ * Only the sectors that differ are erased and programmed, from the sector read for the compare.
+ */
+void flashFirmware(const FirmwarePFM3File *pfm2File) {
+    FIL firmwareFile;
+    FRESULT fatFSResult = f_open(&firmwareFile, firmwares.getFullName(pfm2File->name), FA_READ);
+    tft.setCharBackgroundColor(COLOR_BLACK);
+    tft.setCharColor(COLOR_YELLOW);
+    uint32_t size = pfm2File->size;
+    uint32_t numberOfSkippedSectors = 0;
+
+    if (fatFSResult == FR_OK) {
+        tft.setCursor(6, 10);
+        tft.print("Flashing");
+
+        SdCardFirmwareUpdate firmwareUpdate(&firmwareFile, size);
+        uint32_t numberOfSectors = firmwareUpdate.getNumberOfSectors();
+
+        for (uint32_t sector = 0; sector < numberOfSectors; sector++) {
+            switch (firmwareUpdate.updateSector(sector)) {
+            case UPDATE_SKIPPED:
+                numberOfSkippedSectors++;
+                break;
+            case UPDATE_PROGRAMMED:
+            case UPDATE_PROGRAM_ERROR:
+                // A programming error is caught by the verification
+                break;
+            default:
+                // The file cannot be read where it should : the flash content is unknown
+                while (1);
+            }
+        }
+        f_close(&firmwareFile);
+
+        tft.fillArea(0, 220, 240, 20, COLOR_BLACK);
+        tft.setCharColor(COLOR_LIGHT_GRAY);
+        tft.setCursor(3, 11);
+        tft.print("Skipped ");
+        tft.print((int)numberOfSkippedSectors);
+        tft.print(" of ");
+        tft.print((int)numberOfSectors);
+
+        if (verifyFirmware(firmwareUpdate.getFileCrc() ^ 0xffffffff, size)) {
+            reboot();
+        }
+
+        // Do not boot a corrupted firmware, go back to the menu
+        while (getButtonPressed() == (uint32_t) -1) {
+            HAL_Delay(2);
+        }
+        state = STATE_INIT;
+    } else {
+        tft.setCharColor(COLOR_RED);
+        tft.setCursor(6, 12);
+        tft.print("#Error#");
+        while (1);
+    }
 }
 
 // https://community.st.com/s/article/STM32H7-bootloader-jump-from-application
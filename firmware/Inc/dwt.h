@@ -37,6 +37,12 @@
             *DWT_CONTROL = *DWT_CONTROL | 1;		\
         } while ( 0 )
 
+#define ENABLE_DWT_CYCCNT()			\
+        do {						\
+            *SCB_DEMCT = *SCB_DEMCT | 0x01000000;		\
+            *DWT_CONTROL = *DWT_CONTROL | 1;		\
+        } while ( 0 )
+
 #define READ_DWT_CYCCNT()			\
         *(DWT_CYCCNT)
 
@@ -45,22 +51,24 @@ typedef RingBuffer<uint32_t, 32> CYCCNT_buffer;
 
 /**
  * Utitity to automatically track cycles spent within a scope
- * Doesn't support nested measurements!
+ * The counter is free running (the boot profiler reads it too) : we keep the difference
  */
 class scoped_cyccnt
 {
 public:
     scoped_cyccnt( CYCCNT_buffer &_buffer )
 : buffer( _buffer ) {
-        RESET_DWT_CYCCNT();
+        ENABLE_DWT_CYCCNT();
+        start = READ_DWT_CYCCNT();
     }
 
     ~scoped_cyccnt() {
-        buffer.insert( READ_DWT_CYCCNT() );
+        buffer.insert( READ_DWT_CYCCNT() - start );
     }
 
 private:
     CYCCNT_buffer &buffer;
+    uint32_t start;
 };
 
 #define MACRO_CONCAT_(x,y) x##y
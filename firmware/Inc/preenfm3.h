@@ -29,7 +29,7 @@ bool isButton1Pressed();
 
 void preenfm3TftTic();
 void preenfm3_USART();
-void preenfm3_usbDataReceive(uint8_t *buffer);
+uint8_t preenfm3_usbDataReceive(uint8_t *buffer);
 void preenfm3StartSai();
 
 float getCompInstrumentVolume(int t);
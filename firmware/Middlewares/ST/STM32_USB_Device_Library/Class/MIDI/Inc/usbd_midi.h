@@ -95,7 +95,8 @@
 
 typedef struct
 {
-    void  (*dataReceived)         (uint8_t *buffer);
+    /* USBD_OK to receive the next packet, USBD_BUSY to NAK the host until USBD_MIDI_ReceivePacket */
+    int8_t  (*dataReceived)       (uint8_t *buffer);
 } USBD_MIDI_ItfTypeDef;
 
 extern USBD_ClassTypeDef  USBD_MIDI;
@@ -104,6 +105,8 @@ extern USBD_ClassTypeDef  USBD_MIDI;
 uint8_t  USBD_MIDI_RegisterInterface  (USBD_HandleTypeDef   *pdev,
                                         USBD_MIDI_ItfTypeDef *fops);
 
+uint8_t  USBD_MIDI_ReceivePacket      (USBD_HandleTypeDef   *pdev);
+
 
 #ifdef __cplusplus
 }
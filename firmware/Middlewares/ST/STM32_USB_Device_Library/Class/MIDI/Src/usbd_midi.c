@@ -11,9 +11,9 @@
 
 
 
-uint8_t usbMidiInBuffAll[128];
-uint8_t *usbMidiInBuffWrt = usbMidiInBuffAll;
-uint8_t *usbMidiInBuffRead = usbMidiInBuffAll;
+uint8_t usbMidiInBuff[MIDI_OUT_PACKET];
+// The OUT endpoint is not armed : the host is NAKed until USBD_MIDI_ReceivePacket
+volatile uint8_t usbMidiInPaused = 0;
 
 
 static uint8_t  USBD_MIDI_Init (USBD_HandleTypeDef *pdev,
@@ -233,7 +233,8 @@ static uint8_t  USBD_MIDI_Init (USBD_HandleTypeDef *pdev, uint8_t cfgidx)
 	USBD_LL_OpenEP(pdev, MIDI_OUT_EP, USBD_EP_TYPE_BULK, MIDI_OUT_PACKET);
 	pdev->ep_out[MIDI_OUT_EP & 0xFU].is_used = 1U;
 
-	USBD_LL_PrepareReceive(pdev, MIDI_OUT_EP, usbMidiInBuffWrt,  MIDI_OUT_PACKET);
+	usbMidiInPaused = 0;
+	USBD_LL_PrepareReceive(pdev, MIDI_OUT_EP, usbMidiInBuff,  MIDI_OUT_PACKET);
 
 	return USBD_OK;
 }
@@ -370,17 +371,30 @@ static uint8_t  USBD_MIDI_IsoOutIncomplete (USBD_HandleTypeDef *pdev, uint8_t ep
 static uint8_t  USBD_MIDI_DataOut (USBD_HandleTypeDef *pdev,
 		uint8_t epnum)
 {
-	usbMidiInBuffWrt += 64;
-	if (usbMidiInBuffWrt >= (usbMidiInBuffAll + 128)) {
-		usbMidiInBuffWrt = usbMidiInBuffAll;
+	// The packet is read before the endpoint is armed again
+	if (((USBD_MIDI_ItfTypeDef *)pdev->pUserData)->dataReceived(usbMidiInBuff) == USBD_OK) {
+		USBD_LL_PrepareReceive(pdev, MIDI_OUT_EP, usbMidiInBuff,  MIDI_OUT_PACKET);
+	} else {
+		// No room for another packet : the next ones wait in the host
+		usbMidiInPaused = 1;
 	}
 
-	USBD_LL_PrepareReceive(pdev, MIDI_OUT_EP, usbMidiInBuffWrt,  MIDI_OUT_PACKET);
-
-	((USBD_MIDI_ItfTypeDef *)pdev->pUserData)->dataReceived(usbMidiInBuffRead);
-
-	 usbMidiInBuffRead = usbMidiInBuffWrt;
+	return USBD_OK;
+}
 
+/**
+ * @brief  USBD_MIDI_ReceivePacket
+ *         Arm the OUT endpoint again after dataReceived returned USBD_BUSY
+ * @param  pdev: device instance
+ * @retval status
+ */
+uint8_t  USBD_MIDI_ReceivePacket (USBD_HandleTypeDef *pdev)
+{
+	// No OUT transfer can complete while paused
+	if (usbMidiInPaused) {
+		usbMidiInPaused = 0;
+		USBD_LL_PrepareReceive(pdev, MIDI_OUT_EP, usbMidiInBuff,  MIDI_OUT_PACKET);
+	}
 	return USBD_OK;
 }
 
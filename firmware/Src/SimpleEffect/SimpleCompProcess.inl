@@ -37,8 +37,9 @@
 #ifndef __SIMPLE_COMP_PROCESS_INL__
 #define __SIMPLE_COMP_PROCESS_INL__
 
-#define INV32 0.03125f
-#define unlikely(x)     __builtin_expect((x),0)
+#include "Common.h"		// for BLOCK_SIZE
+
+#define INV_BLOCK_SIZE_COMP (1.0f / BLOCK_SIZE)
 
 namespace chunkware_simple
 {
@@ -48,17 +49,17 @@ namespace chunkware_simple
 	{
 	    float *startBuffer = inStereo;
 	    float maxAbsSample = 0.0f;
-	    for (int s = 0; s < 32; s++) {
+	    for (int s = 0; s < BLOCK_SIZE; s++) {
             float rect1 = abs( *inStereo++ );	// rectify input
             float rect2 = abs( *inStereo++ );
             maxAbsSample = std::max( maxAbsSample, std::max( rect1, rect2 )); // find the max
 	    }
 	    float gain = getGain(maxAbsSample);
 	    // Let's slowly (linearly) reach  the new gain
-	    float incGain = (gain - previousGain_) * INV32;
+	    float incGain = (gain - previousGain_) * INV_BLOCK_SIZE_COMP;
         if (gain < (1.0f - DC_OFFSET)) {
             inStereo = startBuffer;
-            for (int s = 0; s < 32; s++) {
+            for (int s = 0; s < BLOCK_SIZE; s++) {
                 previousGain_ += incGain;
                 *(inStereo++) *= previousGain_;
                 *(inStereo++) *= previousGain_;
@@ -27,11 +27,15 @@ extern TftDisplay tft;
 
 __attribute__((section(".ram_d2b"))) struct PFM3File preenFMMixerAlloc[NUMBEROFPREENFMMIXERS];
 __attribute__((section(".ram_d2b"))) static FIL mixerFile;
+__attribute__((section(".ram_d2b"))) __attribute__((aligned(4))) static uint8_t preenFMMixerIndex[BANK_INDEX_SIZE(NUMBER_OF_MIXERS_PER_BANK)];
 
 
 MixerBank::MixerBank() {
     this->numberOfFilesMax_ = NUMBEROFPREENFMMIXERS;
     this->myFiles_ = preenFMMixerAlloc;
+    this->index_ = preenFMMixerIndex;
+    this->indexNumberOfRecords_ = NUMBER_OF_MIXERS_PER_BANK;
+    this->indexRecordSize_ = FULL_MIXER_SIZE;
 }
 
 MixerBank::~MixerBank() {
@@ -88,6 +92,26 @@ bool MixerBank::isCorrectFile(char *name, int size) {
     return true;
 }
 
+const char* MixerBank::getRecordName(char *record) {
+    return MixerState::getMixNameFromFile(record);
+}
+
+/*
+ * Known mixer version, printable name and valid timbres
+ */
+bool MixerBank::isRecordValid(char *record) {
+    uint8_t version = record[0];
+    if (version < MIXER_BANK_VERSION1 || version > MIXER_BANK_CURRENT_VERSION || !isNameValid(getRecordName(record))) {
+        return false;
+    }
+    for (int t = 0; t < NUMBER_OF_TIMBRES; t++) {
+        if (!isFlashPatchValid(record + ALIGNED_MIXER_SIZE + t * ALIGNED_PATCH_SIZE)) {
+            return false;
+        }
+    }
+    return true;
+}
+
 void MixerBank::removeDefaultMixer() {
     remove(DEFAULT_MIXER);
 }
@@ -133,24 +157,72 @@ bool MixerBank::saveMixerData(FIL* file, uint8_t mixerNumber, MixerState* mixerS
 }
 
 
-bool MixerBank::loadMixerData(FIL* file, uint8_t mixerNumber) {
+/*
+ * mixer is 0 for the default mixer, that has no index
+ */
+bool MixerBank::loadMixerData(FIL* file, uint8_t mixerNumber, const struct PFM3File* mixer, const struct BankIndexEntry *entry) {
     UINT byteRead;
-    UINT result;
+    FRESULT result;
 
     for (uint32_t i = 0; i < PROPERTY_FILE_SIZE; i++) {
         storageBuffer[i] = 0;
     }
 
+    // The mixer and its timbres are contiguous : one read
     f_lseek(file, mixerNumber * FULL_MIXER_SIZE);
-    f_read(file, storageBuffer, MIXER_SIZE, &byteRead);
-    mixerState->restoreFullState(storageBuffer);
+    result = f_read(file, storageBuffer, FULL_MIXER_SIZE, &byteRead);
+    if (result != FR_OK) {
+        byteRead = 0;
+    }
+
+    if (entry != 0 && (byteRead != FULL_MIXER_SIZE || (crc32(storageBuffer, FULL_MIXER_SIZE) != entry->crc
+            && !acceptStaleRecord(mixer, mixerNumber, storageBuffer, true)))) {
+        // Corrupted record : keep the current mixer
+        mixerState->mixName_[0] = '#';
+        mixerState->mixName_[1] = '#';
+        mixerState->mixName_[2] = 0;
+        return false;
+    }
+
+    applyMixerRecord(storageBuffer, byteRead);
+    return true;
+}
+
+/*
+ * Read one mixer record into record, checked against the v3 index when there is one.
+ * The set list reads all its records at once : a stale index entry is not fixed here, loadMixer does it.
+ */
+bool MixerBank::readMixerRecord(const struct PFM3File* mixer, int mixerNumber, char* record) {
+    const struct BankIndexEntry *entry = getIndexEntry(mixer, mixerNumber);
+    if (load(getFullName(mixer->name), mixerNumber * FULL_MIXER_SIZE, record, FULL_MIXER_SIZE) != FULL_MIXER_SIZE) {
+        return false;
+    }
+    return entry == 0 || crc32(record, FULL_MIXER_SIZE) == entry->crc || acceptStaleRecord(mixer, mixerNumber, record, false);
+}
+
+/*
+ * Restore the mixer state and the timbres from a mixer record.
+ * Timbres beyond recordSize are marked as not loaded.
+ */
+void MixerBank::applyMixerRecord(char* record, uint32_t recordSize) {
+    bool timbreLoaded[NUMBER_OF_TIMBRES];
+
+    mixerState->restoreFullState(record);
 
     for (int t = 0; t < NUMBER_OF_TIMBRES; t++) {
-        f_lseek(file, mixerNumber * FULL_MIXER_SIZE + ALIGNED_MIXER_SIZE + t * ALIGNED_PATCH_SIZE);
-        result = f_read(file, storageBuffer, PFM3_PATCH_FLASH_SIZE, &byteRead);
-        if (result == FR_OK && byteRead == PFM3_PATCH_FLASH_SIZE) {
-            convertFlashToParams((struct FlashSynthParams *) storageBuffer, this->timbre[t], true);
+        timbreLoaded[t] = recordSize >= ALIGNED_MIXER_SIZE + t * ALIGNED_PATCH_SIZE + PFM3_PATCH_FLASH_SIZE;
+        if (timbreLoaded[t]) {
+            convertFlashToParams((struct FlashSynthParams *) (record + ALIGNED_MIXER_SIZE + t * ALIGNED_PATCH_SIZE), this->timbre[t], true);
+        } else {
+            this->timbre[t]->presetName[0] = '#';
+            this->timbre[t]->presetName[1] = '#';
+            this->timbre[t]->presetName[2] = 0;
+        }
+    }
 
+    // Scala files are read in storageBuffer : only once all timbres are converted
+    for (int t = 0; t < NUMBER_OF_TIMBRES; t++) {
+        if (timbreLoaded[t]) {
             // Init scala scale if enabled
             if (mixerState->instrumentState_[t].scalaEnable == 1) {
                 if (scalaFile->loadScalaScale(mixerState, t) == 0) {
@@ -162,19 +234,14 @@ bool MixerBank::loadMixerData(FIL* file, uint8_t mixerNumber) {
                     mixerState->instrumentState_[t].scaleScaleNumber = 0;
                 }
             }
-        } else {
-            this->timbre[t]->presetName[0] = '#';
-            this->timbre[t]->presetName[1] = '#';
-            this->timbre[t]->presetName[2] = 0;
         }
     }
-    return true;
 }
 
 bool MixerBank::loadDefaultMixer() {
     FRESULT result = f_open(&mixerFile, getFileName(DEFAULT_MIXER), FA_READ);
     if (result == FR_OK) {
-		loadMixerData(&mixerFile, 0);
+		loadMixerData(&mixerFile, 0, 0, 0);
         f_close(&mixerFile);
     } else {
         return false;
@@ -210,6 +277,8 @@ void MixerBank::createMixerBank(const char* name) {
     }
 
     UINT byteWritten;
+    // New banks are created with the v3 index
+    initIndex();
     for (int mixerNumber = 0; mixerNumber < NUMBER_OF_MIXERS_PER_BANK; mixerNumber++) {
 
         tft.setCharColor(COLOR_GRAY);
@@ -221,25 +290,39 @@ void MixerBank::createMixerBank(const char* name) {
 
         mixerState->getFullDefaultState(storageBuffer, &defaultMixerSize, mixerNumber + 1);
         f_write(&mixerFile, (void*) storageBuffer, ALIGNED_MIXER_SIZE + ALIGNED_PATCH_SIZE * NUMBER_OF_TIMBRES, &byteWritten);
+        setIndexEntry(mixerNumber, getRecordName(storageBuffer), crc32(storageBuffer, FULL_MIXER_SIZE));
     }
+    f_write(&mixerFile, index_, BANK_INDEX_SIZE(NUMBER_OF_MIXERS_PER_BANK), &byteWritten);
     f_close(&mixerFile);
 }
 
 bool MixerBank::loadMixer(const struct PFM3File* mixer, int mixerNumber) {
+    const struct BankIndexEntry *entry = getIndexEntry(mixer, mixerNumber);
     const char* fullBankName = getFullName(mixer->name);
 
+    bool loaded;
     FRESULT result = f_open(&mixerFile, fullBankName, FA_READ);
     if (result == FR_OK) {
         // Point to asked mixer
-        loadMixerData(&mixerFile, mixerNumber);
+        loaded = loadMixerData(&mixerFile, mixerNumber, mixer, entry);
         f_close(&mixerFile);
     } else {
         return false;
     }
-    return true;
+    return loaded;
 }
 
 const char* MixerBank::loadMixerName(const struct PFM3File* mixer, int mixerNumber) {
+    // v3 : all names come with the index
+    const struct BankIndexEntry *entry = getIndexEntry(mixer, mixerNumber);
+    if (entry != 0) {
+        for (int p = 0; p < 12; p++) {
+            presetName[p] = entry->name[p];
+        }
+        presetName[12] = 0;
+        return presetName;
+    }
+
     const char* fullBankName = getFullName(mixer->name);
     load(fullBankName, FULL_MIXER_SIZE * mixerNumber, (void*) storageBuffer, 16);
     char* presetNameBuffer =  MixerState::getMixNameFromFile(storageBuffer);
@@ -264,6 +347,8 @@ bool MixerBank::saveMixer(const struct PFM3File* mixer, int mixerNumber, char* m
     } else {
         return false;
     }
+    // Update the index, or upgrade a v1 bank
+    saveIndexEntry(mixer, mixerNumber, getRecordName(storageBuffer), crc32(storageBuffer, FULL_MIXER_SIZE));
     return true;
 }
 
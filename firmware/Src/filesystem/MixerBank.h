@@ -45,12 +45,17 @@ public:
     const char* loadMixerName(const struct PFM3File* mixer, int mixerNumber);
     bool saveMixer(const struct PFM3File* mixer, int mixerNumber, char* mixerName);
 
+    bool readMixerRecord(const struct PFM3File* mixer, int mixerNumber, char* record);
+    void applyMixerRecord(char* record, uint32_t recordSize);
+
 protected:
     const char* getFolderName();
 	bool isCorrectFile(char *name, int size);
     struct OneSynthParams* timbre[NUMBER_OF_TIMBRES];
     bool saveMixerData(FIL* file, uint8_t mixerNumber, MixerState* mixerStateToSave);
-    bool loadMixerData(FIL* file, uint8_t mixerNumber);
+    bool loadMixerData(FIL* file, uint8_t mixerNumber, const struct PFM3File* mixer, const struct BankIndexEntry *entry);
+    const char* getRecordName(char *record);
+    bool isRecordValid(char *record);
 
 private:
     char presetName[13];
@@ -18,10 +18,24 @@
 #include "PatchBank.h"
 
 __attribute__((section(".ram_d2b"))) struct PFM3File preenFMBankAlloc[NUMBEROFPREENFMBANKS];
+__attribute__((section(".ram_d2b"))) __attribute__((aligned(4))) static uint8_t preenFMBankIndex[BANK_INDEX_SIZE(NUMBER_OF_PATCHES_PER_BANK)];
+__attribute__((section(".ram_d2b"))) __attribute__((aligned(4))) static char patchCacheRecords[PATCH_CACHE_SIZE][ALIGNED_PATCH_SIZE];
 
 PatchBank::PatchBank() {
     numberOfFilesMax_ = NUMBEROFPREENFMBANKS;
     myFiles_ = preenFMBankAlloc;
+    index_ = preenFMBankIndex;
+    indexNumberOfRecords_ = NUMBER_OF_PATCHES_PER_BANK;
+    indexRecordSize_ = ALIGNED_PATCH_SIZE;
+
+    for (int s = 0; s < PATCH_CACHE_SIZE; s++) {
+        patchCache_[s].patchNumber = -1;
+        patchCache_[s].lastUse = 0;
+    }
+    patchCacheUse_ = 0;
+    cacheHits_ = 0;
+    cacheMisses_ = 0;
+    cachePrefetches_ = 0;
 }
 
 PatchBank::~PatchBank() {
@@ -77,57 +91,203 @@ void PatchBank::createPatchBank(const char *name) {
     convertParamsToFlash(&preenMainPreset, (struct FlashSynthParams*) storageBuffer, *arpeggiatorPartOfThePreset_ > 0);
     *(uint32_t*) (&storageBuffer[ALIGNED_PATCH_SIZE - 5]) = PRESET_CURRENT_VERSION;
 
-    for (int k = 0; k < 128; k++) {
+    for (int k = 0; k < NUMBER_OF_PATCHES_PER_BANK; k++) {
         f_write(&bankFile, storageBuffer, ALIGNED_PATCH_SIZE, &byteWritten);
     }
+
+    // New banks are created with the v3 index
+    initIndex();
+    uint32_t crc = crc32(storageBuffer, ALIGNED_PATCH_SIZE);
+    for (int k = 0; k < NUMBER_OF_PATCHES_PER_BANK; k++) {
+        setIndexEntry(k, getRecordName(storageBuffer), crc);
+    }
+    saveData(bankFile, index_, BANK_INDEX_SIZE(NUMBER_OF_PATCHES_PER_BANK));
     closeFile(bankFile);
 }
 
 void PatchBank::loadPatch(const struct PFM3File *bank, int patchNumber, struct OneSynthParams *params) {
-    const char *fullBankName = getFullName(bank->name);
+    int slot = findCachedPatch(bank, patchNumber);
+    if (slot >= 0) {
+        cacheHits_++;
+    } else {
+        cacheMisses_++;
+        slot = getCacheSlotToReplace();
+        int status = fetchPatch(bank, patchNumber, slot, true);
+        if (status == PATCH_RECORD_CORRUPTED) {
+            // Corrupted record : keep the current sound
+            params->presetName[0] = '#';
+            params->presetName[1] = '#';
+            params->presetName[2] = 0;
+            return;
+        }
+        if (status != PATCH_RECORD_OK) {
+            return;
+        }
+    }
+    patchCache_[slot].lastUse = ++patchCacheUse_;
 
-    int result = load(fullBankName, patchNumber * ALIGNED_PATCH_SIZE, (void*) storageBuffer, ALIGNED_PATCH_SIZE);
+    decodeBufferAndApplyPreset((uint8_t*) patchCacheRecords[slot], params);
+}
 
-    if (result == ALIGNED_PATCH_SIZE) {
-        uint32_t version = *(uint32_t*) (&storageBuffer[ALIGNED_PATCH_SIZE - 5]);
-        switch (version) {
-            case PRESET_VERSION2:
-                // Direct copy
-                for (uint32_t p = 0; p < PFM3_PATCH_FLASH_SIZE; p++) {
-                    ((char*) params)[p] = storageBuffer[p];
-                }
-                break;
-            default:
-                // VERSION1 Needs a conversion
-                convertFlashToParams((const struct FlashSynthParams*) storageBuffer, params, *arpeggiatorPartOfThePreset_ > 0);
-                break;
+/*
+ * buffer is one ALIGNED_PATCH_SIZE bank record
+ */
+bool PatchBank::decodeBufferAndApplyPreset(uint8_t *buffer, struct OneSynthParams *params) {
+    const char *record = (const char*) buffer;
+    uint32_t version = *(uint32_t*) (&record[ALIGNED_PATCH_SIZE - 5]);
+    switch (version) {
+        case PRESET_VERSION2:
+            // Direct copy
+            for (uint32_t p = 0; p < PFM3_PATCH_FLASH_SIZE; p++) {
+                ((char*) params)[p] = record[p];
+            }
+            break;
+        default:
+            // VERSION1 Needs a conversion
+            convertFlashToParams((const struct FlashSynthParams*) record, params, *arpeggiatorPartOfThePreset_ > 0);
+            break;
+    }
+    return true;
+}
+
+/*
+ * The cache is keyed by bank name : a renamed or a new bank must not get the records of another one
+ */
+void PatchBank::fileNamesChanged() {
+    for (int s = 0; s < PATCH_CACHE_SIZE; s++) {
+        patchCache_[s].patchNumber = -1;
+    }
+}
+
+int PatchBank::findCachedPatch(const struct PFM3File *bank, int patchNumber) {
+    for (int s = 0; s < PATCH_CACHE_SIZE; s++) {
+        if (patchCache_[s].patchNumber == patchNumber && fsu_->str_cmp(patchCache_[s].bankName, bank->name) == 0) {
+            return s;
         }
     }
+    return -1;
 }
 
-const char* PatchBank::loadPatchName(const struct PFM3File *bank, int patchNumber) {
+int PatchBank::getCacheSlotToReplace() {
+    int oldest = 0;
+    for (int s = 0; s < PATCH_CACHE_SIZE; s++) {
+        if (patchCache_[s].patchNumber == -1) {
+            return s;
+        }
+        if (patchCache_[s].lastUse < patchCache_[oldest].lastUse) {
+            oldest = s;
+        }
+    }
+    return oldest;
+}
 
+/*
+ * Read one record from the SD card into a cache slot.
+ * Only valid records stay in the cache.
+ * A record that doesn't match the index is left to the load the user asks for, prefetch doesn't write.
+ */
+int PatchBank::fetchPatch(const struct PFM3File *bank, int patchNumber, int slot, bool userLoad) {
+    const struct BankIndexEntry *entry = getIndexEntry(bank, patchNumber);
     const char *fullBankName = getFullName(bank->name);
-    uint32_t version;
-    load(fullBankName, patchNumber * ALIGNED_PATCH_SIZE + ALIGNED_PATCH_SIZE - 5, (void*) &version, 4);
+    char *record = patchCacheRecords[slot];
+
+    patchCache_[slot].patchNumber = -1;
+    int result = load(fullBankName, patchNumber * ALIGNED_PATCH_SIZE, (void*) record, ALIGNED_PATCH_SIZE);
+    if (result != ALIGNED_PATCH_SIZE) {
+        return PATCH_RECORD_UNREADABLE;
+    }
+    if (entry != 0 && crc32(record, ALIGNED_PATCH_SIZE) != entry->crc
+            && (!userLoad || !acceptStaleRecord(bank, patchNumber, record, true))) {
+        return PATCH_RECORD_CORRUPTED;
+    }
 
-    int namePosition;
+    for (int n = 0; n < 13; n++) {
+        patchCache_[slot].bankName[n] = bank->name[n];
+    }
+    patchCache_[slot].patchNumber = patchNumber;
+    return PATCH_RECORD_OK;
+}
+
+/*
+ * Called from the main loop when there is nothing else to do.
+ * Read at most one missing neighbour of the current patch so that stepping presets does not wait for the SD card.
+ */
+void PatchBank::prefetchNeighbours(const struct PFM3File *bank, int patchNumber) {
+    // preenFMBank can also point to a DX7 bank
+    if (bank < myFiles_ || bank >= myFiles_ + numberOfFilesMax_ || bank->fileType == FILE_EMPTY) {
+        return;
+    }
+    static const int8_t neighbours[] = { 1, -1, 2, -2 };
+    for (uint32_t n = 0; n < ARRAY_SIZE(neighbours); n++) {
+        int neighbour = patchNumber + neighbours[n];
+        if (neighbour < 0 || neighbour >= NUMBER_OF_PATCHES_PER_BANK || findCachedPatch(bank, neighbour) >= 0) {
+            continue;
+        }
+        int slot = getCacheSlotToReplace();
+        if (fetchPatch(bank, neighbour, slot, false) == PATCH_RECORD_OK) {
+            patchCache_[slot].lastUse = ++patchCacheUse_;
+            cachePrefetches_++;
+        }
+        return;
+    }
+}
 
+int PatchBank::getNamePosition(uint32_t version) {
     switch (version) {
         case PRESET_VERSION2: {
             OneSynthParams *version2Params = (OneSynthParams*) storageBuffer;
-            namePosition = (int) (((unsigned int) version2Params->presetName) - (unsigned int) version2Params);
-            break;
+            return (int) (((unsigned int) version2Params->presetName) - (unsigned int) version2Params);
         }
         default: {
             // VERSION 1
             FlashSynthParams *flashSynthParams = (FlashSynthParams*) storageBuffer;
-            namePosition = (int) (((unsigned int) flashSynthParams->presetName) - (unsigned int) flashSynthParams);
-            break;
+            return (int) (((unsigned int) flashSynthParams->presetName) - (unsigned int) flashSynthParams);
+        }
+    }
+}
+
+const char* PatchBank::getRecordName(char *record) {
+    uint32_t version = *(uint32_t*) (&record[ALIGNED_PATCH_SIZE - 5]);
+    return record + getNamePosition(version);
+}
+
+/*
+ * Known version. The version the firmware saves is a valid FlashSynthParams followed by zeros.
+ */
+bool PatchBank::isRecordValid(char *record) {
+    uint32_t version = *(uint32_t*) (&record[ALIGNED_PATCH_SIZE - 5]);
+    switch (version) {
+        case PRESET_VERSION1:
+            for (uint32_t p = PFM3_PATCH_FLASH_SIZE; p < ALIGNED_PATCH_SIZE - 5; p++) {
+                if (record[p] != 0) {
+                    return false;
+                }
+            }
+            return record[ALIGNED_PATCH_SIZE - 1] == 0 && isFlashPatchValid(record);
+        case PRESET_VERSION2:
+            return isNameValid(getRecordName(record));
+        default:
+            return false;
+    }
+}
+
+const char* PatchBank::loadPatchName(const struct PFM3File *bank, int patchNumber) {
+
+    // v3 : all names come with the index
+    const struct BankIndexEntry *entry = getIndexEntry(bank, patchNumber);
+    if (entry != 0) {
+        for (int n = 0; n < 12; n++) {
+            presetName_[n] = entry->name[n];
         }
+        presetName_[12] = 0;
+        return presetName_;
     }
 
-    load(fullBankName, ALIGNED_PATCH_SIZE * patchNumber + namePosition, (void*) presetName_, 12);
+    const char *fullBankName = getFullName(bank->name);
+    uint32_t version;
+    load(fullBankName, patchNumber * ALIGNED_PATCH_SIZE + ALIGNED_PATCH_SIZE - 5, (void*) &version, 4);
+
+    load(fullBankName, ALIGNED_PATCH_SIZE * patchNumber + getNamePosition(version), (void*) presetName_, 12);
     presetName_[12] = 0;
     return presetName_;
 
@@ -142,8 +302,17 @@ void PatchBank::savePatch(const struct PFM3File *bank, int patchNumber, const st
     convertParamsToFlash(params, (struct FlashSynthParams*) storageBuffer, *arpeggiatorPartOfThePreset_ > 0);
     *(uint32_t*) (&storageBuffer[ALIGNED_PATCH_SIZE - 5]) = PRESET_CURRENT_VERSION;
 
+    // The cached record is now obsolete
+    int slot = findCachedPatch(bank, patchNumber);
+    if (slot >= 0) {
+        patchCache_[slot].patchNumber = -1;
+    }
+
     // Save patch
-    save(fullBankName, patchNumber * ALIGNED_PATCH_SIZE, storageBuffer, ALIGNED_PATCH_SIZE);
+    if (save(fullBankName, patchNumber * ALIGNED_PATCH_SIZE, storageBuffer, ALIGNED_PATCH_SIZE) == ALIGNED_PATCH_SIZE) {
+        // Update the index, or upgrade a v1 bank
+        saveIndexEntry(bank, patchNumber, getRecordName(storageBuffer), crc32(storageBuffer, ALIGNED_PATCH_SIZE));
+    }
 }
 
 void PatchBank::copyNewPreset(struct OneSynthParams *params) {
@@ -28,6 +28,24 @@ enum PRESET_VERSION {
 // Let's stick to VERSION1 : VERSION2 seems dangerous :)
 #define PRESET_CURRENT_VERSION PRESET_VERSION1
 
+#define NUMBER_OF_PATCHES_PER_BANK 128
+
+// Recently used and neighbour patches kept in RAM
+#define PATCH_CACHE_SIZE 8
+
+enum PATCH_RECORD_STATUS {
+    PATCH_RECORD_OK = 0,
+    PATCH_RECORD_UNREADABLE,
+    PATCH_RECORD_CORRUPTED
+};
+
+struct PatchCacheEntry {
+    char bankName[13];
+    // -1 when the slot is empty
+    int16_t patchNumber;
+    uint32_t lastUse;
+};
+
 class PatchBank: public PreenFMFileType {
 public:
     PatchBank();
@@ -40,6 +58,17 @@ public:
     }
     void loadPatch(const struct PFM3File *bank, int patchNumber, struct OneSynthParams *params);
     const char* loadPatchName(const struct PFM3File *bank, int patchNumber);
+    void prefetchNeighbours(const struct PFM3File *bank, int patchNumber);
+
+    uint32_t getCacheHits() {
+        return cacheHits_;
+    }
+    uint32_t getCacheMisses() {
+        return cacheMisses_;
+    }
+    uint32_t getCachePrefetches() {
+        return cachePrefetches_;
+    }
 
     bool decodeBufferAndApplyPreset(uint8_t *buffer, struct OneSynthParams *params);
     void copyNewPreset(struct OneSynthParams *params);
@@ -47,10 +76,23 @@ public:
 protected:
     const char* getFolderName();
     bool isCorrectFile(char *name, int size);
+    const char* getRecordName(char *record);
+    bool isRecordValid(char *record);
+    void fileNamesChanged();
 
 private:
+    int getNamePosition(uint32_t version);
+    int findCachedPatch(const struct PFM3File *bank, int patchNumber);
+    int getCacheSlotToReplace();
+    int fetchPatch(const struct PFM3File *bank, int patchNumber, int slot, bool userLoad);
+
     uint8_t *arpeggiatorPartOfThePreset_;
     char presetName_[13];
+    struct PatchCacheEntry patchCache_[PATCH_CACHE_SIZE];
+    uint32_t patchCacheUse_;
+    uint32_t cacheHits_;
+    uint32_t cacheMisses_;
+    uint32_t cachePrefetches_;
 };
 
 #endif /* PATCHBANK_H_ */
@@ -19,10 +19,16 @@
 
 __attribute__((section(".ram_d2b"))) char storageBuffer[PROPERTY_FILE_SIZE];
 __attribute__((section(".ram_d2b"))) static FIL file;
+__attribute__((section(".ram_d2b"))) static uint32_t crc32Table[256];
+static bool crc32TableReady = false;
 
 PreenFMFileType::PreenFMFileType() {
     isInitialized_ = false;
     numberOfFiles_ = 0;
+    index_ = 0;
+    indexNumberOfRecords_ = 0;
+    indexRecordSize_ = 0;
+    indexFile_ = 0;
     // init error file
     char empty[] = "<Empty>\0";
     for (int k = 0; k < 8; k++) {
@@ -45,6 +51,8 @@ const char* PreenFMFileType::getFileName(FILE_ENUM file) {
             return PROPERTIES_NAME;
         case MIDI_CONTROLLER_STATE:
             return MIDI_CONTROLLER_STATE_NAME;
+        case SETLIST:
+            return SETLIST_NAME;
     }
 }
 
@@ -180,7 +188,10 @@ int PreenFMFileType::initFiles() {
 
     for (int k = 0; k < numberOfFilesMax_; k++) {
         myFiles_[k].fileType = FILE_EMPTY;
+        myFiles_[k].version = BANK_LAYOUT_UNKNOWN;
     }
+    // Files are sorted again, the cached index may now point to another file
+    indexFile_ = 0;
 
     res = f_opendir(&dir, getFolderName());
     if (res == FR_OK) {
@@ -262,6 +273,7 @@ int PreenFMFileType::getFileIndex(const struct PFM3File *file) {
 
 int PreenFMFileType::renameFile(const struct PFM3File *bank, const char *newName) {
     isInitialized_ = false;
+    fileNamesChanged();
 
     // getFullName(bank->name) -> getFullName(newName)
     char fullNewBankName[40];
@@ -293,6 +305,192 @@ void PreenFMFileType::sortFiles(struct PFM3File *bankFiles, int numberOfFiles) {
     }
 }
 
+// Standard CRC32
+uint32_t PreenFMFileType::crc32(const void *data, uint32_t size) {
+    if (!crc32TableReady) {
+        // D2 ram is not reachable from static constructors, fill the table on first use
+        for (uint32_t n = 0; n < 256; n++) {
+            uint32_t c = n;
+            for (int k = 0; k < 8; k++) {
+                c = (c & 1) ? (0xEDB88320 ^ (c >> 1)) : (c >> 1);
+            }
+            crc32Table[n] = c;
+        }
+        crc32TableReady = true;
+    }
+    const uint8_t *bytes = (const uint8_t*) data;
+    uint32_t crc = 0xffffffff;
+    for (uint32_t i = 0; i < size; i++) {
+        crc = crc32Table[(crc ^ bytes[i]) & 0xff] ^ (crc >> 8);
+    }
+    return crc ^ 0xffffffff;
+}
+
+/*
+ * Read the v3 index of file in one read and keep it.
+ * Return false for v1 files, that are remembered as such so that we don't look for their index again.
+ */
+bool PreenFMFileType::readIndex(const struct PFM3File *file) {
+    if (index_ == 0) {
+        return false;
+    }
+    if (file == indexFile_) {
+        return true;
+    }
+    struct PFM3File *bank = (struct PFM3File*) file;
+    if (bank->version == BANK_LAYOUT_V1) {
+        return false;
+    }
+
+    indexFile_ = 0;
+    int indexSize = BANK_INDEX_SIZE(indexNumberOfRecords_);
+    int result = load(getFullName(bank->name), getIndexOffset(), index_, indexSize);
+    struct BankIndexHeader *header = getIndexHeader();
+    if (result != indexSize || header->magic != BANK_INDEX_MAGIC || header->version != BANK_INDEX_VERSION
+            || header->numberOfRecords != indexNumberOfRecords_ || header->recordSize != indexRecordSize_) {
+        bank->version = BANK_LAYOUT_V1;
+        return false;
+    }
+    bank->version = BANK_LAYOUT_V3;
+    indexFile_ = file;
+    return true;
+}
+
+const struct BankIndexEntry* PreenFMFileType::getIndexEntry(const struct PFM3File *file, int record) {
+    if (record < 0 || record >= indexNumberOfRecords_ || !readIndex(file)) {
+        return 0;
+    }
+    return &getIndexEntries()[record];
+}
+
+void PreenFMFileType::initIndex() {
+    struct BankIndexHeader *header = getIndexHeader();
+    header->magic = BANK_INDEX_MAGIC;
+    header->version = BANK_INDEX_VERSION;
+    header->numberOfRecords = indexNumberOfRecords_;
+    header->recordSize = indexRecordSize_;
+    header->reserved = 0;
+    indexFile_ = 0;
+}
+
+void PreenFMFileType::setIndexEntry(int record, const char *name, uint32_t crc) {
+    struct BankIndexEntry *entry = &getIndexEntries()[record];
+    for (int n = 0; n < 12; n++) {
+        entry->name[n] = name == 0 ? 0 : name[n];
+    }
+    entry->offset = record * indexRecordSize_;
+    entry->crc = crc;
+}
+
+/*
+ * Called after a record has been saved.
+ * A v3 file only needs its entry to be updated, a v1 file is upgraded to v3.
+ */
+bool PreenFMFileType::saveIndexEntry(const struct PFM3File *file, int record, const char *name, uint32_t crc) {
+    if (index_ == 0) {
+        return false;
+    }
+    if (!readIndex(file)) {
+        return rebuildIndex(file);
+    }
+    setIndexEntry(record, name, crc);
+    int entryPosition = getIndexOffset() + sizeof(struct BankIndexHeader) + record * sizeof(struct BankIndexEntry);
+    if (save(getFullName(file->name), entryPosition, &getIndexEntries()[record], sizeof(struct BankIndexEntry)) == 0) {
+        indexFile_ = 0;
+        return false;
+    }
+    return true;
+}
+
+/*
+ * A record doesn't match the CRC of its index entry.
+ * Older firmwares save into v3 banks without updating the index, they save well formed records.
+ * A well formed record is accepted and when updateIndex is set its entry is fixed (name and CRC).
+ * Anything else is corrupted : the caller refuses it and shows "##".
+ * updateIndex is only set for loads the user asked for, nothing is written when prefetching.
+ */
+bool PreenFMFileType::acceptStaleRecord(const struct PFM3File *file, int record, char *recordData, bool updateIndex) {
+    if (!isRecordValid(recordData)) {
+        return false;
+    }
+    if (updateIndex) {
+        // The index of file is the one in memory : only the entry is written, storageBuffer is not used
+        saveIndexEntry(file, record, getRecordName(recordData), crc32(recordData, indexRecordSize_));
+    }
+    return true;
+}
+
+/*
+ * 12 chars, printable up to the first 0
+ */
+bool PreenFMFileType::isNameValid(const char *name) {
+    for (int n = 0; n < 12 && name[n] != 0; n++) {
+        if (name[n] < 32 || name[n] > 126) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*
+ * A FlashSynthParams as convertParamsToFlash saves it :
+ * all parameters up to the step sequencer steps are finite floats, the name is printable.
+ */
+bool PreenFMFileType::isFlashPatchValid(const char *record) {
+    const struct FlashSynthParams *flashMemory = (const struct FlashSynthParams*) record;
+    const uint32_t *floatBits = (const uint32_t*) record;
+    uint32_t numberOfFloats = (uint32_t) ((const char*) &flashMemory->lfoSteps1 - record) / sizeof(float);
+    for (uint32_t f = 0; f < numberOfFloats; f++) {
+        // Exponent all ones : infinite or NaN
+        if ((floatBits[f] & 0x7f800000) == 0x7f800000) {
+            return false;
+        }
+    }
+    return isNameValid(flashMemory->presetName);
+}
+
+/*
+ * Upgrade path : read all records in one pass and append the v3 index.
+ * storageBuffer is used for the records.
+ */
+bool PreenFMFileType::rebuildIndex(const struct PFM3File *file) {
+    if (index_ == 0 || indexRecordSize_ > PROPERTY_FILE_SIZE) {
+        return false;
+    }
+    struct PFM3File *bank = (struct PFM3File*) file;
+    FRESULT fatFSResult = f_open(&::file, getFullName(bank->name), FA_READ | FA_WRITE);
+    if (fatFSResult != FR_OK) {
+        return false;
+    }
+
+    initIndex();
+    bool indexOK = true;
+    for (int r = 0; r < indexNumberOfRecords_ && indexOK; r++) {
+        UINT byteRead;
+        fatFSResult = f_read(&::file, storageBuffer, indexRecordSize_, &byteRead);
+        if (fatFSResult != FR_OK || byteRead != indexRecordSize_) {
+            indexOK = false;
+        } else {
+            setIndexEntry(r, getRecordName(storageBuffer), crc32(storageBuffer, indexRecordSize_));
+        }
+    }
+
+    if (indexOK) {
+        UINT byteWritten;
+        uint32_t indexSize = BANK_INDEX_SIZE(indexNumberOfRecords_);
+        f_lseek(&::file, getIndexOffset());
+        fatFSResult = f_write(&::file, index_, indexSize, &byteWritten);
+        indexOK = (fatFSResult == FR_OK && byteWritten == indexSize);
+    }
+    if (f_close(&::file) != FR_OK) {
+        indexOK = false;
+    }
+
+    bank->version = indexOK ? BANK_LAYOUT_V3 : BANK_LAYOUT_V1;
+    indexFile_ = indexOK ? file : 0;
+    return indexOK;
+}
+
 /*******************************************************
  *  engine2.pfm3Version : Set the version we save.
  *  Used by convertFlashToParams to make sure what we're reading from the SD card
@@ -625,10 +823,12 @@ const struct PFM3File* PreenFMFileType::addEmptyFile(const char *fileName) {
         return 0;
     }
     myFiles_[k].fileType = FILE_OK;
+    myFiles_[k].version = BANK_LAYOUT_UNKNOWN;
     for (int n = 0; n < 12; n++) {
         myFiles_[k].name[n] = fileName[n];
     }
     isInitialized_ = false;
+    fileNamesChanged();
     return &myFiles_[k];
 }
 
@@ -29,13 +29,15 @@ enum FILE_ENUM {
     PROPERTIES,
     FIRMWARE,
     DEFAULT_SEQUENCE,
-    MIDI_CONTROLLER_STATE
+    MIDI_CONTROLLER_STATE,
+    SETLIST
 };
 
 #define DEFAULT_MIXER_NAME       "0:/pfm3/mix.dfl"
 #define DEFAULT_SEQUENCE_NAME    "0:/pfm3/seq.dfl"
 #define PROPERTIES_NAME          "0:/pfm3/Settings.txt"
 #define MIDI_CONTROLLER_STATE_NAME "0:/pfm3/MidiCtl1.bin"
+#define SETLIST_NAME             "0:/pfm3/SetList.txt"
 
 #define USERWAVEFORM_FILENAME_TXT            "0:/pfm3/waveform/usr#.txt"
 #define USERWAVEFORM_FILENAME_BIN            "0:/pfm3/waveform/usr#.bin"
@@ -76,9 +78,39 @@ enum FILE_ENUM {
 struct PFM3File {
     char name[13];
     FileType fileType;
+    // BANK_LAYOUT, known after the first index read
     uint8_t version;
 };
 
+/*
+ * Bank layout v3 : records stay where v1 put them and an index is appended after the last one.
+ * The index gives every name and every record CRC in one read, older firmwares ignore it.
+ */
+#define BANK_INDEX_MAGIC 0x33494650 // "PFI3"
+#define BANK_INDEX_VERSION 3
+
+enum BANK_LAYOUT {
+    BANK_LAYOUT_UNKNOWN = 0,
+    BANK_LAYOUT_V1,
+    BANK_LAYOUT_V3
+};
+
+struct BankIndexHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t numberOfRecords;
+    uint32_t recordSize;
+    uint32_t reserved;
+};
+
+struct BankIndexEntry {
+    char name[12];
+    uint32_t offset;
+    uint32_t crc;
+};
+
+#define BANK_INDEX_SIZE(records) (sizeof(struct BankIndexHeader) + sizeof(struct BankIndexEntry) * (records))
+
 // Storage maping of the parameters
 struct FlashSynthParams {
     struct Engine1Params engine1;
@@ -176,6 +208,12 @@ public:
     int renameFile(const struct PFM3File *bank, const char *newName);
     bool nameExists(const char *bankName);
     const struct PFM3File* addEmptyFile(const char *fileName);
+    // Read the folder now instead of on first access
+    void prepareFiles() {
+        if (!isInitialized_) {
+            initFiles();
+        }
+    }
 
 protected:
     virtual const char* getFolderName() = 0;
@@ -201,6 +239,39 @@ protected:
     void swapFiles(struct PFM3File *bankFiles, int i, int j);
     void sortFiles(struct PFM3File *bankFiles, int numberOfFiles);
 
+    uint32_t crc32(const void *data, uint32_t size);
+
+    // v3 index
+    struct BankIndexHeader* getIndexHeader() {
+        return (struct BankIndexHeader*) index_;
+    }
+    struct BankIndexEntry* getIndexEntries() {
+        return (struct BankIndexEntry*) (index_ + sizeof(struct BankIndexHeader));
+    }
+    uint32_t getIndexOffset() {
+        return indexNumberOfRecords_ * indexRecordSize_;
+    }
+    bool readIndex(const struct PFM3File *file);
+    const struct BankIndexEntry* getIndexEntry(const struct PFM3File *file, int record);
+    void setIndexEntry(int record, const char *name, uint32_t crc);
+    void initIndex();
+    bool saveIndexEntry(const struct PFM3File *file, int record, const char *name, uint32_t crc);
+    bool rebuildIndex(const struct PFM3File *file);
+    bool acceptStaleRecord(const struct PFM3File *file, int record, char *recordData, bool updateIndex);
+    // Name of a record, used to build the index
+    virtual const char* getRecordName(char *record) {
+        return 0;
+    }
+    // Structure check of a record that doesn't match its index entry
+    virtual bool isRecordValid(char *record) {
+        return false;
+    }
+    bool isNameValid(const char *name);
+    bool isFlashPatchValid(const char *record);
+    // A file was renamed or created : what is kept by file name may belong to another file now
+    virtual void fileNamesChanged() {
+    }
+
     void convertParamsToFlash(const struct OneSynthParams *params, struct FlashSynthParams *memory, bool saveArp);
     void convertFlashToParams(const struct FlashSynthParams *memory, struct OneSynthParams *params, bool loadArp);
 
@@ -214,6 +285,11 @@ protected:
     FileSystemUtils *fsu_;
     bool isInitialized_;
 
+    uint8_t *index_;
+    uint16_t indexNumberOfRecords_;
+    uint32_t indexRecordSize_;
+    const struct PFM3File *indexFile_;
+
     virtual bool isReadOnly(struct PFM3File *file) {
         return false;
     }
@@ -0,0 +1,109 @@
+/*
+ * Copyright 2020 Xavier Hosxe
+ *
+ * Author: Xavier Hosxe (xavier <dot> hosxe (at) g m a i l <dot> com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "SetListFile.h"
+#include "MixerBank.h"
+
+extern char lineBuffer[1024];
+
+__attribute__((section(".ram_d1"))) static char setListRecordsD1[SETLIST_NUMBER_OF_SONGS_D1][FULL_MIXER_SIZE];
+__attribute__((section(".ram_d3"))) static char setListRecordsD3[SETLIST_NUMBER_OF_SONGS_D3][FULL_MIXER_SIZE];
+
+SetListFile::SetListFile() {
+    numberOfFilesMax_ = 0;
+    numberOfSongs_ = 0;
+    mixerBank_ = 0;
+}
+
+SetListFile::~SetListFile() {
+}
+
+const char* SetListFile::getFolderName() {
+    return PREENFM_DIR;
+}
+
+char* SetListFile::getSongRecord(int song) {
+    if (song < SETLIST_NUMBER_OF_SONGS_D1) {
+        return setListRecordsD1[song];
+    }
+    return setListRecordsD3[song - SETLIST_NUMBER_OF_SONGS_D1];
+}
+
+/*
+ * Read the set list and all its mixers.
+ * Return the number of songs, invalid songs are kept so that program numbers match the lines.
+ */
+int SetListFile::loadSetList() {
+    char *line = lineBuffer;
+    char *setListText = storageBuffer;
+
+    numberOfSongs_ = 0;
+    int size = checkSize(SETLIST);
+    if (size >= PROPERTY_FILE_SIZE || size <= 0 || mixerBank_ == 0) {
+        return 0;
+    }
+    setListText[size] = 0;
+    if (load(SETLIST, 0, setListText, size) != size) {
+        return 0;
+    }
+
+    int loop = 0;
+    char *readSetList = setListText;
+    while (loop != -1 && (readSetList - setListText) < size && numberOfSongs_ < SETLIST_MAX_SONGS) {
+        loop = fsu_->getLine(readSetList, line);
+        if (line[0] != '#' && line[0] != 0) {
+            songValid_[numberOfSongs_] = preloadSong(numberOfSongs_, line);
+            numberOfSongs_++;
+        }
+        readSetList += loop;
+    }
+    return numberOfSongs_;
+}
+
+bool SetListFile::preloadSong(int song, char *line) {
+    char bankName[21];
+    char value[21];
+
+    int equalPos = fsu_->getPositionOfEqual(line);
+    if (equalPos == -1) {
+        return false;
+    }
+    fsu_->getKey(line, bankName);
+    fsu_->getValue(line + equalPos + 1, value);
+    int mixerNumber = fsu_->toInt(value) - 1;
+    if (mixerNumber < 0 || mixerNumber >= NUMBER_OF_MIXERS_PER_BANK) {
+        return false;
+    }
+
+    int bankIndex = mixerBank_->getFileIndex(bankName);
+    if (bankIndex == -1) {
+        return false;
+    }
+    return mixerBank_->readMixerRecord(mixerBank_->getFile(bankIndex), mixerNumber, getSongRecord(song));
+}
+
+/*
+ * Restore a song mixer from RAM, only Scala scales still come from the SD card
+ */
+bool SetListFile::loadSong(int song) {
+    if (!isSongValid(song)) {
+        return false;
+    }
+    mixerBank_->applyMixerRecord(getSongRecord(song), FULL_MIXER_SIZE);
+    return true;
+}
@@ -0,0 +1,70 @@
+/*
+ * Copyright 2020 Xavier Hosxe
+ *
+ * Author: Xavier Hosxe (xavier <dot> hosxe (at) g m a i l <dot> com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SETLISTFILE_H_
+#define SETLISTFILE_H_
+
+#include "PreenFMFileType.h"
+
+class MixerBank;
+
+// Mixers kept in RAM : 4 in RAM_D1, 2 in RAM_D3
+#define SETLIST_NUMBER_OF_SONGS_D1 4
+#define SETLIST_NUMBER_OF_SONGS_D3 2
+#define SETLIST_MAX_SONGS (SETLIST_NUMBER_OF_SONGS_D1 + SETLIST_NUMBER_OF_SONGS_D3)
+
+/*
+ * SetList.txt : one song per line, "mixer bank file = mixer number (1-32)"
+ *   Live.mix=3
+ *   Live.mix=12
+ * All mixers are read and checked when the set list is loaded,
+ * a song change then restores the mixer from RAM.
+ */
+class SetListFile: public PreenFMFileType {
+public:
+    SetListFile();
+    virtual ~SetListFile();
+
+    void setMixerBank(MixerBank *mixerBank) {
+        mixerBank_ = mixerBank;
+    }
+    int loadSetList();
+    bool loadSong(int song);
+
+    int getNumberOfSongs() {
+        return numberOfSongs_;
+    }
+    bool isSongValid(int song) {
+        return song >= 0 && song < numberOfSongs_ && songValid_[song];
+    }
+
+protected:
+    const char* getFolderName();
+    bool isCorrectFile(char *name, int size) {
+        return true;
+    }
+
+private:
+    char* getSongRecord(int song);
+    bool preloadSong(int song, char *line);
+
+    MixerBank *mixerBank_;
+    int numberOfSongs_;
+    bool songValid_[SETLIST_MAX_SONGS];
+};
+
+#endif /* SETLISTFILE_H_ */
@@ -32,4 +32,6 @@ void Storage::init(struct OneSynthParams*timbre1, struct OneSynthParams*timbre2,
     patchBank.setFileSystemUtils(&fsu);
     dx7SysexFile.setFileSystemUtils(&fsu);
     userWaveForm.setFileSystemUtils(&fsu);
+    setListFile.setFileSystemUtils(&fsu);
+    setListFile.setMixerBank(&mixerBank);
 }
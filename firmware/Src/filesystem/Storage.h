@@ -31,6 +31,7 @@
 #include "UserEnvCurve.h"
 #include "PPMImage.h"
 #include "SequenceBank.h"
+#include "SetListFile.h"
 
 
 
@@ -57,6 +58,7 @@ public:
     PPMImage* getPPMImage() { return &ppmImage; };
 #endif
     SequenceBank* getSequenceBank() { return &sequenceBank; };
+    SetListFile* getSetListFile() { return &setListFile; };
 #else
 #endif
 
@@ -74,6 +76,7 @@ private:
     PPMImage ppmImage;
 #endif
     SequenceBank sequenceBank;
+    SetListFile setListFile;
 #else
 #endif
 };
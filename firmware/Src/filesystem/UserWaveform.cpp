@@ -31,11 +31,13 @@ extern char *oscShapeNames[];
 extern struct WaveTable waveTables[];
 
 #include "UserWaveform.h"
+#include "Osc.h"
 
 UserWaveform::UserWaveform() {
     for (int k=0; k<6; k++) {
         userWaveFormNames[k][4] = 0;
     }
+    waveformsToConvert = 0;
 }
 
 UserWaveform::~UserWaveform() {
@@ -46,10 +48,14 @@ const char* UserWaveform::getFolderName() {
 }
 
 
+/*
+ * Boot : only .bin waveforms are loaded.
+ * .txt waveforms stay silent until convertNextUserWaveform has converted them.
+ */
 void UserWaveform::loadUserWaveforms() {
     char fileName[30];
 
-
+    waveformsToConvert = 0;
     for (int f = 0; f < 6; f++) {
         // Check if bin exists
 
@@ -61,46 +67,73 @@ void UserWaveform::loadUserWaveforms() {
         if (sizeBin != -1) {
             loadUserWaveformFromBin(f, fileName);
         } else {
+            // Neither Bin nor txt => Silence
+            for (int s = 0; s < 1024; s++) {
+                userWaveform[f][s] = 0.0f;
+            }
+
             fsu_->copy_string(fileName, USERWAVEFORM_FILENAME_TXT);
             fileName[20] = (char)('1' + f);
-
-            int sizeTxt = checkSize(fileName);
-            if (sizeTxt == -1) {
-                // Does not exist. Neither Bin nor txt => Silence
-                for (int s = 0; s < 1024; s++) {
-                    userWaveform[f][s] = 0.0f;
-                }
-            } else {
-                numberOfSample = -1;
-                userWaveFormNames[f][0] = 0;
-                loadUserWaveformFromTxt(f, fileName, sizeTxt);
-
-                if (numberOfSample > 0) {
-                    if (numberOfSample > 512 && numberOfSample < 1024) {
-                        interpolate(userWaveform[f], numberOfSample, 1024);
-                    } else if (numberOfSample > 256 && numberOfSample < 512) {
-                        interpolate(userWaveform[f], numberOfSample, 512);
-                    } else if (numberOfSample > 128 && numberOfSample < 256) {
-                        interpolate(userWaveform[f], numberOfSample, 256);
-                    } else if (numberOfSample > 64 && numberOfSample < 128) {
-                        interpolate(userWaveform[f], numberOfSample, 128);
-                    } else if (numberOfSample > 32 && numberOfSample < 64) {
-                        interpolate(userWaveform[f], numberOfSample, 64);
-                    }
-
-                    normalize(userWaveform[f], numberOfSample);
-
-                    fsu_->copy_string(fileName, USERWAVEFORM_FILENAME_BIN);
-                    fileName[20] = (char)('1' + f);
-                    saveUserWaveformToBin(f, fileName);
-                    // Reload from Bin
-                    loadUserWaveformFromBin(f, fileName);
-                }
+            if (checkSize(fileName) != -1) {
+                waveformsToConvert |= (1 << f);
             }
         }
     }
 }
 
+/*
+ * Called from the main loop once audio runs.
+ * Convert one .txt waveform, return false when there is nothing left to convert.
+ */
+bool UserWaveform::convertNextUserWaveform() {
+    for (int f = 0; f < 6; f++) {
+        if ((waveformsToConvert & (1 << f)) != 0) {
+            waveformsToConvert &= ~(1 << f);
+            convertUserWaveform(f);
+            return true;
+        }
+    }
+    return false;
+}
+
+void UserWaveform::convertUserWaveform(int f) {
+    char fileName[30];
+
+    fsu_->copy_string(fileName, USERWAVEFORM_FILENAME_TXT);
+    fileName[20] = (char)('1' + f);
+
+    int sizeTxt = checkSize(fileName);
+    if (sizeTxt == -1) {
+        return;
+    }
+
+    numberOfSample = -1;
+    userWaveFormNames[f][0] = 0;
+    loadUserWaveformFromTxt(f, fileName, sizeTxt);
+
+    if (numberOfSample > 0) {
+        if (numberOfSample > 512 && numberOfSample < 1024) {
+            interpolate(userWaveform[f], numberOfSample, 1024);
+        } else if (numberOfSample > 256 && numberOfSample < 512) {
+            interpolate(userWaveform[f], numberOfSample, 512);
+        } else if (numberOfSample > 128 && numberOfSample < 256) {
+            interpolate(userWaveform[f], numberOfSample, 256);
+        } else if (numberOfSample > 64 && numberOfSample < 128) {
+            interpolate(userWaveform[f], numberOfSample, 128);
+        } else if (numberOfSample > 32 && numberOfSample < 64) {
+            interpolate(userWaveform[f], numberOfSample, 64);
+        }
+
+        normalize(userWaveform[f], numberOfSample);
+
+        fsu_->copy_string(fileName, USERWAVEFORM_FILENAME_BIN);
+        fileName[20] = (char)('1' + f);
+        saveUserWaveformToBin(f, fileName);
+        // Reload from Bin
+        loadUserWaveformFromBin(f, fileName);
+    }
+}
+
 void UserWaveform::loadUserWaveformFromTxt(int f, const char* fileName, int size) {
     int readIndex = 0;
     floatRead = 0;
@@ -177,7 +210,7 @@ void UserWaveform::loadUserWaveformFromBin(int f, const char* fileName) {
 
     load(fileName, 4, &numberOfSample, 4);
     waveTables[f + 8].max = (numberOfSample  -1);
-    waveTables[f + 8].precomputedValue = (waveTables[f + 8].max + 1) * waveTables[f + 8].useFreq * PREENFM_FREQUENCY_INVERSED;
+    Osc::initWaveTable(&waveTables[f + 8]);
 
     int sampleSize = numberOfSample * 4;
     if (sampleSize <= 512) {
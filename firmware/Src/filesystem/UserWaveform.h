@@ -28,12 +28,14 @@ public:
     UserWaveform();
     virtual ~UserWaveform();
     void loadUserWaveforms();
+    bool convertNextUserWaveform();
 
 protected:
     const char* getFolderName();
     bool isCorrectFile(char *name, int size) { return true; }
 
 private:
+    void convertUserWaveform(int f);
     void loadUserWaveformFromTxt(int f, const char* fileName, int size);
     int fillUserWaveFormFromTxt(int f, char* buffer, int filled, bool last);
     void loadUserWaveformFromBin(int f, const char* fileName);
@@ -45,6 +47,8 @@ private:
     int numberOfSample;
     char userWaveFormNames[6][5];
     int floatRead;
+    // One bit per waveform only available as .txt
+    uint8_t waveformsToConvert;
 };
 
 #endif /* USERWAVEFORMS_H_ */
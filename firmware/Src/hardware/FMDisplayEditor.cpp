@@ -1077,6 +1077,10 @@ const char *fx2Name[] = {
     "Diff", /* 10 */
     "Gra1", /* 11 */
     "Gra2", /* 12 */
+    "LDlc", /* 13 */
+    "LPng", /* 14 */
+    "LGr1", /* 15 */
+    "LGr2", /* 16 */
 };
 
 
@@ -1172,6 +1176,22 @@ struct FilterRowDisplay fx2RowDisplay[FILTER2_LAST] = {
         "Size",
         "Sprd",
         "Mix " },
+    {
+        "Tune",
+        "Sprd",
+        "Mix " },
+    {
+        "Time",
+        "Feed",
+        "Mix " },
+    {
+        "Time",
+        "Feed",
+        "Mix " },
+    {
+        "Size",
+        "Sprd",
+        "Mix " },
     {
         "Tune",
         "Sprd",
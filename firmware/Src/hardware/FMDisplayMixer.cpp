@@ -34,6 +34,7 @@ const char* enableNames[] = { "Off", "On" };
 const char* levelMeterWhere[] = { "Off", "Mix", "All" };
 const char* scalaMapNames[] = { "Keybrd", "Continu" };
 const char* mpeOptions[] = { "No", "MPE48", "MPE36", "MPE24", "MPE12", "MPE0"};
+const char* voicePriorityNames[] = { "Low", "Normal", "High" };
 const char *reverbPresets[] = {
     "XSmal1",
     "XSmal2",
@@ -108,10 +109,21 @@ const struct Pfm3MixerButtonState voiceButtonState = {
         {0, 16, 17, DISPLAY_TYPE_INT, nullNames}
 };
 
+// Voices above "Number of voices" are borrowed from the other instruments when available
+const struct Pfm3MixerButtonState maxVoiceButtonState = {
+      "Max voices", MIXER_VALUE_MAX_NUMBER_OF_VOICES,
+        {0, 16, 17, DISPLAY_TYPE_INT, nullNames}
+};
+
+const struct Pfm3MixerButtonState voicePriorityButtonState = {
+      "Voice priority", MIXER_VALUE_VOICE_POOL_PRIORITY,
+        {0, 2, 3, DISPLAY_TYPE_STRINGS, voicePriorityNames}
+};
+
 const struct Pfm3MixerButton voiceButton = {
   "Voices",
-  2,
-  { &voiceButtonState, &compButtonState }
+  4,
+  { &voiceButtonState, &maxVoiceButtonState, &voicePriorityButtonState, &compButtonState }
 };
 
 
@@ -296,6 +308,12 @@ void* FMDisplayMixer::getValuePointer(int valueType, int encoder) {
         case MIXER_VALUE_NUMBER_OF_VOICES:
             valueP = (void*) &synthState_->mixerState.instrumentState_[encoder].numberOfVoices;
             break;
+        case MIXER_VALUE_MAX_NUMBER_OF_VOICES:
+            valueP = (void*) &synthState_->mixerState.instrumentState_[encoder].maxNumberOfVoices;
+            break;
+        case MIXER_VALUE_VOICE_POOL_PRIORITY:
+            valueP = (void*) &synthState_->mixerState.instrumentState_[encoder].voicePoolPriority;
+            break;
         case MIXER_VALUE_MIDI_CHANNEL:
             valueP = (void*) &synthState_->mixerState.instrumentState_[encoder].midiChannel;
             break;
@@ -519,6 +537,11 @@ void FMDisplayMixer::displayMixerValue(int timbre) {
                         tft_->setCharColor(COLOR_RED);
                     }
                 }
+            } else if (unlikely(mixerValueType == MIXER_VALUE_MAX_NUMBER_OF_VOICES)) {
+                // Nothing to borrow
+                if (*((uint8_t*) valueP) <= synthState_->mixerState.instrumentState_[timbre].numberOfVoices) {
+                    tft_->setCharColor(COLOR_DARK_GRAY);
+                }
             }
 
             displayMixerValueInteger(timbre, 18, (*((int8_t*) valueP)));
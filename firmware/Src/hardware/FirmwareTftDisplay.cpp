@@ -47,7 +47,7 @@ FirmwareTftDisplay::~FirmwareTftDisplay() {
 
 
 void FirmwareTftDisplay::clearActions() {
-    tftActions.clear();
+    TftDisplay::clearActions();
     envInQueue = 0;
     lfoInQueue = 0;
     operatorInQueue = 0;
@@ -141,7 +141,7 @@ void FirmwareTftDisplay::oscilloBgActionClear() {
         newAction.param1 = 255;
         newAction.param3 = 0;
         newAction.actionType = TFT_DRAW_OSCILLO_BACKGROUND_WAVEFORM;
-        tftActions.insert(newAction);
+        insertAction(newAction);
         oscilloIsClean = true;
     }
 }
@@ -158,7 +158,7 @@ void FirmwareTftDisplay::oscilloBgActionOperatorShape(int wfNumber) {
     newAction.actionType = TFT_DRAW_OSCILLO_BACKGROUND_WAVEFORM;
     newAction.param1 = wfNumber;
     newAction.param3 = 0;
-    tftActions.insert(newAction);
+    insertAction(newAction);
 
     oscilloIsClean = false;
 }
@@ -175,7 +175,7 @@ void FirmwareTftDisplay::oscilloBgActionLfo() {
     newAction.actionType = TFT_DRAW_OSCILLO_BACKGROUND_WAVEFORM;
     newAction.param1 = TFT_DRAW_LFO;
     newAction.param3 = 0;
-    tftActions.insert(newAction);
+    insertAction(newAction);
 
     oscilloIsClean = false;
 }
@@ -192,7 +192,7 @@ void FirmwareTftDisplay::oscilloBgActionEnvelope() {
     newAction.actionType = TFT_DRAW_OSCILLO_BACKGROUND_WAVEFORM;
     newAction.param1 = TFT_DRAW_ENVELOPPE;
     newAction.param3 = 0;
-    tftActions.insert(newAction);
+    insertAction(newAction);
 
     oscilloIsClean = false;
 }
@@ -38,7 +38,7 @@ struct WaveFormExt {
 
 
 enum {
-    TFT_DRAW_OSCILLO_BACKGROUND_WAVEFORM = TFT_STANDARD_LAST_ACTION
+    TFT_DRAW_OSCILLO_BACKGROUND_WAVEFORM = TFT_STANDARD_LAST_ACTION + 1
 };
 
 
@@ -33,6 +33,7 @@ const char* usbMidiText[] = { "Off", "In", "In/Out" };
 const char* version[] = { PFM3_FIRMWARE_VERSION };
 const char* tftAutoReinit [] = { "Off", "Auto" };
 const char* reverbParam[] = { "Hide", "Show" };
+const char* oscilloTimebase[] = { "Auto", "3ms", "7ms", "13ms", "27ms" };
 
 
 
@@ -437,6 +438,12 @@ const struct MidiConfig midiConfig[]  = {
                 2,
                 reverbParam
         },
+        {
+                "Scope timebase",
+                "scopetimebase",
+                5,
+                oscilloTimebase
+        },
         {
                 "Firmware Version",
                 "",
@@ -36,6 +36,7 @@ enum {
     MIDICONFIG_ENCODER_PUSH,
     MIDICONFIG_TFT_BACKLIGHT,
 	MIDICONFIG_REVERB_PARAMS,
+    MIDICONFIG_OSCILLO_TIMEBASE,
     MIDICONFIG_SIZE
 };
 
@@ -122,9 +122,7 @@ void MidiDecoder::newByte(unsigned char byte) {
         switch (currentEventState.eventState) {
         case MIDI_EVENT_WAITING:
             if (unlikely(byte >= 0x80)) {
-                // Running status is cleared later in newMEssageType() if byte >= 0xF0
-                this->runningStatus = byte;
-                newMessageType(byte);
+                newStatusByte(byte);
             } else {
                 // midi source use running status...
                 if (this->runningStatus > 0) {
@@ -134,9 +132,19 @@ void MidiDecoder::newByte(unsigned char byte) {
             }
             break;
         case MIDI_EVENT_IN_PROGRESS:
-            newMessageData(byte);
+            if (unlikely(byte >= 0x80)) {
+                // The unfinished message is dropped, a status byte is never a value
+                newStatusByte(byte);
+            } else {
+                newMessageData(byte);
+            }
             break;
         case MIDI_EVENT_SYSEX:
+            if (unlikely(byte >= 0x80 && byte != MIDI_SYSEX_END)) {
+                // Unterminated sysex : dropped
+                newStatusByte(byte);
+                break;
+            }
             if (likely(currentEventState.index < SYSEX_BUFFER_SIZE)) {
                 sysexBuffer[currentEventState.index++] = byte;
             }
@@ -155,6 +163,14 @@ void MidiDecoder::newByte(unsigned char byte) {
     }
 }
 
+void MidiDecoder::newStatusByte(unsigned char byte) {
+    currentEventState.eventState = MIDI_EVENT_WAITING;
+    currentEventState.index = 0;
+    // Running status is cleared later in newMEssageType() if byte >= 0xF0
+    this->runningStatus = byte;
+    newMessageType(byte);
+}
+
 void MidiDecoder::newMessageData(unsigned char byte) {
     currentEvent.value[currentEventState.index++] = byte;
     if (currentEventState.index == currentEventState.numberOfBytes) {
@@ -919,9 +935,9 @@ void MidiDecoder::decodeNrpn(int timbre) {
         int row = memoryIndex >> 2;
         int encoder = memoryIndex % 4;
 
-        struct ParameterDisplay* param = &(allParameterRows.row[row]->params[encoder]);
-
         if (row < NUMBER_OF_ROWS_FOR_EDITOR) {
+            // allParameterRows.row has NUMBER_OF_ROWS_FOR_EDITOR rows : not read before the check
+            struct ParameterDisplay* param = &(allParameterRows.row[row]->params[encoder]);
             if (param->displayType == DISPLAY_TYPE_FLOAT || param->displayType == DISPLAY_TYPE_FLOAT_OSC_FREQUENCY
                     || param->displayType == DISPLAY_TYPE_FLOAT_LFO_FREQUENCY || param->displayType == DISPLAY_TYPE_LFO_KSYN) {
                 value = value * .01f + param->minValue;
@@ -1342,7 +1358,8 @@ int MidiDecoder::getMemoryIndexFromMidi(int index) {
 
 
 uint8_t MidiDecoder::analyseSysexBuffer(uint8_t *sysexBuffer, uint16_t size) {
-    if (sysexBuffer[0] == 0x7d) {
+    // 0x7d, instrument, volume, MIDI_SYSEX_END
+    if (size == 4 && sysexBuffer[0] == 0x7d && sysexBuffer[2] < 0x80) {
         switch (sysexBuffer[1]) {
         case 1:
         case 2:
@@ -1366,6 +1383,13 @@ void MidiDecoder::processAsyncActions() {
         AsyncAction asyncAction = asyncActions.remove();
         switch (asyncAction.action.actionType) {
             case LOAD_PRESET:
+                // Bank 5, set list : the song is the whole mixer, load it once for all the timbres of the channel
+                if (asyncAction.action.param1 == 5) {
+                    if (asyncAction.action.timbre != 0) {
+                        synth->loadPreenFMPatchFromMidi(0, asyncAction.action.param1, asyncAction.action.param2, asyncAction.action.param3);
+                    }
+                    break;
+                }
                 for (int t = 0; t < NUMBER_OF_TIMBRES; t++) {
                     if (((1 << t) & asyncAction.action.timbre)  > 0) {
                         synth->loadPreenFMPatchFromMidi(t, asyncAction.action.param1, asyncAction.action.param2, asyncAction.action.param3);
@@ -185,6 +185,7 @@ public:
     }
 
     void newByte(unsigned char byte);
+    void newStatusByte(unsigned char byte);
     void newMessageType(unsigned char byte);
     void newMessageData(unsigned char byte);
     void midiEventReceived(MidiEvent& midiEvent);
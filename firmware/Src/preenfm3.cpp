@@ -17,6 +17,9 @@
 
 #include "stm32h7xx_hal.h"
 #include "fatfs.h"
+extern "C" {
+#include "usbd_midi.h"
+}
 #include "Synth.h"
 #include "SynthState.h"
 #include "MidiDecoder.h"
@@ -39,6 +42,7 @@ extern SAI_HandleTypeDef hsai_BlockA2;
 extern RingBuffer<uint8_t, 64> usartBufferOut;
 extern RingBuffer<uint8_t, 64> usartBufferIn;
 extern TIM_HandleTypeDef htim1;
+extern USBD_HandleTypeDef hUsbDeviceFS;
 
 #define RAM_D1_SECTION __attribute__((section(".ram_d1")))
 #define RAM_D2_SECTION __attribute__((section(".ram_d2")))
@@ -64,12 +68,24 @@ uint8_t saturatedOutputMem = 0;
 bool saturatedOutputDisplayed = 0;
 int ili9341NumberOfErrorsOnScreen = 0;
 int ili9341NumberOfErrors = 0;
-
-RingBuffer<uint8_t, 64> usbMidi;
-
-RAM_D2_SECTION int32_t waveform1[64 * 2];
-RAM_D2_SECTION int32_t waveform2[64 * 2];
-RAM_D2_SECTION int32_t waveform3[64 * 2];
+uint32_t tftDroppedActionsOnScreen = 0;
+
+// A 64 bytes USB MIDI packet holds up to 16 events of 3 bytes
+#define USB_MIDI_PACKET_MAX_BYTES 48
+// Full speed bulk : up to 19 packets per ms, less than 1024 bytes between two audio blocks
+#define USB_MIDI_BUFFER_SIZE 1024
+// Decoded per audio block, the rest waits in usbMidi
+#define USB_MIDI_BYTES_PER_BLOCK 256
+RingBuffer<uint8_t, USB_MIDI_BUFFER_SIZE> usbMidi;
+// Dropped : lost, usbMidi was full. Late : the host was NAKed until usbMidi had room.
+uint32_t usbMidiDroppedPackets = 0;
+uint32_t usbMidiLatePackets = 0;
+uint32_t usbMidiDroppedPacketsOnScreen = 0xffffffff;
+uint32_t usbMidiLatePacketsOnScreen = 0xffffffff;
+
+RAM_D2_SECTION int32_t waveform1[BLOCK_SIZE * 4];
+RAM_D2_SECTION int32_t waveform2[BLOCK_SIZE * 4];
+RAM_D2_SECTION int32_t waveform3[BLOCK_SIZE * 4];
 
 #ifdef __cplusplus
 extern "C" {
@@ -79,6 +95,7 @@ extern "C" {
 volatile bool readyForTFT = false;
 uint32_t tftCpt = 0;
 uint32_t oscilloMillis = 1;
+uint32_t patchPrefetchMillis = 0;
 uint32_t cpuUsageMillis = 1;
 uint32_t saturatedOutputMillis = 0;
 
@@ -88,29 +105,86 @@ float *timbreSamples;
 int previousCpuUsage = 101;
 uint8_t previousNumberOfPlayingVoices = 255;
 
+// Boot profiler : each phase is measured with the DWT cycle counter
+#define BOOT_PROFILE_MAX_PHASES 16
+struct BootPhase {
+    const char *name;
+    uint32_t cycles;
+};
+struct BootPhase bootPhases[BOOT_PROFILE_MAX_PHASES];
+uint8_t numberOfBootPhases = 0;
+uint32_t bootPhaseStartCycles;
+uint32_t bootProfileClearMillis = 0;
+
+// Boot work left to the main loop once audio runs
+enum {
+    BOOT_BACKGROUND_WAVEFORMS = 0,
+    BOOT_BACKGROUND_SETLIST,
+    BOOT_BACKGROUND_FILE_LISTS,
+    BOOT_BACKGROUND_PROFILE,
+    BOOT_BACKGROUND_DONE
+};
+uint8_t bootBackgroundStep = BOOT_BACKGROUND_WAVEFORMS;
+
 // Defined bellow
 void dependencyInjection();
+void bootBackgroundWork();
+
+void bootProfileStart() {
+    ENABLE_DWT_CYCCNT();
+    bootPhaseStartCycles = READ_DWT_CYCCNT();
+}
+
+void bootProfileMark(const char *name) {
+    uint32_t cycles = READ_DWT_CYCCNT();
+    if (numberOfBootPhases < BOOT_PROFILE_MAX_PHASES) {
+        bootPhases[numberOfBootPhases].name = name;
+        bootPhases[numberOfBootPhases].cycles = cycles - bootPhaseStartCycles;
+        numberOfBootPhases++;
+    }
+    bootPhaseStartCycles = cycles;
+}
+
+void bootProfileDisplay() {
+    uint32_t cyclesPerMillis = SystemCoreClock / 1000;
+
+    tft.fillArea(0, 40, 240, 20 + numberOfBootPhases * TFT_SMALL_CHAR_HEIGHT, COLOR_BLACK);
+    tft.setCharBackgroundColor(COLOR_BLACK);
+    tft.setCharColor(COLOR_GRAY);
+    for (int p = 0; p < numberOfBootPhases; p++) {
+        tft.setCursorInPixel(10, 50 + p * TFT_SMALL_CHAR_HEIGHT);
+        tft.printSmallChars(bootPhases[p].name);
+        tft.setCursorInPixel(160, 50 + p * TFT_SMALL_CHAR_HEIGHT);
+        tft.printSmallChar((int) (bootPhases[p].cycles / cyclesPerMillis));
+        tft.printSmallChars(" ms");
+    }
+}
 
 void preenfm3Init() {
 
+    bootProfileStart();
+
     uint32_t erreurSD = preenfm3LibInitSD();
+    bootProfileMark("SD card");
 
     tft.init(&tftAlgo);
     ILI9341_Init();
+    bootProfileMark("TFT");
 
     dependencyInjection();
 
     fmDisplay3.setRefreshStatus(20);
 
-    for (int s = 0; s < 128; s++) {
+    for (int s = 0; s < BLOCK_SIZE * 4; s++) {
         waveform1[s] = 0;
         waveform2[s] = 0;
         waveform3[s] = 0;
     }
 
-    HAL_SAI_Transmit_DMA(&hsai_BlockA2, (uint8_t *) waveform3, 64 * 2);
-    HAL_SAI_Transmit_DMA(&hsai_BlockB1, (uint8_t *) waveform2, 64 * 2);
-    HAL_SAI_Transmit_DMA(&hsai_BlockA1, (uint8_t *) waveform1, 64 * 2);
+    HAL_SAI_Transmit_DMA(&hsai_BlockA2, (uint8_t *) waveform3, BLOCK_SIZE * 4);
+    HAL_SAI_Transmit_DMA(&hsai_BlockB1, (uint8_t *) waveform2, BLOCK_SIZE * 4);
+    HAL_SAI_Transmit_DMA(&hsai_BlockA1, (uint8_t *) waveform1, BLOCK_SIZE * 4);
+    bootProfileMark("Audio start");
 
     timbreSamples = synth.getTimbre(synthState.getCurrentTimbre())->getSampleBlock();
 
@@ -149,8 +223,47 @@ void preenfm3Init() {
         HAL_Delay(2000);
         // Refresh all
         fmDisplay3.newSynthMode(&synthState.fullState);
+        bootBackgroundStep = BOOT_BACKGROUND_DONE;
     }
     HAL_GPIO_WritePin(LED_CONTROL_GPIO_Port, LED_CONTROL_Pin, GPIO_PIN_RESET);
+    bootProfileMark("Screen");
+}
+
+/*
+ * One step of the boot work that can wait until audio runs.
+ * Called from the main loop when the display has nothing to do.
+ */
+void bootBackgroundWork() {
+    bootPhaseStartCycles = READ_DWT_CYCCNT();
+    switch (bootBackgroundStep) {
+        case BOOT_BACKGROUND_WAVEFORMS:
+            // .txt user waveforms converted to .bin
+            if (sdCard.getUserWaveform()->convertNextUserWaveform()) {
+                bootProfileMark("Waveform txt");
+                return;
+            }
+            break;
+        case BOOT_BACKGROUND_SETLIST:
+            // Set list mixers are read once here, song changes don't use the SD card
+            sdCard.getSetListFile()->loadSetList();
+            bootProfileMark("Set list");
+            break;
+        case BOOT_BACKGROUND_FILE_LISTS:
+            sdCard.getPatchBank()->prepareFiles();
+            sdCard.getMixerBank()->prepareFiles();
+            sdCard.getSequenceBank()->prepareFiles();
+            sdCard.getDX7SysexFile()->prepareFiles();
+            sdCard.getScalaFile()->prepareFiles();
+            bootProfileMark("File lists");
+            break;
+        case BOOT_BACKGROUND_PROFILE:
+            if (synthState.fullState.midiConfigValue[MIDICONFIG_CPU_USAGE]) {
+                bootProfileDisplay();
+                bootProfileClearMillis = HAL_GetTick() + 3000;
+            }
+            break;
+    }
+    bootBackgroundStep++;
 }
 
 
@@ -200,6 +313,7 @@ void preenfm3Loop() {
         // force cpu usage refresh
         cpuUsageMillis = 0;
         previousCpuUsage = 101;
+        usbMidiDroppedPacketsOnScreen = 0xffffffff;
     }
 
     if (fmDisplay3.needRefresh() && tft.getNumberOfPendingActions() < 100) {
@@ -212,6 +326,7 @@ void preenfm3Loop() {
         // Oscillo refreqh : 8 Hz = 125 ms
         if (unlikely((currentMillis - oscilloMillis) >= 125)) {
             oscilloMillis = currentMillis;
+            tft.oscilloSetTimebase(synthState.fullState.midiConfigValue[MIDICONFIG_OSCILLO_TIMEBASE]);
             tft.oscilloRrefresh();
             float lf = synth.getLowerNoteFrequency(synthState.getCurrentTimbre());
 			tft.oscilloNewLowerFrequency(lf);
@@ -224,6 +339,20 @@ void preenfm3Loop() {
         oscilloMillis = currentMillis;
     }
 
+    if (unlikely(bootBackgroundStep < BOOT_BACKGROUND_DONE) && !fmDisplay3.needRefresh()) {
+        bootBackgroundWork();
+    }
+    if (unlikely(bootProfileClearMillis != 0) && currentMillis > bootProfileClearMillis) {
+        bootProfileClearMillis = 0;
+        fmDisplay3.newSynthMode(&synthState.fullState);
+    }
+
+    // Read the patches around the current one when the display has nothing to do
+    if (unlikely((currentMillis - patchPrefetchMillis) >= 50) && !fmDisplay3.needRefresh()) {
+        patchPrefetchMillis = currentMillis;
+        sdCard.getPatchBank()->prefetchNeighbours(synthState.fullState.preenFMBank, synthState.fullState.preenFMPresetNumber);
+    }
+
 
     if (synthState.fullState.midiConfigValue[MIDICONFIG_TFT_AUTO_REINIT] == 1) {
         // Detect TFT errors
@@ -239,6 +368,15 @@ void preenfm3Loop() {
             tft.setCursorInPixel(5, 25);
             tft.printSmallChar(ili9341NumberOfErrors);
         }
+
+        // Display actions lost because the TFT queue was full
+        uint32_t tftDroppedActions = tft.getNumberOfDroppedActions();
+        if ((tftDroppedActions != tftDroppedActionsOnScreen || tftHasJustBeenCleared) && tft.getNumberOfPendingActions() < 100) {
+            tftDroppedActionsOnScreen = tftDroppedActions;
+            tft.setCharColor(COLOR_GRAY);
+            tft.setCursorInPixel(40, 25);
+            tft.printSmallChar((int) tftDroppedActions);
+        }
     }
 
     if (synthState.fullState.midiConfigValue[MIDICONFIG_CPU_USAGE]) {
@@ -272,6 +410,18 @@ void preenfm3Loop() {
                 }
                 tft.printSmallChar((int)numberOfPlayingVoices);
             }
+
+            // USB MIDI packets : late / dropped
+            if (usbMidiLatePackets != usbMidiLatePacketsOnScreen || usbMidiDroppedPackets != usbMidiDroppedPacketsOnScreen) {
+                usbMidiLatePacketsOnScreen = usbMidiLatePackets;
+                usbMidiDroppedPacketsOnScreen = usbMidiDroppedPackets;
+                tft.setCharBackgroundColor(COLOR_BLACK);
+                tft.setCharColor(usbMidiDroppedPackets > 0 ? COLOR_RED : COLOR_GRAY);
+                tft.setCursorInPixel(175, 25);
+                tft.printSmallChar((int) usbMidiLatePackets);
+                tft.printSmallChar('/');
+                tft.printSmallChar((int) usbMidiDroppedPackets);
+            }
         }
     }
 }
@@ -320,17 +470,21 @@ void preenfm3DecodeMidiIn() {
     while (usartBufferIn.getCount() > 0) {
         midiDecoder.newByte(usartBufferIn.remove());
     }
-    while (usbMidi.getCount() > 0) {
+    for (int b = 0; b < USB_MIDI_BYTES_PER_BLOCK && usbMidi.getCount() > 0; b++) {
         midiDecoder.newByte(usbMidi.remove());
     }
+    if (usbMidi.getFreeCount() >= USB_MIDI_PACKET_MAX_BYTES) {
+        // Does nothing if the endpoint was not held back
+        USBD_MIDI_ReceivePacket(&hUsbDeviceFS);
+    }
 }
 
 void HAL_SAI_TxCpltCallback(SAI_HandleTypeDef *hsai) {
     if (hsai == &hsai_BlockA1) {
         preenfm3DecodeMidiIn();
 
-        saturatedOutput |= synth.buildNewSampleBlock(&waveform1[64], &waveform2[64], &waveform3[64]);
-        tft.oscilloRecord32Samples(timbreSamples);
+        saturatedOutput |= synth.buildNewSampleBlock(&waveform1[BLOCK_SIZE * 2], &waveform2[BLOCK_SIZE * 2], &waveform3[BLOCK_SIZE * 2]);
+        tft.oscilloRecordSamples(timbreSamples, BLOCK_SIZE);
     }
 }
 
@@ -345,7 +499,7 @@ void HAL_SAI_TxHalfCpltCallback(SAI_HandleTypeDef *hsai) {
         preenfm3DecodeMidiIn();
 
         saturatedOutput |= synth.buildNewSampleBlock(waveform1, waveform2, waveform3);
-        tft.oscilloRecord32Samples(timbreSamples);
+        tft.oscilloRecordSamples(timbreSamples, BLOCK_SIZE);
     }
 }
 
@@ -464,12 +618,19 @@ void dependencyInjection() {
     sdCard.getMixerBank()->setSequencer(&sequencer);
     sdCard.getSequenceBank()->setSequencer(&sequencer);
 
+    bootProfileMark("Objects");
+
     // Load preferences
+    // Only what the first note needs : file lists, set list and .txt waveforms wait for bootBackgroundWork
     sdCard.getConfigurationFile()->loadConfig(synthState.fullState.midiConfigValue);
+    bootProfileMark("Settings");
     sdCard.getMixerBank()->loadDefaultMixer();
+    bootProfileMark("Default mixer");
     sdCard.getSequenceBank()->loadDefaultSequence();
+    bootProfileMark("Default sequence");
     sdCard.getUserWaveform()->loadUserWaveforms();
     sdCard.getUserEnvCurve()->loadUserEnvCurves();
+    bootProfileMark("User waveforms");
     synthState.propagateAfterNewMixerLoad();
 
 
@@ -479,9 +640,21 @@ void dependencyInjection() {
 
 }
 
-void preenfm3_usbDataReceive(uint8_t *buffer) {
+/*
+ * Returns 0 when usbMidi has no room for another packet : the USB MIDI endpoint then NAKs
+ * the host until preenfm3DecodeMidiIn has decoded enough bytes.
+ */
+uint8_t preenfm3_usbDataReceive(uint8_t *buffer) {
     int usbr = 0;
-    while (buffer[usbr] != 0 && usbr < 64) {
+    if (unlikely(usbMidi.getFreeCount() < USB_MIDI_PACKET_MAX_BYTES)) {
+        // Cannot happen while the endpoint is held back below
+        usbMidiDroppedPackets++;
+        // Packets are zero terminated
+        for (; usbr < 64; usbr += 4) {
+            buffer[usbr] = 0;
+        }
+    }
+    while (usbr < 64 && buffer[usbr] != 0) {
         // Cable 0
         if ((buffer[usbr] >> 4) == 0) {
             switch (buffer[usbr] & 0xf) {
@@ -534,6 +707,12 @@ void preenfm3_usbDataReceive(uint8_t *buffer) {
         buffer[usbr] = 0;
         usbr += 4;
     }
+
+    if (usbMidi.getFreeCount() < USB_MIDI_PACKET_MAX_BYTES) {
+        usbMidiLatePackets++;
+        return 0;
+    }
+    return 1;
 }
 
 float getCompInstrumentVolume(int t) {
@@ -26,7 +26,23 @@
 #define unlikely(x)     __builtin_expect((x),0)
 #define ARRAY_SIZE(x)  ( sizeof(x) / sizeof((x)[0]) )
 
+// Samples computed per call to buildNewSampleBlock.
+// 16 halves the audio latency, 64 spreads the per block work (matrix, envelopes, mixing setup)
+// over more samples and leaves room for more voices. Override it with -DBLOCK_SIZE=xx.
+#ifndef BLOCK_SIZE
 #define BLOCK_SIZE 32
+#endif
+
+#if BLOCK_SIZE != 16 && BLOCK_SIZE != 32 && BLOCK_SIZE != 64
+#error "BLOCK_SIZE must be 16, 32 or 64"
+#endif
+
+// Seed of the noise generator (oscillators, random lfos, grain fx...).
+// 0 : seeded by the hardware RNG at start up. Any other value gives the same sound at each run.
+// Override it with -DNOISE_SEED=xx, or at run time with Synth::setNoiseSeed.
+#ifndef NOISE_SEED
+#define NOISE_SEED 0
+#endif
 
 #define NUMBER_OF_ENCODERS_PFM2 4
 #define NUMBER_OF_ENCODERS 6
@@ -39,7 +55,7 @@
 #define PREENFM_FREQUENCY 47916.0f
 
 #define PREENFM_FREQUENCY_INVERSED 1.0f/PREENFM_FREQUENCY
-#define PREENFM_FREQUENCY_INVERSED_LFO PREENFM_FREQUENCY_INVERSED*32.0f
+#define PREENFM_FREQUENCY_INVERSED_LFO PREENFM_FREQUENCY_INVERSED*(float)BLOCK_SIZE
 
 #define NUMBER_OF_WAVETABLES 14
 
@@ -100,6 +116,11 @@ struct WaveTable {
     float floatToAdd;
     float precomputedValue;
     float phaseMul;
+    // Phase accumulator (see Osc.h)
+    int phaseShift;
+    float phaseIncPerHz;
+    float phaseIncToAdd;
+    float phaseFractionMul;
 };
 
 struct AlgoInformation {
@@ -725,7 +746,9 @@ enum MixerValueType {
     MIXER_VALUE_GLOBAL_SETTINGS_2,
     MIXER_VALUE_GLOBAL_SETTINGS_3,
     MIXER_VALUE_GLOBAL_SETTINGS_4,
-    MIXER_VALUE_GLOBAL_SETTINGS_5
+    MIXER_VALUE_GLOBAL_SETTINGS_5,
+    MIXER_VALUE_MAX_NUMBER_OF_VOICES,
+    MIXER_VALUE_VOICE_POOL_PRIORITY
 };
 
 enum SeqValueType {
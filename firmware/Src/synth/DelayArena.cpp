@@ -0,0 +1,100 @@
+/*
+ * Copyright 2020 Xavier Hosxe
+ *
+ * Author: Xavier Hosxe (xavier <dot> hosxe (at) g m a i l <dot> com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+#include "DelayArena.h"
+
+DelayArena::DelayArena(float *memory, int capacity) {
+    memory_ = memory;
+    capacity_ = capacity;
+    for (int t = 0; t < NUMBER_OF_TIMBRES; t++) {
+        offset_[t] = 0;
+        size_[t] = 0;
+        minimumSize_[t] = 0;
+        boundBuffer_[t] = 0;
+        boundSize_[t] = 0;
+    }
+}
+
+void DelayArena::bind(int timbre, float **buffer, int *size) {
+    boundBuffer_[timbre] = buffer;
+    boundSize_[timbre] = size;
+    updateBinding(timbre);
+}
+
+int DelayArena::setSize(int timbre, int preferredSize, int minimumSize) {
+    minimumSize_[timbre] = minimumSize;
+    // The current buffer is free for the new size
+    resize(timbre, 0);
+
+    int size = preferredSize;
+    while (size > minimumSize && size > getFreeSize()) {
+        size >>= 1;
+    }
+
+    if (size > getFreeSize()) {
+        // The others give back what they have above their minimum, from the last timbre
+        for (int t = NUMBER_OF_TIMBRES - 1; t >= 0 && size > getFreeSize(); t--) {
+            if (t != timbre && size_[t] > minimumSize_[t]) {
+                resize(t, minimumSize_[t]);
+                float *buffer = memory_ + offset_[t];
+                for (int s = 0; s < size_[t]; s++) {
+                    buffer[s] = 0;
+                }
+            }
+        }
+        // What they gave can be more than the minimum
+        while (size < preferredSize && size * 2 <= getFreeSize()) {
+            size <<= 1;
+        }
+    }
+
+    if (size > getFreeSize()) {
+        // The minimums do not fit in the capacity
+        size = 0;
+    }
+    resize(timbre, size);
+    float *buffer = memory_ + offset_[timbre];
+    for (int s = 0; s < size; s++) {
+        buffer[s] = 0;
+    }
+    return size;
+}
+
+void DelayArena::resize(int timbre, int size) {
+    int delta = size - size_[timbre];
+    if (delta == 0) {
+        return;
+    }
+    // Move the buffers of the next timbres, they are contiguous
+    int end = offset_[timbre] + size_[timbre];
+    int used = offset_[NUMBER_OF_TIMBRES - 1] + size_[NUMBER_OF_TIMBRES - 1];
+    memmove(memory_ + end + delta, memory_ + end, (used - end) * sizeof(float));
+    size_[timbre] = size;
+    updateBinding(timbre);
+    for (int t = timbre + 1; t < NUMBER_OF_TIMBRES; t++) {
+        offset_[t] += delta;
+        updateBinding(t);
+    }
+}
+
+void DelayArena::updateBinding(int timbre) {
+    if (boundBuffer_[timbre] != 0) {
+        *boundBuffer_[timbre] = getBuffer(timbre);
+        *boundSize_[timbre] = size_[timbre];
+    }
+}
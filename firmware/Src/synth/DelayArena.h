@@ -0,0 +1,65 @@
+/*
+ * Copyright 2020 Xavier Hosxe
+ *
+ * Author: Xavier Hosxe (xavier <dot> hosxe (at) g m a i l <dot> com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DELAYARENA_H_
+#define DELAYARENA_H_
+
+#include "Common.h"
+
+/*
+ * Delay memory of the timbre FX, handed out according to the FX type.
+ * The buffers are packed in timbre order : when the size of one timbre changes
+ * the buffers of the following timbres are moved, so there is never any hole.
+ * Each timbre binds its buffer pointer and size, the arena updates them when the buffer moves.
+ *
+ * A timbre asks for a preferred and a minimum size, both powers of 2.
+ * It gets the largest power of 2 between the two that is free. When even the minimum is not free,
+ * the timbres that got more than their own minimum are brought back to it.
+ * The sum of the minimums must fit in the capacity.
+ */
+class DelayArena {
+public:
+    DelayArena(float *memory, int capacity);
+
+    void bind(int timbre, float **buffer, int *size);
+    // The buffer of the timbre is cleared. Returns the size it gets.
+    int setSize(int timbre, int preferredSize, int minimumSize);
+
+    float* getBuffer(int timbre) {
+        return size_[timbre] > 0 ? memory_ + offset_[timbre] : 0;
+    }
+    int getSize(int timbre) {
+        return size_[timbre];
+    }
+    int getFreeSize() {
+        return capacity_ - (offset_[NUMBER_OF_TIMBRES - 1] + size_[NUMBER_OF_TIMBRES - 1]);
+    }
+
+private:
+    void resize(int timbre, int size);
+    void updateBinding(int timbre);
+
+    float *memory_;
+    int capacity_;
+    int offset_[NUMBER_OF_TIMBRES];
+    int size_[NUMBER_OF_TIMBRES];
+    int minimumSize_[NUMBER_OF_TIMBRES];
+    float **boundBuffer_[NUMBER_OF_TIMBRES];
+    int *boundSize_[NUMBER_OF_TIMBRES];
+};
+
+#endif /* DELAYARENA_H_ */
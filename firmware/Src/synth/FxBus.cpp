@@ -56,8 +56,8 @@ float sqrt3(const float x)
 inline
 float fastroot(float f,int n)
 {
-    long *lp,l;
-    lp=(long*)(&f);
+    int32_t *lp,l;
+    lp=(int32_t*)(&f);
     l=*lp;l-=0x3F800000l;l>>=(n-1);l+=0x3F800000l;
     *lp=l;
     return f;
@@ -163,7 +163,7 @@ void FxBus::mixSumInit() {
 
     sample = getSampleBlock();
 
-    for (int s = 0; s < 8; s++) {
+    for (int s = 0; s < BLOCK_SIZE / 4; s++) {
         *(sample++) = 0;
         *(sample++) = 0;
         *(sample++) = 0;
@@ -499,7 +499,7 @@ void FxBus::mixAdd(float *inStereo, float send, float reverbLevel) {
         totalSent += level;
 
         sample = getSampleBlock();
-        for (int s = 0; s < 8; s++) {
+        for (int s = 0; s < BLOCK_SIZE / 4; s++) {
             *(sample++) += *inStereo++ * level;
             *(sample++) += *inStereo++ * level;
             *(sample++) += *inStereo++ * level;
@@ -52,6 +52,13 @@ public:
 		ticks = 0;
 	}
 
+	// Continue from other, the same LFO of another voice of the timbre
+	template <class L> void copyState(const L *other) {
+		Matrix *voiceMatrix = this->matrix;
+		*static_cast<L*>(this) = *other;
+		this->matrix = voiceMatrix;
+	}
+
 
 protected:
 	Matrix *matrix;
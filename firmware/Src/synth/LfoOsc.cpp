@@ -19,7 +19,7 @@
 
 
 
-extern float noise[32];
+extern float noise[BLOCK_SIZE];
 
 void LfoOsc::init(struct LfoParams *lfoParams, float* phase, Matrix *matrix, SourceEnum source, DestinationEnum dest) {
     Lfo::init(matrix, source, dest);
@@ -56,6 +56,11 @@ public:
 		// Nothing to do
 	}
 
+	// Phase restarts on noteOn : no need to run this LFO while the voice is idle
+	bool isRestartedOnNoteOn() {
+	    return ramp >= 0.0f && isNotMidiSynchronized;
+	}
+
 
 
 private:
@@ -127,6 +127,13 @@ public:
         return this->sources[source];
     }
 
+    // Same destinations as the matrix of another voice of the timbre, the sources are kept
+    void copyDestinations(const Matrix *other) {
+        for (int k = 0; k < DESTINATION_MAX; k++) {
+            destinations[k] = other->destinations[k];
+        }
+    }
+
 private:
     float sources[MATRIX_SOURCE_MAX];
     float destinations[DESTINATION_MAX];
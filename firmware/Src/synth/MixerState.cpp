@@ -98,6 +98,12 @@ void MixerState::getFullState(char *buffer, uint32_t *size) {
     buffer[index++] = (char)(100.0f * fxBus_.masterfxConfig[GLOBALFX_NOTCHBASE]);
     buffer[index++] = (char)(100.0f * fxBus_.masterfxConfig[GLOBALFX_NOTCHSPREAD]);
 
+    // Voice pool
+    for (int t = 0; t < NUMBER_OF_TIMBRES; t++) {
+        buffer[index++] = instrumentState_[t].maxNumberOfVoices;
+        buffer[index++] = instrumentState_[t].voicePoolPriority;
+    }
+
     *size = index;
 }
 
@@ -185,6 +191,12 @@ void MixerState::getFullDefaultState(char *buffer, uint32_t *size, uint8_t mixNu
     buffer[index++] = (char)(GLOBALFX_NOTCHSPREAD_DEFAULT * 100.0f);
     buffer[index++] = (char)(GLOBALFX_LOOPHP_DEFAULT * 100.0f);
 
+    // Voice pool : no borrowing, normal priority
+    for (int t = 0; t < NUMBER_OF_TIMBRES; t++) {
+        buffer[index++] = 0;
+        buffer[index++] = 1;
+    }
+
     *size = index;
 }
 
@@ -211,6 +223,9 @@ void MixerState::restoreFullState(char *buffer) {
         case MIXER_BANK_VERSION6:
             restoreFullStateVersion6(buffer);
             break;
+        case MIXER_BANK_VERSION7:
+            restoreFullStateVersion7(buffer);
+            break;
     }
 }
 
@@ -219,6 +234,8 @@ void MixerState::setDefaultValues() {
         instrumentState_[t].pan = 0;
         instrumentState_[t].send = 0;
         instrumentState_[t].compressorType = 0;
+        instrumentState_[t].maxNumberOfVoices = 0;
+        instrumentState_[t].voicePoolPriority = 1;
     }
     // Let's set instrument 1 to Medium comp by default
     instrumentState_[0].compressorType = 2;
@@ -476,7 +493,7 @@ void MixerState::restoreFullStateVersion5(char *buffer) {
 /*
  * With FX send + reverb global params
  */
-void MixerState::restoreFullStateVersion6(char *buffer) {
+int MixerState::restoreFullStateVersion6(char *buffer) {
     int index = 0;
     index++; // version
 
@@ -545,6 +562,17 @@ void MixerState::restoreFullStateVersion6(char *buffer) {
     fxBus_.masterfxConfig[GLOBALFX_NOTCHSPREAD] = .01f * buffer[index++] ;
 
     fxBus_.paramChanged();
+    return index;
+}
+
+void MixerState::restoreFullStateVersion7(char *buffer) {
+    // Version 7 only appends the voice pool settings to version 6
+    int index = restoreFullStateVersion6(buffer);
+
+    for (int t = 0; t < NUMBER_OF_TIMBRES; t++) {
+        instrumentState_[t].maxNumberOfVoices = buffer[index++];
+        instrumentState_[t].voicePoolPriority = buffer[index++];
+    }
 }
 
 
@@ -32,10 +32,12 @@ enum MIXER_BANK_VERSION {
     // MPE
     MIXER_BANK_VERSION5,
     // REVERB
-    MIXER_BANK_VERSION6
+    MIXER_BANK_VERSION6,
+    // Voice pool
+    MIXER_BANK_VERSION7
 };
 
-#define MIXER_BANK_CURRENT_VERSION MIXER_BANK_VERSION6
+#define MIXER_BANK_CURRENT_VERSION MIXER_BANK_VERSION7
 
 
 
@@ -55,6 +57,9 @@ struct MixerInstrumentState {
     float *scaleFrequencies;
     int8_t pan;
     float send;
+    // Voice pool : numberOfVoices are guaranteed, voices up to maxNumberOfVoices can be borrowed
+    uint8_t maxNumberOfVoices;
+    uint8_t voicePoolPriority;
 };
 
 
@@ -88,7 +93,8 @@ private:
     void restoreFullStateVersion3(char *buffer);
     void restoreFullStateVersion4(char *buffer);
     void restoreFullStateVersion5(char *buffer);
-    void restoreFullStateVersion6(char *buffer);
+    int restoreFullStateVersion6(char *buffer);
+    void restoreFullStateVersion7(char *buffer);
     void setDefaultValues();
 };
 
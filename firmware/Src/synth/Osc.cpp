@@ -21,17 +21,17 @@
 
 #define INV440 .002272727272727f
 
-float silence[1]  ;
-float noise[32] ;
+float silence[2]  ;
+float noise[BLOCK_SIZE] ;
 
 
 
 float* Osc::oscValues[5] ;
-float oscValues1[32] ;
-float oscValues2[32] ;
-float oscValues3[32] ;
-float oscValues4[32] ;
-float oscValuesFeedback[32];
+float oscValues1[BLOCK_SIZE] ;
+float oscValues2[BLOCK_SIZE] ;
+float oscValues3[BLOCK_SIZE] ;
+float oscValues4[BLOCK_SIZE] ;
+float oscValuesFeedback[BLOCK_SIZE];
 int Osc::oscValuesCpt = 1;
 
 // User waveforms
@@ -89,7 +89,7 @@ struct WaveTable waveTables[NUMBER_OF_WAVETABLES]  = {
         //		OSC_SHAPE_RAND,
         {
                 noise,
-                0x1f,
+                BLOCK_SIZE - 1,
                 0.0f,
                 1.0f,
                 0.0f
@@ -97,7 +97,7 @@ struct WaveTable waveTables[NUMBER_OF_WAVETABLES]  = {
         //	OSC_SHAPE_OFF,
         {
                 silence,
-                0x00, // Must be 0 to reset index when switching from an other shape.
+                0x01,
                 0.0f,
                 0.0f,
                 0.0f
@@ -158,14 +158,14 @@ void Osc::init(SynthState* synthState, struct OscillatorParams *oscParams, Desti
 
     this->synthState_ = synthState;
     silence[0] = 0;
+    silence[1] = 0;
 
     this->destFreq = df;
     this->oscillator = oscParams;
 
     if (waveTables[0].precomputedValue <= 0) {
         for (int k=0; k<NUMBER_OF_WAVETABLES; k++) {
-            waveTables[k].precomputedValue = (waveTables[k].max + 1) * waveTables[k].useFreq * PREENFM_FREQUENCY_INVERSED;
-            waveTables[k].phaseMul = 1.f / (waveTables[k].max + 1);
+            initWaveTable(&waveTables[k]);
         }
     }
     if (oscValuesCpt == 1) {
@@ -180,9 +180,30 @@ void Osc::init(SynthState* synthState, struct OscillatorParams *oscParams, Desti
 
 
 
+/*
+ * Table sizes are powers of 2 : the index is the top log2(size) bits of the phase.
+ * Must be called again when the size of a user waveform changes.
+ */
+void Osc::initWaveTable(struct WaveTable* waveTable) {
+    int tableSize = waveTable->max + 1;
+    int tableBits = 0;
+    while ((1 << tableBits) < tableSize) {
+        tableBits++;
+    }
+    waveTable->precomputedValue = tableSize * waveTable->useFreq * PREENFM_FREQUENCY_INVERSED;
+    waveTable->phaseMul = 1.f / tableSize;
+    waveTable->phaseShift = 32 - tableBits;
+    waveTable->phaseIncPerHz = waveTable->useFreq * OSC_PHASE_UNIT * PREENFM_FREQUENCY_INVERSED;
+    // floatToAdd is in samples of the table
+    waveTable->phaseIncToAdd = waveTable->floatToAdd * OSC_PHASE_UNIT / tableSize;
+    waveTable->phaseFractionMul = 1.0f / (float) (1u << waveTable->phaseShift);
+}
+
+
 void Osc::newNote(struct OscState* oscState, float newNoteFrequency, float phase) {
 
-    oscState->index = waveTables[(int) oscillator->shape].max * phase;
+    // phase is in [0, 1], 1 wraps to 0
+    oscState->phase = ((uint32_t) (phase * 65536.0f)) << 16;
     switch ((int)oscillator->frequencyType) {
     case OSC_FT_KEYBOARD:
         oscState->mainFrequency = newNoteFrequency * oscillator->frequencyMul * (1.0f + oscillator->detune * .05f) * (synthState_->mixerState.tuning_ * INV440);
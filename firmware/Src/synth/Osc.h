@@ -24,8 +24,16 @@ extern float sinTable[];
 
 
 
+// The phase is a 32 bits accumulator : 2^32 is one period of the table, the overflow is the wrap
+// and the table index is the top bits of the phase.
+// Increments are computed with OSC_PHASE_HEADROOM_BITS less precision so that an int32_t can hold
+// frequencies up to 8 times the sample rate (FM can push an operator far above Nyquist).
+#define OSC_PHASE_HEADROOM_BITS 4
+#define OSC_PHASE_UNIT ((float)(1 << (32 - OSC_PHASE_HEADROOM_BITS)))
+#define OSC_PHASE_TO_FLOAT (1.0f / 4294967296.0f)
+
 struct OscState {
-    float index;
+    uint32_t phase;
     float frequency;
     float mainFrequencyPlusMatrix;
     float mainFrequency;
@@ -45,6 +53,7 @@ public:
     virtual ~Osc() {};
 
     void init(SynthState* synthState, struct OscillatorParams *oscParams, DestinationEnum df);
+    static void initWaveTable(struct WaveTable* waveTable);
 
     void newNote(struct OscState* oscState, float newNoteFrequency, float phase);
     float getNoteRealFrequencyEstimation(struct OscState* oscState, float newNoteFrequency);
@@ -57,91 +66,59 @@ public:
         oscState->mainFrequencyPlusMatrix +=  (oscState->mainFrequency  * (matrix->getDestination(destFreq) + matrix->getDestination(ALL_OSC_FREQ)) * .1f);
     }
 
+    inline uint32_t getPhaseIncrement(struct WaveTable* waveTable, float frequency) {
+        return ((uint32_t) (int32_t) (frequency * waveTable->phaseIncPerHz + waveTable->phaseIncToAdd)) << OSC_PHASE_HEADROOM_BITS;
+    }
+
     inline float getNextSample(struct OscState *oscState)  {
         struct WaveTable* waveTable = &waveTables[(int) oscillator->shape];
 
-        oscState->index +=  oscState->frequency * waveTable->precomputedValue + waveTable->floatToAdd;
+        oscState->phase += getPhaseIncrement(waveTable, oscState->frequency);
 
-        // convert to int;
-        int indexInteger = oscState->index;
-        // keep decimal part;
-        oscState->index -= indexInteger;
-        // Put it back inside the table
-        indexInteger &= waveTable->max;
-        // Readjust the floating pont inside the table
-        oscState->index += indexInteger;
-
-        return waveTable->table[indexInteger];
+        return waveTable->table[oscState->phase >> waveTable->phaseShift];
     }
 
     inline float getPhase(struct OscState *oscState)  {
-        struct WaveTable* waveTable = &waveTables[(int) oscillator->shape];
-        return oscState->index * waveTable->phaseMul;
-    }
-
-    inline float geIndexFromtPhase(float phase)  {
-        struct WaveTable* waveTable = &waveTables[(int) oscillator->shape];
-        return phase * waveTable->max;
+        return oscState->phase * OSC_PHASE_TO_FLOAT;
     }
 
 
    	inline float* getNextBlock(struct OscState *oscState)  {
-        int shape = (int) oscillator->shape;
-   		int max = waveTables[shape].max;
-   		float *wave = waveTables[shape].table;
-   		float freq = oscState->frequency * waveTables[shape].precomputedValue + waveTables[shape].floatToAdd;
-   		float fIndex = oscState->index;
-   		int iIndex;
+        struct WaveTable* waveTable = &waveTables[(int) oscillator->shape];
+   		float *wave = waveTable->table;
+   		int shift = waveTable->phaseShift;
+   		uint32_t phaseInc = getPhaseIncrement(waveTable, oscState->frequency);
+   		uint32_t phase = oscState->phase;
    		float* oscValuesToFill = oscValues[oscValuesCpt];
     	oscValuesCpt++;
     	oscValuesCpt &= 0x3;
 
-   		for (int k=0; k<32; ) {
-            fIndex +=  freq;
-            iIndex = fIndex;
-            fIndex -= iIndex;
-            iIndex &=  max;
-            fIndex += iIndex;
-            oscValuesToFill[k++] = wave[iIndex];
-
-            fIndex +=  freq;
-            iIndex = fIndex;
-            fIndex -= iIndex;
-            iIndex &=  max;
-            fIndex += iIndex;
-            oscValuesToFill[k++] = wave[iIndex];
-
-            fIndex +=  freq;
-            iIndex = fIndex;
-            fIndex -= iIndex;
-            iIndex &=  max;
-            fIndex += iIndex;
-            oscValuesToFill[k++] = wave[iIndex];
-
-            fIndex +=  freq;
-            iIndex = fIndex;
-            fIndex -= iIndex;
-            iIndex &=  max;
-            fIndex += iIndex;
-            oscValuesToFill[k++] = wave[iIndex];
-
+   		for (int k=0; k<BLOCK_SIZE; ) {
+            phase += phaseInc;
+            oscValuesToFill[k++] = wave[phase >> shift];
+            phase += phaseInc;
+            oscValuesToFill[k++] = wave[phase >> shift];
+            phase += phaseInc;
+            oscValuesToFill[k++] = wave[phase >> shift];
+            phase += phaseInc;
+            oscValuesToFill[k++] = wave[phase >> shift];
    		}
-    	oscState->index = fIndex;
+    	oscState->phase = phase;
     	return oscValuesToFill;
     };
 
 
     inline float* getNextBlockWithFeedbackAndEnveloppe(struct OscState *oscState, float feedback, float& env, float envInc, float freqMultiplier, float* lastValue) {
-        int shape = (int) oscillator->shape;
-        int max = waveTables[shape].max;
-        float *wave = waveTables[shape].table;
-        float freq = oscState->frequency * waveTables[shape].precomputedValue + waveTables[shape].floatToAdd;
-        float fIndex = oscState->index;
-        int iIndex;
+        struct WaveTable* waveTable = &waveTables[(int) oscillator->shape];
+        float *wave = waveTable->table;
+        int shift = waveTable->phaseShift;
+        uint32_t phaseInc = getPhaseIncrement(waveTable, oscState->frequency);
+        uint32_t phase = oscState->phase;
         float* oscValuesToFill = oscValues[4];
 
         lastValue[2] = .95f * lastValue[2] + feedback * .05f;
-        float phaseModulationAmplitude = lastValue[2] * ((float) max) * .5f;
+        // Half a period per unit of feedback
+        float phaseModulationAmplitude = lastValue[2] * OSC_PHASE_UNIT * .5f;
 
         float localLastValue0 = lastValue[0];
         float localLastValue1 = lastValue[1];
@@ -149,18 +126,13 @@ public:
         // Optimisation to avoid multiple freqMultiplier in the loop
         float localEnvM = env * freqMultiplier;
         float envIncM   = envInc   * freqMultiplier;
-        for (int k = 0; k < 32; k++) {
-            fIndex += freq;
-            iIndex = fIndex;
-            fIndex -= iIndex;
-            iIndex &= max;
-            fIndex += iIndex;
+        for (int k = 0; k < BLOCK_SIZE; k++) {
+            phase += phaseInc;
 
-            int index =  iIndex + (localLastValue0 * phaseModulationAmplitude);
-            index &= max;
+            uint32_t phaseModulation = ((uint32_t) (int32_t) (localLastValue0 * phaseModulationAmplitude)) << OSC_PHASE_HEADROOM_BITS;
 
             // Get rid of DC offset
-            float newValue = wave[index];
+            float newValue = wave[(phase + phaseModulation) >> shift];
             localLastValue0 = newValue - localLastValue1 + .99525f * localLastValue0;
             localLastValue1 = newValue;
 
@@ -171,58 +143,33 @@ public:
         lastValue[1] = localLastValue1;
 
         // update env
-        env += envInc * 32;
+        env += envInc * BLOCK_SIZE;
 
-        oscState->index = fIndex;
+        oscState->phase = phase;
         return oscValuesToFill;
     }
 
 
+    // Linear interpolation between two samples, the fractional part comes from the low bits of the phase
    	float* getNextBlockHQ(struct OscState *oscState)  {
-        int shape = (int) oscillator->shape;
-   		int max = waveTables[shape].max;
-   		float *wave = waveTables[shape].table;
-   		float freq = oscState->frequency * waveTables[shape].precomputedValue + waveTables[shape].floatToAdd;
-   		float fIndex = oscState->index;
-   		int iIndex;
-   		float fp;
+        struct WaveTable* waveTable = &waveTables[(int) oscillator->shape];
+   		int max = waveTable->max;
+   		float *wave = waveTable->table;
+   		int shift = waveTable->phaseShift;
+   		uint32_t fractionMask = ~(0xffffffff << shift);
+   		float fractionMul = waveTable->phaseFractionMul;
+   		uint32_t phaseInc = getPhaseIncrement(waveTable, oscState->frequency);
+   		uint32_t phase = oscState->phase;
    		float* oscValuesToFill = oscValues[oscValuesCpt];
     	oscValuesCpt++;
     	oscValuesCpt &= 0x3;
-   		for (int k=0; k<32; ) {
-            fIndex +=  freq;
-            iIndex = fIndex;
-            fIndex -= iIndex;
-            fp = fIndex;
-            iIndex &=  max;
-            fIndex += iIndex;
-            oscValuesToFill[k++] = wave[iIndex] * (1-fp) + wave[iIndex]* fp;
-
-            fIndex +=  freq;
-            iIndex = fIndex;
-            fIndex -= iIndex;
-            fp = fIndex;
-            iIndex &=  max;
-            fIndex += iIndex;
-            oscValuesToFill[k++] = wave[iIndex] * (1-fp) + wave[iIndex]* fp;
-
-            fIndex +=  freq;
-            iIndex = fIndex;
-            fIndex -= iIndex;
-            fp = fIndex;
-            iIndex &=  max;
-            fIndex += iIndex;
-            oscValuesToFill[k++] = wave[iIndex] * (1-fp) + wave[iIndex]* fp;
-
-            fIndex +=  freq;
-            iIndex = fIndex;
-            fIndex -= iIndex;
-            fp = fIndex;
-            iIndex &=  max;
-            fIndex += iIndex;
-            oscValuesToFill[k++] = wave[iIndex] * (1-fp) + wave[iIndex]* fp;
+   		for (int k=0; k<BLOCK_SIZE; k++) {
+            phase += phaseInc;
+            uint32_t iIndex = phase >> shift;
+            float fp = (phase & fractionMask) * fractionMul;
+            oscValuesToFill[k] = wave[iIndex] * (1-fp) + wave[(iIndex + 1) & max] * fp;
    		}
-    	oscState->index = fIndex;
+    	oscState->phase = phase;
     	return oscValuesToFill;
     };
 
@@ -21,7 +21,7 @@
 #include "Sequencer.h"
 
 extern RNG_HandleTypeDef hrng;
-extern float noise[32];
+extern float noise[BLOCK_SIZE];
 
 Synth::Synth(void) {
 }
@@ -43,7 +43,18 @@ float sqrt3(const float x)
   return u.x;
 }
 
+void Synth::setNoiseSeed(uint32_t seed) {
+    if (seed == 0) {
+        // Not in the audio interrupt : the RNG peripheral can be waited for
+        HAL_RNG_GenerateRandomNumber(&hrng, &seed);
+    }
+    // xorshift32 stays at 0 once there
+    noiseState_ = (seed != 0 ? seed : 0x9e3779b9);
+}
+
 void Synth::init(SynthState *synthState) {
+    setNoiseSeed(NOISE_SEED);
+
     for (int t = 0; t < NUMBER_OF_TIMBRES; t++) {
         for (uint16_t k = 0; k < (sizeof(struct OneSynthParams) / sizeof(float)); k++) {
             ((float*) &timbres_[t].params_)[k] = ((float*) &preenMainPreset)[k];
@@ -59,6 +70,10 @@ void Synth::init(SynthState *synthState) {
         voices_[k].init();
     }
     rebuidVoiceAllTimbre();
+    voicePoolNumberOfNoteOn_ = 0;
+    voicePoolNumberOfFree_ = 0;
+    voicePoolBorrowed_ = false;
+    voicePoolVoicesChanged_ = false;
     // Here synthState is already initialized
     for (int t = 0; t < NUMBER_OF_TIMBRES; t++) {
         timbres_[t].numberOfVoicesChanged(this->synthState_->mixerState.instrumentState_[t].numberOfVoices);
@@ -67,7 +82,7 @@ void Synth::init(SynthState *synthState) {
 
         // Default is No compressor
         // We set the sample rate /32 because we update the env only once per BLOCK
-        instrumentCompressor_[t].setSampleRate(PREENFM_FREQUENCY / 32.0f);
+        instrumentCompressor_[t].setSampleRate(PREENFM_FREQUENCY / (float)BLOCK_SIZE);
         instrumentCompressor_[t].setRatio(1.0f);
         instrumentCompressor_[t].setThresh(1000.0f);
         instrumentCompressor_[t].setAttack(10.0);
@@ -79,7 +94,7 @@ void Synth::init(SynthState *synthState) {
     totalCyclesUsedInSynth_ = 0;
     numberOfPlayingVoices_ = 0;
     cpuUsage_ = 0.0f;
-    totalNumberofCyclesInv_ = 1 / (SystemCoreClock * 32.0f * PREENFM_FREQUENCY_INVERSED);
+    totalNumberofCyclesInv_ = 1 / (SystemCoreClock * (float)BLOCK_SIZE * PREENFM_FREQUENCY_INVERSED);
 
 }
 
@@ -87,6 +102,9 @@ void Synth::noteOn(int timbre, char note, char velocity) {
     if (synthState_->fullState.synthMode == SYNTH_MODE_SEQUENCER) {
         sequencer_->insertNote(timbre, note, velocity);
     }
+    if (unlikely(voicePoolNoteOn(timbre, note, velocity))) {
+        return;
+    }
     timbres_[timbre].noteOn(note, velocity);
 
 }
@@ -95,17 +113,26 @@ void Synth::noteOff(int timbre, char note) {
     if (synthState_->fullState.synthMode == SYNTH_MODE_SEQUENCER) {
         sequencer_->insertNote(timbre, note, 0);
     }
+    if (unlikely(voicePoolNoteOff(timbre, note))) {
+        return;
+    }
     timbres_[timbre].noteOff(note);
 }
 
 void Synth::noteOnFromSequencer(uint8_t timbre, int16_t note, uint8_t velocity) {
     if (likely(note > 0 & note < 127)) {
+        if (unlikely(voicePoolNoteOn(timbre, note, velocity))) {
+            return;
+        }
         timbres_[timbre].noteOn(note, velocity);
     }
 }
 
 void Synth::noteOffFromSequencer(uint8_t timbre, int16_t note) {
     if (likely(note > 0 & note < 127)) {
+        if (unlikely(voicePoolNoteOff(timbre, note))) {
+            return;
+        }
         timbres_[timbre].noteOff(note);
     }
 }
@@ -157,7 +184,7 @@ void Synth::setHoldPedal(int timbre, int value) {
 }
 
 void Synth::allNoteOffQuick(int timbre) {
-    int numberOfVoices = this->synthState_->mixerState.instrumentState_[timbre].numberOfVoices;
+    int numberOfVoices = timbres_[timbre].numberOfVoices_;
     for (int k = 0; k < numberOfVoices; k++) {
         // voice number k of timbre
         int n = timbres_[timbre].voiceNumber_[k];
@@ -173,7 +200,7 @@ void Synth::stopArpegiator(int timbre) {
 
 
 void Synth::allNoteOff(int timbre) {
-    int numberOfVoices = this->synthState_->mixerState.instrumentState_[timbre].numberOfVoices;
+    int numberOfVoices = timbres_[timbre].numberOfVoices_;
     for (int k = 0; k < numberOfVoices; k++) {
         // voice number k of timbre
         int n = timbres_[timbre].voiceNumber_[k];
@@ -184,7 +211,7 @@ void Synth::allNoteOff(int timbre) {
 }
 
 void Synth::allSoundOff(int timbre) {
-    int numberOfVoices = this->synthState_->mixerState.instrumentState_[timbre].numberOfVoices;
+    int numberOfVoices = timbres_[timbre].numberOfVoices_;
     for (int k = 0; k < numberOfVoices; k++) {
         // voice number k of timbre
         int n = timbres_[timbre].voiceNumber_[k];
@@ -256,20 +283,25 @@ uint8_t Synth::buildNewSampleBlock(int32_t *buffer1, int32_t *buffer2, int32_t *
     CYCLE_MEASURE_START(cycles_all_)
     ;
 
-    // We consider the random number is always ready here...
-    uint32_t random32bit;
-    if (unlikely(HAL_RNG_GenerateRandomNumber(&hrng, &random32bit) != HAL_OK)) {
-        // Recreate on rnd from previous pass
-        random32bit = noise[31] * 0x7fffffff;
+    // Voices are moved from one timbre to another only here, between two blocks
+    if (unlikely(voicePoolNumberOfNoteOn_ > 0 || voicePoolBorrowed_ || voicePoolVoicesChanged_)) {
+        voicePoolRebind();
     }
 
-    noise[0] = (random32bit & 0xffff) * .000030518f - 1.0f; // value between -1 and 1.
-    noise[1] = (random32bit >> 16) * .000030518f - 1.0f; // value between -1 and 1.
-    for (int noiseIndex = 2; noiseIndex < 32;) {
-        random32bit = 214013 * random32bit + 2531011;
+    for (int t = 0; t < NUMBER_OF_TIMBRES; t++) {
+        timbres_[t].applyParams();
+    }
+
+    // xorshift32 : no wait for the RNG peripheral here, and the same noise for the same seed
+    uint32_t random32bit = noiseState_;
+    for (int noiseIndex = 0; noiseIndex < BLOCK_SIZE;) {
+        random32bit ^= random32bit << 13;
+        random32bit ^= random32bit >> 17;
+        random32bit ^= random32bit << 5;
         noise[noiseIndex++] = (random32bit & 0xffff) * .000030518f - 1.0f; // value between -1 and 1.
         noise[noiseIndex++] = (random32bit >> 16) * .000030518f - 1.0f; // value between -1 and 1.
     }
+    noiseState_ = random32bit;
 
     numberOfPlayingVoices_ = 0;
     for (int t = 0; t < NUMBER_OF_TIMBRES; t++) {
@@ -289,11 +321,11 @@ uint8_t Synth::buildNewSampleBlock(int32_t *buffer1, int32_t *buffer2, int32_t *
     // Dispatch the timbres on the different out !!
 
     int32_t *cb1 = buffer1;
-    const int32_t *endcb1 = buffer1 + 64;
+    const int32_t *endcb1 = buffer1 + BLOCK_SIZE * 2;
     int32_t *cb2 = buffer2;
-    const int32_t *endcb2 = buffer2 + 64;
+    const int32_t *endcb2 = buffer2 + BLOCK_SIZE * 2;
     int32_t *cb3 = buffer3;
-    const int32_t *endcb3 = buffer3 + 64;
+    const int32_t *endcb3 = buffer3 + BLOCK_SIZE * 2;
 
     while (cb1 < endcb1) {
         *cb1++ = 0;
@@ -499,7 +531,7 @@ void Synth::beforeNewParamsLoad(int timbre) {
             velocityBeforeNewParalsLoad_[k] = noteEntry.velocity;
         }
     } else {
-        int numberOfVoices = this->synthState_->mixerState.instrumentState_[timbre].numberOfVoices;
+        int numberOfVoices = timbres_[timbre].numberOfVoices_;
         for (int k = 0; k < numberOfVoices && k < NUMBER_OF_STORED_NOTES; k++) {
             // voice number k of timbre
             int n = timbres_[timbre].voiceNumber_[k];
@@ -540,6 +572,9 @@ void Synth::afterNewMixerLoad() {
     for (int timbre = 0; timbre < NUMBER_OF_TIMBRES; timbre++) {
         timbres_[timbre].numberOfVoicesChanged(0);
     }
+    voicePoolNumberOfNoteOn_ = 0;
+    voicePoolBorrowed_ = false;
+    voicePoolVoicesChanged_ = false;
 
     rebuidVoiceAllTimbre();
 
@@ -573,7 +608,10 @@ int Synth::getFreeVoice() {
         int nv = this->synthState_->mixerState.instrumentState_[t].numberOfVoices;
 
         for (int v = 0; v < nv; v++) {
-            used[timbres_[t].voiceNumber_[v]] = true;
+            // Slots of a timbre that is growing are not assigned yet
+            if (timbres_[t].voiceNumber_[v] >= 0) {
+                used[timbres_[t].voiceNumber_[v]] = true;
+            }
         }
     }
 
@@ -588,6 +626,7 @@ int Synth::getFreeVoice() {
 
 void Synth::newParamValue(int timbre, int currentRow, int encoder, ParameterDisplay *param, float oldValue,
     float newValue) {
+    timbres_[timbre].paramsChanged();
     switch (currentRow) {
         case ROW_ARPEGGIATOR1:
             switch (encoder) {
@@ -610,33 +649,6 @@ void Synth::newParamValue(int timbre, int currentRow, int encoder, ParameterDisp
             break;
         case ROW_ARPEGGIATOR3:
             break;
-        case ROW_EFFECT1:
-            timbres_[timbre].setNewEffecParam(encoder);
-            break;
-        case ROW_ENV1_TIME:
-        case ROW_ENV1_LEVEL:
-            timbres_[timbre].env1_.reloadADSR(encoder);
-            break;
-        case ROW_ENV2_TIME:
-        case ROW_ENV2_LEVEL:
-            timbres_[timbre].env2_.reloadADSR(encoder);
-            break;
-        case ROW_ENV3_TIME:
-        case ROW_ENV3_LEVEL:
-            timbres_[timbre].env3_.reloadADSR(encoder);
-            break;
-        case ROW_ENV4_TIME:
-        case ROW_ENV4_LEVEL:
-            timbres_[timbre].env4_.reloadADSR(encoder);
-            break;
-        case ROW_ENV5_TIME:
-        case ROW_ENV5_LEVEL:
-            timbres_[timbre].env5_.reloadADSR(encoder);
-            break;
-        case ROW_ENV6_TIME:
-        case ROW_ENV6_LEVEL:
-            timbres_[timbre].env6_.reloadADSR(encoder);
-            break;
         case ROW_MATRIX_FIRST ... ROW_MATRIX_LAST:
             timbres_[timbre].verifyLfoUsed(encoder, oldValue, newValue);
             if (encoder == ENCODER_MATRIX_DEST1 || encoder == ENCODER_MATRIX_DEST2) {
@@ -644,38 +656,16 @@ void Synth::newParamValue(int timbre, int currentRow, int encoder, ParameterDisp
                 timbres_[timbre].resetMatrixDestination(oldValue);
             }
             break;
-        case ROW_LFOOSC1 ... ROW_LFOOSC3:
-        case ROW_LFOENV1 ... ROW_LFOENV2:
-        case ROW_LFOSEQ1 ... ROW_LFOSEQ2:
-            // timbres[timbre].lfo[currentRow - ROW_LFOOSC1]->valueChanged(encoder);
-            timbres_[timbre].lfoValueChange(currentRow, encoder, newValue);
-            break;
         case ROW_PERFORMANCE1:
             timbres_[timbre].setMatrixSource((enum SourceEnum) (MATRIX_SOURCE_CC1 + encoder), newValue);
             break;
-        case ROW_MIDINOTE1CURVE:
-            timbres_[timbre].updateMidiNoteScale(0);
-            break;
-        case ROW_MIDINOTE2CURVE:
-            timbres_[timbre].updateMidiNoteScale(1);
-            break;
-        case ROW_ENV1_CURVE:
-            timbres_[timbre].env1_.applyCurves();
-            break;
-        case ROW_ENV2_CURVE:
-            timbres_[timbre].env2_.applyCurves();
-            break;
-        case ROW_ENV3_CURVE:
-            timbres_[timbre].env3_.applyCurves();
-            break;
-        case ROW_ENV4_CURVE:
-            timbres_[timbre].env4_.applyCurves();
-            break;
-        case ROW_ENV5_CURVE:
-            timbres_[timbre].env5_.applyCurves();
-            break;
-        case ROW_ENV6_CURVE:
-            timbres_[timbre].env6_.applyCurves();
+        case ROW_EFFECT1:
+        case ROW_ENV_FIRST ... ROW_ENV_LAST:
+        case ROW_LFOOSC1 ... ROW_LFOOSC3:
+        case ROW_LFOENV1 ... ROW_MIDINOTE2CURVE:
+        case ROW_ENV1_CURVE ... ROW_ENV6_CURVE:
+            // Applied once at the beginning of the next block whatever the number of changes
+            timbres_[timbre].paramToApply(currentRow, encoder);
             break;
 
     }
@@ -725,18 +715,14 @@ void Synth::newMixerValue(uint8_t valueType, uint8_t timbre, float oldValue, flo
 
             if (newValue == oldValue) {
                 return;
-            } else if (newValue > oldValue) {
-                for (int v = (int) oldValue; v < (int) newValue; v++) {
-                    timbres_[timbre].setVoiceNumber(v, getFreeVoice());
-                }
-            } else {
-                for (int v = (int) newValue; v < (int) oldValue; v++) {
-                    voices_[timbres_[timbre].voiceNumber_[v]].killNow();
-                    timbres_[timbre].setVoiceNumber(v, -1);
-                }
             }
 
-            timbres_[timbre].numberOfVoicesChanged(newValue);
+            // The pool (voicePoolRebind, canBorrowVoice) reads the guaranteed voices from the mixer state :
+            // it must hold the new value, whoever called us.
+            this->synthState_->mixerState.instrumentState_[timbre].numberOfVoices = (int) newValue;
+
+            // The voices are reassigned by the next block, in voicePoolRebind
+            voicePoolVoicesChanged_ = true;
             break;
         case MIXER_VALUE_COMPRESSOR:
             switch ((int) newValue) {
@@ -790,6 +776,200 @@ void Synth::rebuidVoiceAllTimbre() {
     }
 }
 
+bool Synth::canBorrowVoice(int timbre) {
+    struct MixerInstrumentState *instrumentState = &this->synthState_->mixerState.instrumentState_[timbre];
+    // Poly only, MPE needs the static voice/channel mapping and the arpeggiator doesn't call noteOn immediately
+    return instrumentState->maxNumberOfVoices > timbres_[timbre].numberOfVoices_
+        && instrumentState->numberOfVoices > 0
+        && timbres_[timbre].params_.engine1.playMode == PLAY_MODE_POLY
+        && timbres_[timbre].params_.engineArp1.clock == CLOCK_OFF
+        && (timbre != 0 || this->synthState_->mixerState.MPE_inst1_ == 0);
+}
+
+// Returns true if the note on is delayed to the beginning of next block
+bool Synth::voicePoolNoteOn(int timbre, char note, char velocity) {
+    if (likely(!canBorrowVoice(timbre)) || timbres_[timbre].hasFreeVoice(note)
+        || voicePoolNumberOfNoteOn_ == MAX_NUMBER_OF_VOICES) {
+        return false;
+    }
+
+    VoicePoolNoteOn *noteOn = &voicePoolNoteOn_[voicePoolNumberOfNoteOn_];
+    noteOn->timbre = timbre;
+    noteOn->note = note;
+    noteOn->velocity = velocity;
+    noteOn->released = false;
+    voicePoolNumberOfNoteOn_++;
+    return true;
+}
+
+// Note off received before the note on was played
+bool Synth::voicePoolNoteOff(int timbre, char note) {
+    for (int r = 0; r < voicePoolNumberOfNoteOn_; r++) {
+        VoicePoolNoteOn *noteOn = &voicePoolNoteOn_[r];
+        if (noteOn->timbre == timbre && noteOn->note == note && !noteOn->released) {
+            noteOn->released = true;
+            return true;
+        }
+    }
+    return false;
+}
+
+void Synth::voicePoolRebind() {
+    if (unlikely(voicePoolVoicesChanged_)) {
+        voicePoolApplyNumberOfVoices();
+    }
+
+    // Idle borrowed voices go back to the pool
+    voicePoolBorrowed_ = false;
+    for (int t = 0; t < NUMBER_OF_TIMBRES; t++) {
+        int minVoices = this->synthState_->mixerState.instrumentState_[t].numberOfVoices;
+        for (int k = (int) timbres_[t].numberOfVoices_ - 1; k >= 0 && timbres_[t].numberOfVoices_ > minVoices; k--) {
+            int n = timbres_[t].voiceNumber_[k];
+            if (!voices_[n].isPlaying() && !voices_[n].isNewNotePending()) {
+                timbres_[t].giveBackVoice(k);
+            }
+        }
+        if (timbres_[t].numberOfVoices_ > minVoices) {
+            voicePoolBorrowed_ = true;
+        }
+    }
+
+    if (likely(voicePoolNumberOfNoteOn_ == 0)) {
+        return;
+    }
+
+    voicePoolUpdateFreeList();
+    for (int r = 0; r < voicePoolNumberOfNoteOn_; r++) {
+        VoicePoolNoteOn *noteOn = &voicePoolNoteOn_[r];
+        int t = noteOn->timbre;
+        // Previous note on may already have given a voice to this timbre
+        if (canBorrowVoice(t) && !timbres_[t].hasFreeVoice(noteOn->note)) {
+            int n;
+            if (voicePoolNumberOfFree_ > 0) {
+                n = voicePoolFree_[--voicePoolNumberOfFree_];
+            } else {
+                n = voicePoolStealVoice(t);
+                if (n >= 0) {
+                    timbres_[t].voiceStealCount_[VOICE_STEAL_POOL]++;
+                }
+            }
+            if (n >= 0) {
+                timbres_[t].borrowVoice(n);
+                voicePoolBorrowed_ = true;
+            }
+        }
+        // If no voice could be borrowed the timbre steals one of its own
+        timbres_[t].noteOn(noteOn->note, noteOn->velocity);
+        if (unlikely(noteOn->released)) {
+            timbres_[t].noteOff(noteOn->note);
+        }
+    }
+    voicePoolNumberOfNoteOn_ = 0;
+}
+
+void Synth::voicePoolUpdateFreeList() {
+    bool used[MAX_NUMBER_OF_VOICES];
+    for (int v = 0; v < MAX_NUMBER_OF_VOICES; v++) {
+        used[v] = false;
+    }
+    for (int t = 0; t < NUMBER_OF_TIMBRES; t++) {
+        for (int k = 0; k < timbres_[t].numberOfVoices_; k++) {
+            used[timbres_[t].voiceNumber_[k]] = true;
+        }
+    }
+    voicePoolNumberOfFree_ = 0;
+    for (int v = 0; v < MAX_NUMBER_OF_VOICES; v++) {
+        if (!used[v]) {
+            voicePoolFree_[voicePoolNumberOfFree_++] = v;
+        }
+    }
+}
+
+// Only voices above the guaranteed numberOfVoices of a timbre with the same or lower priority can be stolen.
+// Lowest priority first, then released voices, then the quietest one.
+int Synth::voicePoolStealVoice(int timbre) {
+    uint8_t priority = this->synthState_->mixerState.instrumentState_[timbre].voicePoolPriority;
+    int stealTimbre = -1;
+    int stealK = -1;
+    uint8_t stealPriority = 0;
+    bool stealReleased = false;
+    float stealLevel = 0.0f;
+
+    for (int t = 0; t < NUMBER_OF_TIMBRES; t++) {
+        struct MixerInstrumentState *instrumentState = &this->synthState_->mixerState.instrumentState_[t];
+        if (t == timbre || timbres_[t].numberOfVoices_ <= instrumentState->numberOfVoices
+            || instrumentState->voicePoolPriority > priority) {
+            continue;
+        }
+        for (int k = 0; k < timbres_[t].numberOfVoices_; k++) {
+            Voice *voice = &voices_[timbres_[t].voiceNumber_[k]];
+            if (voice->isNewNotePending()) {
+                continue;
+            }
+            bool released = voice->isReleased();
+            float level = voice->getCarrierEnvLevel();
+            bool better;
+            if (stealTimbre == -1) {
+                better = true;
+            } else if (instrumentState->voicePoolPriority != stealPriority) {
+                better = instrumentState->voicePoolPriority < stealPriority;
+            } else if (released != stealReleased) {
+                better = released;
+            } else {
+                better = level < stealLevel;
+            }
+            if (better) {
+                stealTimbre = t;
+                stealK = k;
+                stealPriority = instrumentState->voicePoolPriority;
+                stealReleased = released;
+                stealLevel = level;
+            }
+        }
+    }
+
+    if (stealTimbre == -1) {
+        return -1;
+    }
+
+    int n = timbres_[stealTimbre].voiceNumber_[stealK];
+    voices_[n].killNow();
+    timbres_[stealTimbre].giveBackVoice(stealK);
+    return n;
+}
+
+/*
+ * The number of voices of a timbre changed in the mixer.
+ * Called between two blocks : the voice tables are never changed while a block is being built.
+ */
+void Synth::voicePoolApplyNumberOfVoices() {
+    // Cleared first : a change made while we run is applied by the next block
+    voicePoolVoicesChanged_ = false;
+
+    // Borrowed voices, and the voices of a timbre that shrinks, go back to the pool before the voices are reassigned
+    for (int t = 0; t < NUMBER_OF_TIMBRES; t++) {
+        voicePoolGiveBack(t, this->synthState_->mixerState.instrumentState_[t].numberOfVoices);
+    }
+
+    for (int t = 0; t < NUMBER_OF_TIMBRES; t++) {
+        int numberOfVoices = this->synthState_->mixerState.instrumentState_[t].numberOfVoices;
+        if (timbres_[t].numberOfVoices_ < numberOfVoices) {
+            for (int v = (int) timbres_[t].numberOfVoices_; v < numberOfVoices; v++) {
+                timbres_[t].setVoiceNumber(v, getFreeVoice());
+            }
+            timbres_[t].numberOfVoicesChanged(numberOfVoices);
+        }
+    }
+}
+
+void Synth::voicePoolGiveBack(int timbre, int numberOfVoices) {
+    while (timbres_[timbre].numberOfVoices_ > numberOfVoices) {
+        int k = (int) timbres_[timbre].numberOfVoices_ - 1;
+        voices_[timbres_[timbre].voiceNumber_[k]].killNow();
+        timbres_[timbre].giveBackVoice(k);
+    }
+}
+
 void Synth::loadPreenFMPatchFromMidi(int timbre, int bank, int bankLSB, int patchNumber) {
     this->synthState_->loadPresetFromMidi(timbre, bank, bankLSB, patchNumber, &timbres_[timbre].params_);
 }
@@ -873,7 +1053,7 @@ void Synth::setNewSymbolInPresetName(int timbre, int index, char newchar) {
 }
 
 void Synth::setCurrentInstrument(int value) {
-    if (value >= 1 && value <= (NUMBER_OF_TIMBRES + 1)) {
+    if (value >= 1 && value <= NUMBER_OF_TIMBRES) {
         this->synthState_->setCurrentInstrument(value);
     }
 }
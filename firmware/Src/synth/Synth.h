@@ -142,10 +142,32 @@ public:
         return numberOfPlayingVoices_;
     }
 
+    uint32_t getVoiceStealCount(int reason) {
+        uint32_t count = 0;
+        for (int t = 0; t < NUMBER_OF_TIMBRES; t++) {
+            count += timbres_[t].getVoiceStealCount(reason);
+        }
+        return count;
+    }
+
+    // Modulation indexes, mix and pans recomputed by the voices during the last block
+    uint32_t getControlUpdates() {
+        uint32_t count = 0;
+        for (int t = 0; t < NUMBER_OF_TIMBRES; t++) {
+            if (this->synthState_->mixerState.instrumentState_[t].numberOfVoices > 0) {
+                count += timbres_[t].getControlUpdates();
+            }
+        }
+        return count;
+    }
+
     float getCpuUsage() {
         return cpuUsage_;
     }
 
+    // 0 : seed from the hardware RNG
+    void setNoiseSeed(uint32_t seed);
+
     chunkware_simple::SimpleComp& getCompInstrument(int t) {
         return instrumentCompressor_[t];
     }
@@ -155,6 +177,16 @@ private:
     void init(SynthState *synthState);
     void mixAndPan(int32_t *dest, float *source, float &pan, float sampleMultipler);
 
+    // Voice pool
+    bool canBorrowVoice(int timbre);
+    bool voicePoolNoteOn(int timbre, char note, char velocity);
+    bool voicePoolNoteOff(int timbre, char note);
+    void voicePoolRebind();
+    void voicePoolUpdateFreeList();
+    int voicePoolStealVoice(int timbre);
+    void voicePoolGiveBack(int timbre, int numberOfVoices);
+    void voicePoolApplyNumberOfVoices();
+
     Voice voices_[MAX_NUMBER_OF_VOICES];
     Timbre timbres_[NUMBER_OF_TIMBRES];
 
@@ -166,6 +198,9 @@ private:
     float totalNumberofCyclesInv_;
     CYCCNT_buffer cycles_all_;
 
+    // xorshift32 state of the noise generator, never 0
+    uint32_t noiseState_;
+
     // Sequencer
     Sequencer *sequencer_;
 
@@ -178,6 +213,22 @@ private:
     float *fxSample;
 
     chunkware_simple::SimpleComp instrumentCompressor_[NUMBER_OF_TIMBRES];
+
+    // Voice pool : note on waiting for a borrowed voice, bound at the beginning of next block
+    struct VoicePoolNoteOn {
+        uint8_t timbre;
+        char note;
+        char velocity;
+        bool released;
+    };
+    VoicePoolNoteOn voicePoolNoteOn_[MAX_NUMBER_OF_VOICES];
+    uint8_t voicePoolNumberOfNoteOn_;
+    int8_t voicePoolFree_[MAX_NUMBER_OF_VOICES];
+    uint8_t voicePoolNumberOfFree_;
+    // At least one timbre plays with more voices than its mixer numberOfVoices
+    bool voicePoolBorrowed_;
+    // A mixer numberOfVoices changed, the voices are reassigned at the beginning of next block
+    bool voicePoolVoicesChanged_;
 };
 
 #endif
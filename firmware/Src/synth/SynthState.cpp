@@ -62,6 +62,7 @@ SynthState::SynthState() {
     fullState.midiConfigValue[MIDICONFIG_TFT_AUTO_REINIT] = 0;
     fullState.midiConfigValue[MIDICONFIG_ENCODER_PUSH] = 0;
     fullState.midiConfigValue[MIDICONFIG_REVERB_PARAMS] = 0;
+    fullState.midiConfigValue[MIDICONFIG_OSCILLO_TIMEBASE] = 0;
     // Init randomizer values to 1
     fullState.randomizer.Oper = 1;
     fullState.randomizer.EnvT = 1;
@@ -400,6 +401,15 @@ void SynthState::loadMixer(PFM3File const *bank, int patchNumber) {
     propagateAfterNewMixerLoad();
 }
 
+void SynthState::loadSetListSong(int song) {
+    propagateBeforeNewParamsLoad(currentTimbre);
+    storage->getSetListFile()->loadSong(song);
+    // Update and clean all timbres
+    this->currentTimbre = 0;
+    propagateNewTimbre(currentTimbre);
+    propagateAfterNewMixerLoad();
+}
+
 void SynthState::loadPresetFromMidi(int timbre, int bank, int bankLSB, int patchNumber, struct OneSynthParams *params) {
     switch (bank) {
         case 0: {
@@ -432,6 +442,12 @@ void SynthState::loadPresetFromMidi(int timbre, int bank, int bankLSB, int patch
             }
             break;
         }
+        case 5:
+            // Set list : program number is the song, timbre is not used (MidiDecoder calls us once per message)
+            if (storage->getSetListFile()->isSongValid(patchNumber)) {
+                loadSetListSong(patchNumber);
+            }
+            break;
     }
 }
 
@@ -445,7 +461,7 @@ void SynthState::setCurrentInstrument(int value) {
         }
     } else if (value == 0) {
         currentTimbre = (currentTimbre + 1) % NUMBER_OF_TIMBRES;
-    } else if (value <= (NUMBER_OF_TIMBRES + 1)) {
+    } else if (value <= NUMBER_OF_TIMBRES) {
         currentTimbre = value - 1;
     } else {
         return;
@@ -326,6 +326,10 @@ enum FILTER2_TYPE {
     FILTER2_DIFFUSER,
     FILTER2_GRAIN1,
     FILTER2_GRAIN2,
+    FILTER2_LONGCRUNCH,
+    FILTER2_LONGPINGPONG,
+    FILTER2_LONGGRAIN1,
+    FILTER2_LONGGRAIN2,
     FILTER2_LAST
 };
 
@@ -576,6 +580,7 @@ public:
     void loadNewPreset(int timbre);
     void loadDx7Patch(int timbre, PFM3File const *bank, int patchNumber, struct OneSynthParams* params);
     void loadMixer(PFM3File const *bank, int patchNumber);
+    void loadSetListSong(int song);
     void loadPresetFromMidi(int timbre, int bank, int bankLSB, int patchNumber, struct OneSynthParams* params);
 
     bool newRandomizerValue(int encoder, int ticks);
@@ -27,9 +27,37 @@
 // Regular memory
 float midiNoteScale[2][NUMBER_OF_TIMBRES][128] __attribute__((section(".ram_d1")));
 float Timbre::unisonPhase[14] = { .37f, .11f, .495f, .53f, .03f, .19f, .89f, 0.23f, .71f, .19f, .31f, .43f, .59f, .97f };
-float Timbre::delayBuffer[NUMBER_OF_TIMBRES][delayBufferSize] __attribute__ ((section(".ram_d2b")));
+float Timbre::delayBuffer[NUMBER_OF_TIMBRES * delayBufferSize] __attribute__ ((section(".ram_d2b")));
+DelayArena Timbre::delayArena_(delayBuffer, NUMBER_OF_TIMBRES * delayBufferSize);
+
+// Delay memory of each FX2 type : preferred and minimum sizes (see DelayArena)
+// The other types always get their size : they sound the same whatever the other timbres play.
+// The long types have 4 times the delay time and twice the grain windows. When they get less
+// than they prefer, they write their buffer at a lower rate : same time, less bandwidth.
+const uint16_t fx2DelayBufferSize[FILTER2_LAST][2] = {
+    { 0, 0 }, // FILTER2_OFF
+    { delayBufferSize, delayBufferSize }, // FILTER2_FLANGE
+    { delayBufferSize, delayBufferSize }, // FILTER2_DIMENSION
+    { delayBufferSize, delayBufferSize }, // FILTER2_CHORUS
+    { delayBufferSize, delayBufferSize }, // FILTER2_WIDE
+    { delayBufferSize, delayBufferSize }, // FILTER2_DOUBLER
+    { delayBufferSize, delayBufferSize }, // FILTER2_TRIPLER
+    { 1024, 1024 }, // FILTER2_BODE
+    { delayBufferSize, delayBufferSize }, // FILTER2_DELAYCRUNCH
+    { delayBufferSize, delayBufferSize }, // FILTER2_PINGPONG
+    { delayBufferSize, delayBufferSize }, // FILTER2_DIFFUSER
+    { delayBufferSize, delayBufferSize }, // FILTER2_GRAIN1
+    { delayBufferSize, delayBufferSize }, // FILTER2_GRAIN2
+    { delayBufferSize * 4, delayBufferSize }, // FILTER2_LONGCRUNCH
+    { delayBufferSize * 4, delayBufferSize }, // FILTER2_LONGPINGPONG
+    { delayBufferSize * 2, delayBufferSize }, // FILTER2_LONGGRAIN1
+    { delayBufferSize * 2, delayBufferSize }  // FILTER2_LONGGRAIN2
+};
+
+#define CALLED_PER_SECOND (PREENFM_FREQUENCY / (float)BLOCK_SIZE)
 
-#define CALLED_PER_SECOND (PREENFM_FREQUENCY / 32.0f)
+// Sum of carrier envelopes under which a released voice is not rendered anymore (~ -60dB)
+#define RELEASE_TAIL_THRESHOLD .001f
 
 // Static to all 6 instrument
 uint32_t Timbre::voiceIndex_;
@@ -91,6 +119,7 @@ inline static int __canTranspose( int _direction ) {
 enum NewNoteType {
     NEW_NOTE_FREE = 0,
     NEW_NOTE_RELEASE,
+    NEW_NOTE_QUIET,
     NEW_NOTE_OLD,
     NEW_NOTE_NONE
 };
@@ -118,7 +147,7 @@ const uint8_t midi_clock_tick_per_step[17]  = {
   192, 144, 96, 72, 64, 48, 36, 32, 24, 16, 12, 8, 6, 4, 3, 2, 1
 };
 
-extern float noise[32];
+extern float noise[BLOCK_SIZE];
 
 float panTable[]  = {
         0.0000, 0.0007, 0.0020, 0.0036, 0.0055, 0.0077, 0.0101, 0.0128, 0.0156, 0.0186,
@@ -237,9 +266,18 @@ Timbre::Timbre() {
 
     recomputeNext_ = true;
     currentGate_ = 0;
-    sbMax_ = &sampleBlock_[64];
+    sbMax_ = &sampleBlock_[BLOCK_SIZE * 2];
     holdPedal_ = false;
     lastPlayedNote_ = 0;
+    for (int r = 0; r < VOICE_STEAL_NUMBER_OF_REASONS; r++) {
+        voiceStealCount_[r] = 0;
+    }
+    paramsVersion_ = 0;
+    controlUpdates_ = 0;
+    for (int r = 0; r < NUMBER_OF_ROWS; r++) {
+        paramsToApply_[r] = 0;
+    }
+    paramsToApplyPending_ = false;
     // arpegiator
     setNewBPMValue(90);
     arpegiatorStep_ = 0.0;
@@ -286,17 +324,27 @@ void Timbre::init(SynthState *synthState, int timbreNumber) {
         lfoUSed_[lfo] = 0;
     }
 
+    struct LfoParams *lfoParams[] = { &params_.lfoOsc1, &params_.lfoOsc2, &params_.lfoOsc3 };
+    sharedLfoMatrix_.init(&params_.matrixRowState1);
+    sharedLfoMatrix_.resetSources();
+    sharedLfoMatrix_.resetAllDestination();
+    for (int lfo = 0; lfo < NUMBER_OF_LFO_OSC; lfo++) {
+        float *phase = &((float*) &params_.lfoPhases.phaseLfo1)[lfo];
+        sharedLfoOsc_[lfo].init(lfoParams[lfo], phase, &sharedLfoMatrix_, (SourceEnum) (MATRIX_SOURCE_LFO1 + lfo), (DestinationEnum) (LFO1_FREQ + lfo));
+        lfoShared_[lfo] = false;
+    }
+    unisonMatrixShared_ = false;
+    unisonSourcesSkipped_ = false;
+
     lowerNote_ = 64;
     lowerNoteReleased_ = true;
 
     /** --------------FX init--------------  */
 
-    delayBuffer_ = delayBuffer[timbreNumber_];
-
-    for (int s = 0; s < delayBufferSize; s++) {
-        delayBuffer_[s] = 0;
-    }
-   
+    // No memory until an FX2 type needs it
+    delayArena_.bind(timbreNumber_, &delayBuffer_, &delayBufferSize_);
+    delayArena_.setSize(timbreNumber_, 0, 0);
+    prevFx2Type = FILTER2_OFF;
 }
 
 void Timbre::setVoiceNumber(int v, int n) {
@@ -306,6 +354,38 @@ void Timbre::setVoiceNumber(int v, int n) {
     }
 }
 
+// A voice is available without stealing : idle or already playing this note
+bool Timbre::hasFreeVoice(char note) {
+    for (int k = 0; k < numberOfVoices_; k++) {
+        int n = voiceNumber_[k];
+        if (voices_[n]->isNewNotePending()) {
+            continue;
+        }
+        if (!voices_[n]->isPlaying() || voices_[n]->getNote() == note) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Called by the synth at the beginning of a block
+void Timbre::borrowVoice(int n) {
+    setVoiceNumber(numberOfVoices_, n);
+    numberOfVoicesChanged(numberOfVoices_ + 1);
+}
+
+void Timbre::giveBackVoice(int k) {
+    int n = voiceNumber_[k];
+    int last = numberOfVoices_ - 1;
+    voiceNumber_[k] = voiceNumber_[last];
+    voiceNumber_[last] = -1;
+    numberOfVoicesChanged(last);
+    // fxAfterBlock must not use a voice from another timbre, and needs a voice when the last one goes
+    if (lastPlayedNote_ == n) {
+        lastPlayedNote_ = last > 0 ? voiceNumber_[0] : 0;
+    }
+}
+
 void Timbre::initVoicePointer(int n, Voice *voice) {
     voices_[n] = voice;
 }
@@ -358,19 +438,21 @@ void Timbre::noteOffMPE(uint8_t channel, uint8_t note, uint8_t velocityOff) {
 
 
 void Timbre::preenNoteOn(char note, char velocity) {
+    // Before the scaleFrequencies look up
+    note &= 0x7f;
+
     // NumberOfVoice = 0 or no mapping in scala frequencies
     if (unlikely(numberOfVoices_ == 0 || mixerState_->instrumentState_[timbreNumber_].scaleFrequencies[(int) note] == 0.0f)) {
         return;
     }
 
-    note &= 0x7f;
-
     int iNov = params_.engine1.playMode == PLAY_MODE_POLY ? (int) numberOfVoices_ : 1;
 
     // Frequency depends on the current instrument scale
     float noteFrequency = mixerState_->instrumentState_[timbreNumber_].scaleFrequencies[(int) note];
 
     uint32_t indexMin = UINT32_MAX;
+    float levelMin = 1000.0f;
     int voiceToUse = -1;
 
     int newNoteType = NEW_NOTE_NONE;
@@ -411,9 +493,10 @@ void Timbre::preenNoteOn(char note, char velocity) {
                 voiceToUse = n;
                 newNoteType = NEW_NOTE_FREE;
             } else if (voices_[n]->isReleased()) {
-                uint32_t indexVoice = voices_[n]->getIndex();
-                if (indexVoice < indexMin) {
-                    indexMin = indexVoice;
+                // The quietest released voice
+                float level = voices_[n]->getCarrierEnvLevel();
+                if (level < levelMin) {
+                    levelMin = level;
                     voiceToUse = n;
                     newNoteType = NEW_NOTE_RELEASE;
                 }
@@ -421,6 +504,23 @@ void Timbre::preenNoteOn(char note, char velocity) {
         }
     }
 
+    if (voiceToUse == -1) {
+        // The quietest voice, a voice in its attack is probably not the quietest for long
+        for (int k = 0; k < iNov; k++) {
+            // voice number k of timbre
+            int n = voiceNumber_[k];
+            if (voices_[n]->isNewNotePending() || voices_[n]->isInAttack()) {
+                continue;
+            }
+            float level = voices_[n]->getCarrierEnvLevel();
+            if (level < levelMin) {
+                newNoteType = NEW_NOTE_QUIET;
+                levelMin = level;
+                voiceToUse = n;
+            }
+        }
+    }
+
     if (voiceToUse == -1) {
         for (int k = 0; k < iNov; k++) {
             // voice number k of timbre
@@ -436,6 +536,18 @@ void Timbre::preenNoteOn(char note, char velocity) {
     // All voices in newnotepending state ?
     if (voiceToUse != -1) {
 
+        switch (newNoteType) {
+            case NEW_NOTE_RELEASE:
+                voiceStealCount_[VOICE_STEAL_RELEASED]++;
+                break;
+            case NEW_NOTE_QUIET:
+                voiceStealCount_[VOICE_STEAL_QUIETEST]++;
+                break;
+            case NEW_NOTE_OLD:
+                voiceStealCount_[VOICE_STEAL_OLDEST]++;
+                break;
+        }
+
         if (likely(params_.engine1.playMode != PLAY_MODE_UNISON)) {
             preenNoteOnUpdateMatrix(voiceToUse, note, velocity);
 
@@ -444,6 +556,7 @@ void Timbre::preenNoteOn(char note, char velocity) {
                     voices_[voiceToUse]->noteOn(note, noteFrequency, velocity, voiceIndex_++);
                     break;
                 case NEW_NOTE_OLD:
+                case NEW_NOTE_QUIET:
                 case NEW_NOTE_RELEASE:
                     voices_[voiceToUse]->noteOnWithoutPop(note, noteFrequency, velocity, voiceIndex_++);
                     break;
@@ -463,6 +576,7 @@ void Timbre::preenNoteOn(char note, char velocity) {
                         voices_[n]->noteOn(note, noteFrequencyUnison, velocity, voiceIndex_++, unisonPhase[k]);
                         break;
                     case NEW_NOTE_OLD:
+                    case NEW_NOTE_QUIET:
                     case NEW_NOTE_RELEASE:
                         voices_[n]->noteOnWithoutPop(note, noteFrequencyUnison, velocity, voiceIndex_++, unisonPhase[k]);
                         break;
@@ -621,8 +735,43 @@ void Timbre::cleanNextBlock() {
 }
 
 void Timbre::prepareMatrixForNewBlock() {
+    controlUpdates_ = 0;
+
+    // Shared LFO are computed once here, the voices copy the value
+    for (int lfo = 0; lfo < NUMBER_OF_LFO_OSC; lfo++) {
+        if (lfoShared_[lfo] && isLfoUsed(lfo)) {
+            sharedLfoOsc_[lfo].nextValueInMatrix();
+        }
+    }
+
+    if (unlikely(numberOfVoices_ == 0)) {
+        return;
+    }
+
+    Voice *firstVoice = voices_[voiceNumber_[0]];
+    if (unlikely(params_.engine1.playMode == PLAY_MODE_UNISON && unisonMatrixShared_ && firstVoice->isPlaying())) {
+        // All unison voices play the same note with the same LFOs and envelopes, only the frequency
+        // and the pan differ : the first voice computes the sources and the matrix, the others copy its destinations
+        firstVoice->prepareMatrixForNewBlock(voiceNumber_[0] == lastPlayedNote_);
+        for (int k = 1; k < numberOfVoices_; k++) {
+            voices_[voiceNumber_[k]]->prepareMatrixForNewBlock(firstVoice);
+        }
+        unisonSourcesSkipped_ = true;
+        return;
+    }
+
+    if (unlikely(unisonSourcesSkipped_)) {
+        // Left unison : the other voices continue from the sources of the first one
+        for (int k = 1; k < numberOfVoices_; k++) {
+            voices_[voiceNumber_[k]]->copyMatrixSources(firstVoice);
+        }
+        unisonSourcesSkipped_ = false;
+    }
+
     for (int k = 0; k < numberOfVoices_; k++) {
-        voices_[voiceNumber_[k]]->prepareMatrixForNewBlock();
+        int n = voiceNumber_[k];
+        // fxAfterBlock uses the matrix of the last played voice even when it's not playing anymore
+        voices_[n]->prepareMatrixForNewBlock(n == lastPlayedNote_);
     }
 }
 
@@ -688,6 +837,8 @@ uint8_t Timbre::voicesNextBlock() {
                         otherSide =! otherSide;
                     }
                 }
+                // pans params are not the same for all unison voices
+                voices_[v]->mixOscsAndPansDirty = true;
                 voices_[v]->nextBlock();
 
                 if (vv > 0) {
@@ -720,6 +871,12 @@ uint8_t Timbre::voicesNextBlock() {
                 voices_[v]->nextBlock();
                 voices_[v]->fxAfterBlock();
                 numberOfPlayingVoices_++;
+                // Don't spend CPU on an inaudible release tail
+                if (unlikely(voices_[v]->isReleased() && !voices_[v]->isNewNotePending()
+                    && voices_[v]->getCarrierEnvLevel() < RELEASE_TAIL_THRESHOLD)) {
+                    voices_[v]->killNow();
+                    voiceStealCount_[VOICE_STEAL_RELEASE_TAIL]++;
+                }
             } else {
                 voices_[v]->emptyBuffer();
             }
@@ -749,8 +906,28 @@ void Timbre::fxAfterBlock() {
         mixerGain_ = 0;
         feedbackInput = 0;
         feedback = 0;
-        for (int s = 0; s < delayBufferSize; s++) {
-            delayBuffer_[s] = 0;
+        // The arena clears the memory of the new type
+        if (fx2Type < FILTER2_LAST) {
+            delayArena_.setSize(timbreNumber_, fx2DelayBufferSize[fx2Type][0], fx2DelayBufferSize[fx2Type][1]);
+        } else {
+            delayArena_.setSize(timbreNumber_, 0, 0);
+        }
+    }
+
+    // New type or less memory given to another timbre : the positions and delays of the previous buffer are lost
+    if (unlikely(prevFx2Type != fx2Type || delayBufferSize_ != prevDelayBufferSize)) {
+        prevDelayBufferSize = delayBufferSize_;
+        delaySize1 = 0;
+        delaySize2 = 0;
+        delaySize3 = 0;
+        delayWritePos = 0;
+        delayWritePosF = 0;
+        delayReadPos = 0;
+        delayReadPos2 = 0;
+        loopSize = 20;
+        for (int g = 0; g < 3; g++) {
+            grainTable[g][GRAIN_RAMP] = 1;
+            grainTable[g][GRAIN_POS] = 1;
         }
     }
     prevFx2Type = fx2Type;
@@ -1392,8 +1569,10 @@ void Timbre::fxAfterBlock() {
             feedback = feedbackParam * feedbackZeroZone;
             float feedbackInc = (feedback - currentFeedback) * INV_BLOCK_SIZE;
 
-            float currentDelaySize1 = clamp(delaySize1, 0, delayBufferSize);
-            delaySize1 = clamp(430 + 70 * quadrant,  0, delayBufferSize);
+            const int bufferSize = delayBufferSize_;
+            const int bufferSizeM1 = bufferSize - 1;
+            float currentDelaySize1 = clamp(delaySize1, 0, bufferSize);
+            delaySize1 = clamp(430 + 70 * quadrant,  0, bufferSize);
             float delaySizeInc1 = (delaySize1 - currentDelaySize1) * INV_BLOCK_SIZE;
 
             float *sp = sampleBlock_;
@@ -1451,11 +1630,11 @@ void Timbre::fxAfterBlock() {
                 low3  += f2 * band3;
                 band3 += f2 * ( low2 - low3 - band3);
 
-                delayWritePos = (delayWritePos + 1) & delayBufferSizeM1;
+                delayWritePos = (delayWritePos + 1) & bufferSizeM1;
                 delayBuffer_[delayWritePos] = low3;
 
-                delayReadPos = modulo2(delayWritePos - currentDelaySize1, delayBufferSize);
-                delayOut1 = delayInterpolation(delayReadPos, delayBuffer_, delayBufferSizeM1);
+                delayReadPos = modulo2(delayWritePos - currentDelaySize1, bufferSize);
+                delayOut1 = delayInterpolation(delayReadPos, delayBuffer_, bufferSizeM1);
 
                 shifterIn = clamp(low1 - delayOut1, -1.f, 1.f);
 
@@ -1647,7 +1826,8 @@ void Timbre::fxAfterBlock() {
             }
         }
         break;
-        case FILTER2_DELAYCRUNCH: {
+        case FILTER2_DELAYCRUNCH:
+        case FILTER2_LONGCRUNCH: {
             mixerGain_ = 0.02f * gainTmp + .98f * mixerGain_;
             float mixerGain_01 = clamp(mixerGain_, 0, 1);
             int mixerGain255 = mixerGain_01 * 255;
@@ -1668,12 +1848,18 @@ void Timbre::fxAfterBlock() {
 
             feedback = param2S * 1.2f;
 
-            const float sampleRateDivide = 4;
+            const int bufferSize = delayBufferSize_;
+            const int bufferSizeM1 = bufferSize - 1;
+            // The long type keeps its delay time with less memory : the buffer is written at a lower rate
+            const float timeScale = bufferSize * (1.0f / fx2DelayBufferSize[fx2Type][0]);
+            const float delaySizeRange = (fx2DelayBufferSize[fx2Type][0] - 16) * timeScale;
+
+            const float sampleRateDivide = 4 / timeScale;
             const float sampleRateDivideInv = 1 / sampleRateDivide;
             float inputIncCount = 0;
 
-            float currentDelaySize1 = clamp(delaySize1, 0, delayBufferSize);
-            delaySize1 = 1.f + (delayBufferSize - 16) * clamp(param1S + (matrixFilterFrequencyS * 0.0625f), 0.f, 1.f);
+            float currentDelaySize1 = clamp(delaySize1, 0, bufferSize);
+            delaySize1 = 1.f + delaySizeRange * clamp(param1S + (matrixFilterFrequencyS * 0.0625f), 0.f, 1.f);
             float delaySizeInc1 = (delaySize1 - currentDelaySize1) * sampleRateDivideInv * INV_BLOCK_SIZE;
 
             // hp input
@@ -1704,7 +1890,7 @@ void Timbre::fxAfterBlock() {
                     float monoIn = (*sp + *(sp + 1)) * 0.5f;
 
                     inputIncCount = 0;
-                    delayWritePos = (delayWritePos + 1) & delayBufferSizeM1;
+                    delayWritePos = (delayWritePos + 1) & bufferSizeM1;
                     delayWritePosF = (float) delayWritePos;
                     
                     // hp
@@ -1740,8 +1926,8 @@ void Timbre::fxAfterBlock() {
                     delayBuffer_[delayWritePos] = hb5_y1;
                 }
 
-                delayReadPos = modulo2(delayWritePosF - currentDelaySize1, delayBufferSize);
-                delayOut1 = delayInterpolation(delayReadPos, delayBuffer_, delayBufferSizeM1);
+                delayReadPos = modulo2(delayWritePosF - currentDelaySize1, bufferSize);
+                delayOut1 = delayInterpolation(delayReadPos, delayBuffer_, bufferSizeM1);
                 delayWritePosF += sampleRateDivideInv;
 
                 // lp 
@@ -1769,7 +1955,8 @@ void Timbre::fxAfterBlock() {
             }
         }
         break;
-        case FILTER2_PINGPONG: {
+        case FILTER2_PINGPONG:
+        case FILTER2_LONGPINGPONG: {
             mixerGain_ = 0.02f * gainTmp + .98f * mixerGain_;
             float mixerGain_01 = clamp(mixerGain_, 0, 1);
             int mixerGain255 = mixerGain_01 * 255;
@@ -1790,15 +1977,21 @@ void Timbre::fxAfterBlock() {
 
             feedback = param2S * 1.22f;
 
-            const float sampleRateDivide = 4;
+            const int bufferSize = delayBufferSize_;
+            const int bufferSizeM1 = bufferSize - 1;
+            // The long type keeps its delay time with less memory : the buffer is written at a lower rate
+            const float timeScale = bufferSize * (1.0f / fx2DelayBufferSize[fx2Type][0]);
+            const float delaySizeRange = (fx2DelayBufferSize[fx2Type][0] - 16) * timeScale;
+
+            const float sampleRateDivide = 4 / timeScale;
             const float sampleRateDivideInv = 1 / sampleRateDivide;
             float inputIncCount = 0;
 
-            float currentDelaySize1 = clamp(delaySize1, 0, delayBufferSizeF);
-            delaySize1 = 1.f + (delayBufferSize - 16) * clamp(param1S + (matrixFilterFrequencyS * 0.0625f), 0.f, 1.f);
+            float currentDelaySize1 = clamp(delaySize1, 0, bufferSize);
+            delaySize1 = 1.f + delaySizeRange * clamp(param1S + (matrixFilterFrequencyS * 0.0625f), 0.f, 1.f);
             float delaySizeInc1 = (delaySize1 - currentDelaySize1) * sampleRateDivideInv * INV_BLOCK_SIZE;
 
-            float currentDelaySize2 = clamp(delaySize2, 0, delayBufferSizeF);
+            float currentDelaySize2 = clamp(delaySize2, 0, bufferSize);
             delaySize2 = delaySize1 * 0.5f;
             float delaySizeInc2 = (delaySize2 - currentDelaySize2) * sampleRateDivideInv * INV_BLOCK_SIZE;
 
@@ -1830,7 +2023,7 @@ void Timbre::fxAfterBlock() {
                     float monoIn = (*sp + *(sp + 1)) * 0.5f;
 
                     inputIncCount = 0;
-                    delayWritePos = (delayWritePos + 1) & delayBufferSizeM1;
+                    delayWritePos = (delayWritePos + 1) & bufferSizeM1;
                     delayWritePosF = (float) delayWritePos;
 
                     low1  += f * band1;
@@ -1865,10 +2058,10 @@ void Timbre::fxAfterBlock() {
                     delayBuffer_[delayWritePos] = hb5_y1;
                 }
 
-                delayReadPos = modulo2(delayWritePosF - currentDelaySize1, delayBufferSize);
-                delayOut1 = delayInterpolation(delayReadPos, delayBuffer_, delayBufferSizeM1);
-                delayReadPos = modulo2(delayWritePosF - currentDelaySize2, delayBufferSize);
-                delayOut2 = delayInterpolation(delayReadPos, delayBuffer_, delayBufferSizeM1);
+                delayReadPos = modulo2(delayWritePosF - currentDelaySize1, bufferSize);
+                delayOut1 = delayInterpolation(delayReadPos, delayBuffer_, bufferSizeM1);
+                delayReadPos = modulo2(delayWritePosF - currentDelaySize2, bufferSize);
+                delayOut2 = delayInterpolation(delayReadPos, delayBuffer_, bufferSizeM1);
 
                 feedbackInput = delayOut1;
 
@@ -2098,7 +2291,8 @@ void Timbre::fxAfterBlock() {
             }
         }
         break;
-        case FILTER2_GRAIN1: {
+        case FILTER2_GRAIN1:
+        case FILTER2_LONGGRAIN1: {
             mixerGain_ = 0.02f * gainTmp + .98f * mixerGain_;
             float mixerGain_01 = clamp(mixerGain_, 0, 1);
             int mixerGain255 = mixerGain_01 * 255;
@@ -2125,7 +2319,14 @@ void Timbre::fxAfterBlock() {
                 param2S = 0.05f * param2 + 0.95f * param2S;
             }
 
-            const float sampleRateDivide = 4;
+            const int bufferSize = delayBufferSize_;
+            const int bufferSizeM1 = bufferSize - 1;
+            // The grain sizes and the loop are in samples of delayBufferSize, scaled to the buffer.
+            // The long type keeps its windows with less memory : the buffer is written at a lower rate
+            const float grainScale = bufferSize * (1.0f / delayBufferSize);
+            const float timeScale = bufferSize * (1.0f / fx2DelayBufferSize[fx2Type][0]);
+
+            const float sampleRateDivide = 4 / timeScale;
             const float sampleRateDivideInv = 1 / sampleRateDivide;
             float inputIncCount = 0;
 
@@ -2144,18 +2345,18 @@ void Timbre::fxAfterBlock() {
                     float param2sq = sqrt3(param2S);
                     float grainRate = sampleRateDivideInv * (1 + jitter * noise[4] * 0.0025f);
                     grainTable[grainNext][GRAIN_RAMP] = 0;
-                    grainTable[grainNext][GRAIN_SIZE] = clamp((1800 + (noise[2]) * 40 * jitter * jitter) * param1S * param1S, 432, delayBufferSize - 100);
-                    grainTable[grainNext][GRAIN_POS] = modulo2(delayWritePosF - (400 + param2sq * noise[5] * 1290), delayBufferSize);
+                    grainTable[grainNext][GRAIN_SIZE] = clamp((1800 + (noise[2]) * 40 * jitter * jitter) * param1S * param1S, 432, delayBufferSize - 100) * grainScale;
+                    grainTable[grainNext][GRAIN_POS] = modulo2(delayWritePosF - (400 + param2sq * noise[5] * 1290) * grainScale, bufferSize);
                     float invGrainSize = 1 / grainTable[grainNext][GRAIN_SIZE];
                     grainTable[grainNext][GRAIN_CURRENT_SHIFT] = grainTable[grainNext][GRAIN_NEXT_SHIFT];
                     grainTable[grainNext][GRAIN_NEXT_SHIFT] = grainRate * invGrainSize;
-                    grainTable[grainNext][GRAIN_INC] = clamp( (grainTable[grainNext][GRAIN_NEXT_SHIFT] - grainTable[grainNext][GRAIN_CURRENT_SHIFT]) * invGrainSize, 0, 0.5f);
+                    grainTable[grainNext][GRAIN_INC] = clamp( (grainTable[grainNext][GRAIN_NEXT_SHIFT] - grainTable[grainNext][GRAIN_CURRENT_SHIFT]) * invGrainSize * timeScale, 0, 0.5f);
                     grainTable[grainNext][GRAIN_VOL] = clamp( 0.25f + sqrt3(fabsf(noise[3])), 0, 1);
                     grainTable[grainNext][GRAIN_PAN] = clamp(1 + (noise[6]) * param2sq, 0, 2) * 0.5f;
                     grainPrev = grainNext;
 
                     if(lockB < 0.02f) {
-                        loopSize = clamp((1 - param1S) * 1400, 48, 1800);
+                        loopSize = clamp((1 - param1S) * 1400, 48, 1800) * grainScale;
                     }
                 }
                 if(++grainNext > 2) {
@@ -2182,11 +2383,11 @@ void Timbre::fxAfterBlock() {
                 if (++inputIncCount >= sampleRateDivide)
                 {
                     inputIncCount = 0;
-                    delayWritePos = (delayWritePos + 1) & delayBufferSizeM1;
+                    delayWritePos = (delayWritePos + 1) & bufferSizeM1;
                     delayWritePosF = (float)delayWritePos;
 
-                    delayReadPos = modulo(delayWritePos + loopSize, delayBufferSize);
-                    float feedbackIn = delayInterpolation(delayReadPos, delayBuffer_, delayBufferSizeM1);
+                    delayReadPos = modulo(delayWritePos + loopSize, bufferSize);
+                    float feedbackIn = delayInterpolation(delayReadPos, delayBuffer_, bufferSizeM1);
 
                     monoIn = (*sp + *(sp + 1)) * 0.5f;
 
@@ -2203,9 +2404,9 @@ void Timbre::fxAfterBlock() {
                 grain1L = grain1R = 0;
                 if (grainTable[0][GRAIN_RAMP] < 1)
                 {
-                    delayReadPos = modulo(grainTable[0][GRAIN_POS] + grainTable[0][GRAIN_RAMP] * grainTable[0][GRAIN_SIZE], delayBufferSize);
+                    delayReadPos = modulo(grainTable[0][GRAIN_POS] + grainTable[0][GRAIN_RAMP] * grainTable[0][GRAIN_SIZE], bufferSize);
                     env = hann(grainTable[0][GRAIN_RAMP]) * grainTable[0][GRAIN_VOL];
-                    grain1 = env * delayInterpolation(delayReadPos, delayBuffer_, delayBufferSizeM1);
+                    grain1 = env * delayInterpolation(delayReadPos, delayBuffer_, bufferSizeM1);
                     grain1L = grain1 * grainTable[0][GRAIN_PAN];
                     grain1R = grain1 - grain1L;
                 }
@@ -2216,9 +2417,9 @@ void Timbre::fxAfterBlock() {
                 grain2L = grain2R = 0;
                 if (grainTable[1][GRAIN_RAMP] < 1)
                 {
-                    delayReadPos = modulo(grainTable[1][GRAIN_POS] + grainTable[1][GRAIN_RAMP] * grainTable[1][GRAIN_SIZE], delayBufferSize);
+                    delayReadPos = modulo(grainTable[1][GRAIN_POS] + grainTable[1][GRAIN_RAMP] * grainTable[1][GRAIN_SIZE], bufferSize);
                     env = hann(grainTable[1][GRAIN_RAMP]) * grainTable[1][GRAIN_VOL];
-                    grain2 = env * delayInterpolation(delayReadPos, delayBuffer_, delayBufferSizeM1);
+                    grain2 = env * delayInterpolation(delayReadPos, delayBuffer_, bufferSizeM1);
                     grain2L = grain2 * grainTable[1][GRAIN_PAN];
                     grain2R = grain2 - grain2L;
                 }
@@ -2229,9 +2430,9 @@ void Timbre::fxAfterBlock() {
                 grain3L = grain3R = 0;
                 if (grainTable[2][GRAIN_RAMP] < 1)
                 {
-                    delayReadPos = modulo(grainTable[2][GRAIN_POS] + grainTable[2][GRAIN_RAMP] * grainTable[2][GRAIN_SIZE], delayBufferSize);
+                    delayReadPos = modulo(grainTable[2][GRAIN_POS] + grainTable[2][GRAIN_RAMP] * grainTable[2][GRAIN_SIZE], bufferSize);
                     env = hann(grainTable[2][GRAIN_RAMP]) * grainTable[2][GRAIN_VOL];
-                    grain3 = env * delayInterpolation(delayReadPos, delayBuffer_, delayBufferSizeM1);
+                    grain3 = env * delayInterpolation(delayReadPos, delayBuffer_, bufferSizeM1);
                     grain3L = grain3 * grainTable[2][GRAIN_PAN];
                     grain3R = grain3 - grain3L;
                 }
@@ -2277,7 +2478,8 @@ void Timbre::fxAfterBlock() {
         }
 
         break;
-        case FILTER2_GRAIN2: {
+        case FILTER2_GRAIN2:
+        case FILTER2_LONGGRAIN2: {
             mixerGain_ = 0.02f * gainTmp + .98f * mixerGain_;
             float mixerGain_01 = clamp(mixerGain_, 0, 1);
             int mixerGain255 = mixerGain_01 * 255;
@@ -2305,7 +2507,14 @@ void Timbre::fxAfterBlock() {
                 param1S = 0.005f * fabs(this->params_.effect2.param1 + matrixFilterFrequency) + .995f * param1S;
             }
 
-            const float sampleRateDivide = 4;
+            const int bufferSize = delayBufferSize_;
+            const int bufferSizeM1 = bufferSize - 1;
+            // The grain sizes and the loop are in samples of delayBufferSize, scaled to the buffer.
+            // The long type keeps its windows with less memory : the buffer is written at a lower rate
+            const float grainScale = bufferSize * (1.0f / delayBufferSize);
+            const float timeScale = bufferSize * (1.0f / fx2DelayBufferSize[fx2Type][0]);
+
+            const float sampleRateDivide = 4 / timeScale;
             const float sampleRateDivideInv = 1 / sampleRateDivide;
             float inputIncCount = 0;
 
@@ -2323,18 +2532,18 @@ void Timbre::fxAfterBlock() {
                     float param2sq = sqrt3(param2S);
                     float grainRate = sampleRateDivideInv * clamp(0.5f + param1S + param2S * noise[4] * 0.025f, 0, 2);
                     grainTable[grainNext][GRAIN_RAMP] = 0;
-                    grainTable[grainNext][GRAIN_SIZE] = clamp((1800 + (noise[2]) * 40 * param2S * param2S) * param1S * param1S, 432, delayBufferSize - 100);
-                    grainTable[grainNext][GRAIN_POS] = modulo2(delayWritePosF - (800 + param2sq * noise[5] * 390 * (1.25f - param1S)), delayBufferSize);
+                    grainTable[grainNext][GRAIN_SIZE] = clamp((1800 + (noise[2]) * 40 * param2S * param2S) * param1S * param1S, 432, delayBufferSize - 100) * grainScale;
+                    grainTable[grainNext][GRAIN_POS] = modulo2(delayWritePosF - (800 + param2sq * noise[5] * 390 * (1.25f - param1S)) * grainScale, bufferSize);
                     float invGrainSize = 1 / grainTable[grainNext][GRAIN_SIZE];
                     grainTable[grainNext][GRAIN_CURRENT_SHIFT] = grainTable[grainNext][GRAIN_NEXT_SHIFT];
                     grainTable[grainNext][GRAIN_NEXT_SHIFT] = grainRate * invGrainSize;
-                    grainTable[grainNext][GRAIN_INC] = clamp( (grainTable[grainNext][GRAIN_NEXT_SHIFT] - grainTable[grainNext][GRAIN_CURRENT_SHIFT]) * invGrainSize, 0, 0.5f);
+                    grainTable[grainNext][GRAIN_INC] = clamp( (grainTable[grainNext][GRAIN_NEXT_SHIFT] - grainTable[grainNext][GRAIN_CURRENT_SHIFT]) * invGrainSize * timeScale, 0, 0.5f);
                     grainTable[grainNext][GRAIN_VOL] = clamp( 0.25f + sqrt3(fabsf(noise[3])), 0, 1);
                     grainTable[grainNext][GRAIN_PAN] = clamp(1 + (noise[6]) * param2sq, 0, 2) * 0.5f;
                     grainPrev = grainNext;
 
                     if(lockB < 0.02f) {
-                        loopSize = clamp((1 - param1S) * 1400, 48, 1800);
+                        loopSize = clamp((1 - param1S) * 1400, 48, 1800) * grainScale;
                     }
                 }
                 if(++grainNext > 2) {
@@ -2360,11 +2569,11 @@ void Timbre::fxAfterBlock() {
                 if (++inputIncCount >= sampleRateDivide)
                 {
                     inputIncCount = 0;
-                    delayWritePos = (delayWritePos + 1) & delayBufferSizeM1;
+                    delayWritePos = (delayWritePos + 1) & bufferSizeM1;
                     delayWritePosF = (float)delayWritePos;
 
-                    delayReadPos = modulo(delayWritePos + loopSize, delayBufferSize);
-                    float feedbackIn = delayInterpolation(delayReadPos, delayBuffer_, delayBufferSizeM1);
+                    delayReadPos = modulo(delayWritePos + loopSize, bufferSize);
+                    float feedbackIn = delayInterpolation(delayReadPos, delayBuffer_, bufferSizeM1);
 
                     // hp
                     float hp_in_x0 = (*sp + *(sp + 1)) * 0.5f;
@@ -2379,9 +2588,9 @@ void Timbre::fxAfterBlock() {
                 grain1L = grain1R = 0;
                 if (grainTable[0][GRAIN_RAMP] < 1)
                 {
-                    delayReadPos = modulo(grainTable[0][GRAIN_POS] + grainTable[0][GRAIN_RAMP] * grainTable[0][GRAIN_SIZE], delayBufferSize);
+                    delayReadPos = modulo(grainTable[0][GRAIN_POS] + grainTable[0][GRAIN_RAMP] * grainTable[0][GRAIN_SIZE], bufferSize);
                     env = hann(grainTable[0][GRAIN_RAMP]) * grainTable[0][GRAIN_VOL];
-                    grain1 = env * delayInterpolation(delayReadPos, delayBuffer_, delayBufferSizeM1);
+                    grain1 = env * delayInterpolation(delayReadPos, delayBuffer_, bufferSizeM1);
                     grain1L = grain1 * grainTable[0][GRAIN_PAN];
                     grain1R = grain1 - grain1L;
                 }
@@ -2392,9 +2601,9 @@ void Timbre::fxAfterBlock() {
                 grain2L = grain2R = 0;
                 if (grainTable[1][GRAIN_RAMP] < 1)
                 {
-                    delayReadPos = modulo(grainTable[1][GRAIN_POS] + grainTable[1][GRAIN_RAMP] * grainTable[1][GRAIN_SIZE], delayBufferSize);
+                    delayReadPos = modulo(grainTable[1][GRAIN_POS] + grainTable[1][GRAIN_RAMP] * grainTable[1][GRAIN_SIZE], bufferSize);
                     env = hann(grainTable[1][GRAIN_RAMP]) * grainTable[1][GRAIN_VOL];
-                    grain2 = env * delayInterpolation(delayReadPos, delayBuffer_, delayBufferSizeM1);
+                    grain2 = env * delayInterpolation(delayReadPos, delayBuffer_, bufferSizeM1);
                     grain2L = grain2 * grainTable[1][GRAIN_PAN];
                     grain2R = grain2 - grain2L;
                 }
@@ -2405,9 +2614,9 @@ void Timbre::fxAfterBlock() {
                 grain3L = grain3R = 0;
                 if (grainTable[2][GRAIN_RAMP] < 1)
                 {
-                    delayReadPos = modulo(grainTable[2][GRAIN_POS] + grainTable[2][GRAIN_RAMP] * grainTable[2][GRAIN_SIZE], delayBufferSize);
+                    delayReadPos = modulo(grainTable[2][GRAIN_POS] + grainTable[2][GRAIN_RAMP] * grainTable[2][GRAIN_SIZE], bufferSize);
                     env = hann(grainTable[2][GRAIN_RAMP]) * grainTable[2][GRAIN_VOL];
-                    grain3 = env * delayInterpolation(delayReadPos, delayBuffer_, delayBufferSizeM1);
+                    grain3 = env * delayInterpolation(delayReadPos, delayBuffer_, bufferSizeM1);
                     grain3L = grain3 * grainTable[2][GRAIN_PAN];
                     grain3R = grain3 - grain3L;
                 }
@@ -2473,7 +2682,8 @@ float Timbre::iirFilter(float x, float a1, float *xn1, float *xn2, float *yn1, f
 
 float Timbre::delayInterpolation(float readPos, float buffer[], int bufferLenM1) {
     int readPosInt = readPos;
-    float y1 = buffer[readPosInt];
+    // modulo2 can round up to the buffer length
+    float y1 = buffer[readPosInt & bufferLenM1];
     float y0 = buffer[(readPosInt - 1) & bufferLenM1];
     float x = 1 - (readPos - floorf(readPos));
     return (y0 - y1) * x + y1;
@@ -2481,7 +2691,7 @@ float Timbre::delayInterpolation(float readPos, float buffer[], int bufferLenM1)
 
 float Timbre::delayInterpolation2(float readPos, float buffer[], int bufferLenM1, int offset) {
     int readPosInt = readPos;
-    float y1 = buffer[offset + readPosInt];
+    float y1 = buffer[offset + (readPosInt & bufferLenM1)];
     float y0 = buffer[offset + ((readPosInt - 1) & bufferLenM1)];
     float x = 1 - (readPos - floorf(readPos));
     return (y0 - y1) * x + y1;
@@ -2536,7 +2746,7 @@ void Timbre::gateFx() {
         if (gate > 1.0f) {
             gate = 1.0f;
         }
-        float incGate = (gate - currentGate_) * .03125f; // ( *.03125f = / 32)
+        float incGate = (gate - currentGate_) * INV_BLOCK_SIZE;
         // limit the speed.
         if (incGate > 0.002f) {
             incGate = 0.002f;
@@ -2559,6 +2769,7 @@ void Timbre::gateFx() {
 }
 
 void Timbre::afterNewParamsLoad() {
+    paramsChanged();
 
     env1_.applyCurves();
     env2_.applyCurves();
@@ -2570,6 +2781,12 @@ void Timbre::afterNewParamsLoad() {
     for (int k = 0; k < numberOfVoices_; k++) {
         voices_[voiceNumber_[k]]->afterNewParamsLoad();
     }
+    sharedLfoMatrix_.resetSources();
+    for (int j = 0; j < NUMBER_OF_ENCODERS_PFM2; j++) {
+        for (int lfo = 0; lfo < NUMBER_OF_LFO_OSC; lfo++) {
+            sharedLfoOsc_[lfo].valueChanged(j);
+        }
+    }
 
     for (int j = 0; j < NUMBER_OF_ENCODERS_PFM2; j++) {
         env1_.reloadADSR(j);
@@ -2643,6 +2860,95 @@ void Timbre::setNewEffecParam(int encoder) {
 
 }
 
+void Timbre::applyParams() {
+    if (likely(!paramsToApplyPending_)) {
+        return;
+    }
+    paramsToApplyPending_ = false;
+
+    for (int row = 0; row < NUMBER_OF_ROWS; row++) {
+        uint8_t encoders = paramsToApply_[row];
+        if (likely(encoders == 0)) {
+            continue;
+        }
+        paramsToApply_[row] = 0;
+
+        switch (row) {
+            case ROW_EFFECT1:
+                // The type reloads all the params
+                if (encoders & 1) {
+                    setNewEffecParam(0);
+                    continue;
+                }
+                break;
+            case ROW_ENV1_CURVE:
+                env1_.applyCurves();
+                continue;
+            case ROW_ENV2_CURVE:
+                env2_.applyCurves();
+                continue;
+            case ROW_ENV3_CURVE:
+                env3_.applyCurves();
+                continue;
+            case ROW_ENV4_CURVE:
+                env4_.applyCurves();
+                continue;
+            case ROW_ENV5_CURVE:
+                env5_.applyCurves();
+                continue;
+            case ROW_ENV6_CURVE:
+                env6_.applyCurves();
+                continue;
+            case ROW_MIDINOTE1CURVE:
+                updateMidiNoteScale(0);
+                continue;
+            case ROW_MIDINOTE2CURVE:
+                updateMidiNoteScale(1);
+                continue;
+        }
+
+        for (int encoder = 0; encoder < NUMBER_OF_ENCODERS_PFM2; encoder++) {
+            if (!(encoders & (1 << encoder))) {
+                continue;
+            }
+            switch (row) {
+                case ROW_EFFECT1:
+                    setNewEffecParam(encoder);
+                    break;
+                case ROW_ENV1_TIME:
+                case ROW_ENV1_LEVEL:
+                    env1_.reloadADSR(encoder);
+                    break;
+                case ROW_ENV2_TIME:
+                case ROW_ENV2_LEVEL:
+                    env2_.reloadADSR(encoder);
+                    break;
+                case ROW_ENV3_TIME:
+                case ROW_ENV3_LEVEL:
+                    env3_.reloadADSR(encoder);
+                    break;
+                case ROW_ENV4_TIME:
+                case ROW_ENV4_LEVEL:
+                    env4_.reloadADSR(encoder);
+                    break;
+                case ROW_ENV5_TIME:
+                case ROW_ENV5_LEVEL:
+                    env5_.reloadADSR(encoder);
+                    break;
+                case ROW_ENV6_TIME:
+                case ROW_ENV6_LEVEL:
+                    env6_.reloadADSR(encoder);
+                    break;
+                case ROW_LFOOSC1 ... ROW_LFOOSC3:
+                case ROW_LFOENV1 ... ROW_LFOENV2:
+                case ROW_LFOSEQ1 ... ROW_LFOSEQ2:
+                    lfoValueChange(row, encoder, ((float*) &params_)[row * NUMBER_OF_ENCODERS_PFM2 + encoder]);
+                    break;
+            }
+        }
+    }
+}
+
 // Code bellowed have been adapted by Xavier Hosxe for PreenFM2
 // It come from Muteable Instrument midiPAL
 
@@ -2852,6 +3158,10 @@ void Timbre::StepArpeggio() {
     } else {
         // NOTE: We always count [0 - num_notes) here; the actual handling of direction is in Tick()
 
+        // Notes released since the last step : start_step_ must stay in the stack
+        if (start_step_ >= num_notes) {
+            start_step_ = 0;
+        }
         uint8_t trigger_change = 0;
         if (++current_step_ >= num_notes) {
             current_step_ = 0;
@@ -2930,6 +3240,13 @@ void Timbre::lfoValueChange(int currentRow, int encoder, float newValue) {
     for (int k = 0; k < numberOfVoices_; k++) {
         voices_[voiceNumber_[k]]->lfoValueChange(currentRow, encoder, newValue);
     }
+
+    if (currentRow >= ROW_LFOOSC1 && currentRow <= ROW_LFOOSC3) {
+        sharedLfoOsc_[currentRow - ROW_LFOOSC1].valueChanged(encoder);
+        if (encoder == ENCODER_LFO_KSYNC) {
+            updateLfoShared();
+        }
+    }
 }
 
 void Timbre::updateMidiNoteScale(int scale) {
@@ -3043,6 +3360,11 @@ void Timbre::midiClockContinue(int songPosition) {
     for (int k = 0; k < numberOfVoices_; k++) {
         voices_[voiceNumber_[k]]->midiClockContinue(songPosition);
     }
+    for (int lfo = 0; lfo < NUMBER_OF_LFO_OSC; lfo++) {
+        if (lfoShared_[lfo]) {
+            sharedLfoOsc_[lfo].midiClock(songPosition, false);
+        }
+    }
 
     recomputeNext_ = ((songPosition & 0x1) == 0);
     OnMidiContinue();
@@ -3053,6 +3375,11 @@ void Timbre::midiClockStart() {
     for (int k = 0; k < numberOfVoices_; k++) {
         voices_[voiceNumber_[k]]->midiClockStart();
     }
+    for (int lfo = 0; lfo < NUMBER_OF_LFO_OSC; lfo++) {
+        if (lfoShared_[lfo]) {
+            sharedLfoOsc_[lfo].midiContinue();
+        }
+    }
 
     recomputeNext_ = true;
     OnMidiStart();
@@ -3063,6 +3390,11 @@ void Timbre::midiClockSongPositionStep(int songPosition) {
     for (int k = 0; k < numberOfVoices_; k++) {
         voices_[voiceNumber_[k]]->midiClockSongPositionStep(songPosition, recomputeNext_);
     }
+    for (int lfo = 0; lfo < NUMBER_OF_LFO_OSC; lfo++) {
+        if (lfoShared_[lfo]) {
+            sharedLfoOsc_[lfo].midiClock(songPosition, recomputeNext_);
+        }
+    }
 
     if ((songPosition & 0x1) == 0) {
         recomputeNext_ = true;
@@ -3145,6 +3477,8 @@ void Timbre::verifyLfoUsed(int encoder, float oldValue, float newValue) {
         }
     }
 
+    updateLfoShared();
+
     /*
      lcd.setCursor(11, 1);
      lcd.print('>');
@@ -3155,3 +3489,48 @@ void Timbre::verifyLfoUsed(int encoder, float oldValue, float newValue) {
      */
 
 }
+
+void Timbre::updateLfoShared() {
+    MatrixRowParams *matrixRows = &params_.matrixRowState1;
+    LfoParams *lfoParams = &params_.lfoOsc1;
+
+    for (int lfo = 0; lfo < NUMBER_OF_LFO_OSC; lfo++) {
+        // KSyn Off : the LFO is never restarted by a noteOn
+        bool shared = lfoParams[lfo].keybRamp < 0.0f;
+
+        // Frequency modulated by the matrix can be different for each voice
+        for (int r = 0; r < MATRIX_SIZE && shared; r++) {
+            if (matrixRows[r].source != MATRIX_SOURCE_NONE
+                && ((int) matrixRows[r].dest1 == LFO1_FREQ + lfo || (int) matrixRows[r].dest2 == LFO1_FREQ + lfo)) {
+                shared = false;
+            }
+        }
+        lfoShared_[lfo] = shared;
+    }
+
+    // Random, MPE and poly aftertouch are set per voice, free running LFO keep the phase of the previous notes
+    bool unisonMatrixShared = true;
+    for (int r = 0; r < MATRIX_SIZE && unisonMatrixShared; r++) {
+        switch ((int) matrixRows[r].source) {
+            case MATRIX_SOURCE_LFO1:
+            case MATRIX_SOURCE_LFO2:
+            case MATRIX_SOURCE_LFO3: {
+                int lfo = (int) matrixRows[r].source - MATRIX_SOURCE_LFO1;
+                unisonMatrixShared = lfoShared_[lfo] || lfoParams[lfo].keybRamp >= 0.0f;
+                break;
+            }
+            case MATRIX_SOURCE_MPESLIDE:
+            case MATRIX_SOURCE_RANDOM:
+            case MATRIX_SOURCE_POLYPHONIC_AFTERTOUCH:
+            case MATRIX_SOURCE_PITCHBEND_MPE:
+            case MATRIX_SOURCE_AFTERTOUCH_MPE:
+                unisonMatrixShared = false;
+                break;
+        }
+    }
+#ifdef UNISON_MATRIX_PER_VOICE
+    // scripts/unisonMatrixTest.sh compares with the matrix of each voice
+    unisonMatrixShared = false;
+#endif
+    unisonMatrixShared_ = unisonMatrixShared;
+}
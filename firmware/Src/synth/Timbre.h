@@ -28,6 +28,7 @@
 #include "LfoEnv2.h"
 #include "LfoStepSeq.h"
 #include "Matrix.h"
+#include "DelayArena.h"
 #include "note_stack.h"
 #include "event_scheduler.h"
 
@@ -40,6 +41,18 @@ enum {
     CLOCK_EXTERNAL
 };
 
+// Why a playing voice was taken
+enum VoiceStealReason {
+    VOICE_STEAL_RELEASED = 0,
+    VOICE_STEAL_QUIETEST,
+    VOICE_STEAL_OLDEST,
+    // Inaudible release tail stopped
+    VOICE_STEAL_RELEASE_TAIL,
+    // Voice taken from another timbre by the voice pool
+    VOICE_STEAL_POOL,
+    VOICE_STEAL_NUMBER_OF_REASONS
+};
+
 class Timbre {
     friend class Synth;
     friend class Voice;
@@ -59,6 +72,12 @@ public:
     void afterNewParamsLoad();
     void setNewValue(int index, struct ParameterDisplay *param, float newValue);
     void setNewEffecParam(int encoder);
+    // Params whose change is applied once at the beginning of the next block, only the last value counts
+    void paramToApply(int row, int encoder) {
+        paramsToApply_[row] |= 1 << encoder;
+        paramsToApplyPending_ = true;
+    }
+    void applyParams();
     int getSeqStepValue(int whichStepSeq, int step);
     void setSeqStepValue(int whichStepSeq, int step, int value);
     // Arpegiator
@@ -94,6 +113,11 @@ public:
         numberOfVoices_ = newNumberOfVoices;
     }
 
+    // Voice pool
+    bool hasFreeVoice(char note);
+    void borrowVoice(int n);
+    void giveBackVoice(int k);
+
     void lfoValueChange(int currentRow, int encoder, float newValue);
 
     void setHoldPedal(int value);
@@ -137,6 +161,28 @@ public:
         return lfoUSed_[lfo] > 0;
     }
 
+    // Free running LFO OSC are computed once per timbre and copied in the voices matrix
+    bool isLfoShared(int lfo) {
+        return lfoShared_[lfo];
+    }
+    float getSharedLfoValue(int lfo) {
+        return sharedLfoMatrix_.getSource((SourceEnum) (MATRIX_SOURCE_LFO1 + lfo));
+    }
+    void updateLfoShared();
+
+    uint32_t getVoiceStealCount(int reason) {
+        return voiceStealCount_[reason];
+    }
+
+    // The voices recompute their modulation indexes, mix and pans after a param change
+    void paramsChanged() {
+        paramsVersion_++;
+    }
+    // Number of these recomputes during the last block
+    uint16_t getControlUpdates() {
+        return controlUpdates_;
+    }
+
     uint8_t getLowerNote() {
         return lowerNote_;
     }
@@ -187,11 +233,17 @@ private:
     float iirFilter(float x, float a0, float *yn1, float *yn2, float *xn1, float *xn2) ;
 
     int prevFx2Type         = 0;
+    int prevDelayBufferSize = 0;
 
     #define delayBufferSize 2048
 
-    static float delayBuffer[NUMBER_OF_TIMBRES][delayBufferSize];
+    // Delay memory of all timbres, handed out by delayArena_ according to the FX2 type.
+    // Each timbre can always get delayBufferSize, the long delays and grains get more when it's free.
+    static float delayBuffer[NUMBER_OF_TIMBRES * delayBufferSize];
+    static DelayArena delayArena_;
+    // Updated by delayArena_
     float *delayBuffer_;
+    int delayBufferSize_;
 
     float param1S = 0;
     float matrixFilterFrequencyS = 0;
@@ -335,9 +387,24 @@ private:
 
     // lfoUsed
     uint8_t lfoUSed_[NUMBER_OF_LFO];
+    // LFO OSC with KSyn Off and no matrix on their frequency give the same value for all voices
+    bool lfoShared_[NUMBER_OF_LFO_OSC];
+    LfoOsc sharedLfoOsc_[NUMBER_OF_LFO_OSC];
+    // Only receives the shared LFO values, destinations stay to 0
+    Matrix sharedLfoMatrix_;
+    // Unison voices can take the matrix of the first voice : no row uses a source that differs between voices
+    bool unisonMatrixShared_;
+    // The unison voices other than the first did not compute their sources in the last block
+    bool unisonSourcesSkipped_;
     uint8_t lowerNote_;
     float lowerNoteFrequency;
     bool lowerNoteReleased_;
+    uint32_t voiceStealCount_[VOICE_STEAL_NUMBER_OF_REASONS];
+    uint32_t paramsVersion_;
+    // One bit per encoder
+    uint8_t paramsToApply_[NUMBER_OF_ROWS];
+    bool paramsToApplyPending_;
+    uint16_t controlUpdates_;
     // static
     static uint32_t voiceIndex_;
 
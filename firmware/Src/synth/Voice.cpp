@@ -23,6 +23,10 @@
 
 float Voice::glidePhaseInc[13];
 float Voice::mpeBitchBend[6];
+const uint8_t Voice::modulationIndexDestinations[NUMBER_OF_MODULATION_INDEX_DESTINATIONS] = {
+    MTX_DEST_FEEDBACK, INDEX_MODULATION1, INDEX_MODULATION2, INDEX_MODULATION3, INDEX_MODULATION4, INDEX_ALL_MODULATION };
+const uint8_t Voice::mixOscsAndPansDestinations[NUMBER_OF_MIX_AND_PAN_DESTINATIONS] = {
+    MIX_OSC1, MIX_OSC2, MIX_OSC3, MIX_OSC4, ALL_MIX, PAN_OSC1, PAN_OSC2, PAN_OSC3, PAN_OSC4, ALL_PAN };
 
 //for bitwise manipulations
 #define FLOAT2SHORT 32768.f
@@ -37,7 +41,7 @@ float Voice::mpeBitchBend[6];
 #define LP2OFFSET -0.045f
 #define min(a,b)                ((a)<(b)?(a):(b))
 
-extern float noise[32];
+extern float noise[BLOCK_SIZE];
 
 #define filterWindowMin 0.01f
 #define filterWindowMax 0.99f
@@ -397,6 +401,7 @@ void Voice::init() {
     this->holdedByPedal = false;
     this->newNotePlayed = false;
     this->nextMainFrequency = 0.0f;
+    controlValuesChanged();
 }
 
 void Voice::glideToNote(short newNote, float newNoteFrequency) {
@@ -481,6 +486,31 @@ float Voice::getNoteRealFrequencyEstimation(float newNoteFrequency) {
     return currentTimbre->osc1_.getNoteRealFrequencyEstimation(&oscState1_, newNoteFrequency);
 }
 
+// Sum of the carrier envelopes : good enough to know which voice is the quietest
+float Voice::getCarrierEnvLevel() {
+    int *opInfo = algoOpInformation[(int) currentTimbre->params_.engine1.algo];
+    float level = 0.0f;
+    if (opInfo[0] == 1) {
+        level += envState1_.currentValue;
+    }
+    if (opInfo[1] == 1) {
+        level += envState2_.currentValue;
+    }
+    if (opInfo[2] == 1) {
+        level += envState3_.currentValue;
+    }
+    if (opInfo[3] == 1) {
+        level += envState4_.currentValue;
+    }
+    if (opInfo[4] == 1) {
+        level += envState5_.currentValue;
+    }
+    if (opInfo[5] == 1) {
+        level += envState6_.currentValue;
+    }
+    return level;
+}
+
 void Voice::noteOn(short newNote, float newNoteFrequency, short velocity, uint32_t index, float phase) {
 
 
@@ -531,6 +561,7 @@ void Voice::noteOn(short newNote, float newNoteFrequency, short velocity, uint32
     this->velIm4 = currentTimbre->params_.engineIm2.modulationIndexVelo4 * (float) velocity * .0078125f;
     this->velIm5 = currentTimbre->params_.engineIm3.modulationIndexVelo5 * (float) velocity * .0078125f;
     this->velIm6 = currentTimbre->params_.engineIm3.modulationIndexVelo6 * (float) velocity * .0078125f;
+    controlValuesChanged();
 
     int zeroVelo = (16 - currentTimbre->params_.engine1.velocity) * 8;
     int newVelocity = zeroVelo + ((velocity * (128 - zeroVelo)) >> 7);
@@ -683,7 +714,7 @@ void Voice::nextBlock() {
     float env6Inc;
 
     float *sample = sampleBlock;
-    float inv32 = .03125f;
+    float invBlockSize = 1.0f / BLOCK_SIZE;
 
 
     if (unlikely( matrix.getDestination(ALL_OSC_FREQ_HARM) != targetFreqHarm) || currentTimbre->getMPESetting() > 0) {
@@ -727,17 +758,17 @@ void Voice::nextBlock() {
 
             env1Value = this->env1ValueMem;
             envNextValue = currentTimbre->env1_.getNextAmpExp(&envState1_);
-            env1Inc = (envNextValue - env1Value) * inv32;  // divide by 32
+            env1Inc = (envNextValue - env1Value) * invBlockSize;
             this->env1ValueMem = envNextValue;
 
             env2Value = this->env2ValueMem;
             envNextValue = currentTimbre->env2_.getNextAmpExp(&envState2_);
-            env2Inc = (envNextValue - env2Value) * inv32;
+            env2Inc = (envNextValue - env2Value) * invBlockSize;
             this->env2ValueMem = envNextValue;
 
             env3Value = this->env3ValueMem;
             envNextValue = currentTimbre->env3_.getNextAmpExp(&envState3_);
-            env3Inc = (envNextValue - env3Value) * inv32;
+            env3Inc = (envNextValue - env3Value) * invBlockSize;
             this->env3ValueMem = envNextValue;
 
             oscState3_.frequency = oscState3_.mainFrequencyPlusMatrix;
@@ -800,17 +831,17 @@ void Voice::nextBlock() {
 
             env1Value = this->env1ValueMem;
             envNextValue = currentTimbre->env1_.getNextAmpExp(&envState1_);
-            env1Inc = (envNextValue - env1Value) * inv32;  // divide by 32
+            env1Inc = (envNextValue - env1Value) * invBlockSize;
             this->env1ValueMem = envNextValue;
 
             env2Value = this->env2ValueMem;
             envNextValue = currentTimbre->env2_.getNextAmpExp(&envState2_);
-            env2Inc = (envNextValue - env2Value) * inv32;
+            env2Inc = (envNextValue - env2Value) * invBlockSize;
             this->env2ValueMem = envNextValue;
 
             env3Value = this->env3ValueMem;
             envNextValue = currentTimbre->env3_.getNextAmpExp(&envState3_);
-            env3Inc = (envNextValue - env3Value) * inv32;
+            env3Inc = (envNextValue - env3Value) * invBlockSize;
             this->env3ValueMem = envNextValue;
 
             oscState3_.frequency = oscState3_.mainFrequencyPlusMatrix;
@@ -869,22 +900,22 @@ void Voice::nextBlock() {
 
             env1Value = this->env1ValueMem;
             envNextValue = currentTimbre->env1_.getNextAmpExp(&envState1_);
-            env1Inc = (envNextValue - env1Value) * inv32;  // divide by 32
+            env1Inc = (envNextValue - env1Value) * invBlockSize;
             this->env1ValueMem = envNextValue;
 
             env2Value = this->env2ValueMem;
             envNextValue = currentTimbre->env2_.getNextAmpExp(&envState2_);
-            env2Inc = (envNextValue - env2Value) * inv32;
+            env2Inc = (envNextValue - env2Value) * invBlockSize;
             this->env2ValueMem = envNextValue;
 
             env3Value = this->env3ValueMem;
             envNextValue = currentTimbre->env3_.getNextAmpExp(&envState3_);
-            env3Inc = (envNextValue - env3Value) * inv32;
+            env3Inc = (envNextValue - env3Value) * invBlockSize;
             this->env3ValueMem = envNextValue;
 
             env4Value = this->env4ValueMem;
             envNextValue = currentTimbre->env4_.getNextAmpExp(&envState4_);
-            env4Inc = (envNextValue - env4Value) * inv32;
+            env4Inc = (envNextValue - env4Value) * invBlockSize;
             this->env4ValueMem = envNextValue;
 
             oscState2_.frequency = oscState2_.mainFrequencyPlusMatrix;
@@ -954,22 +985,22 @@ void Voice::nextBlock() {
 
             env1Value = this->env1ValueMem;
             envNextValue = currentTimbre->env1_.getNextAmpExp(&envState1_);
-            env1Inc = (envNextValue - env1Value) * inv32;  // divide by 32
+            env1Inc = (envNextValue - env1Value) * invBlockSize;
             this->env1ValueMem = envNextValue;
 
             env2Value = this->env2ValueMem;
             envNextValue = currentTimbre->env2_.getNextAmpExp(&envState2_);
-            env2Inc = (envNextValue - env2Value) * inv32;
+            env2Inc = (envNextValue - env2Value) * invBlockSize;
             this->env2ValueMem = envNextValue;
 
             env3Value = this->env3ValueMem;
             envNextValue = currentTimbre->env3_.getNextAmpExp(&envState3_);
-            env3Inc = (envNextValue - env3Value) * inv32;
+            env3Inc = (envNextValue - env3Value) * invBlockSize;
             this->env3ValueMem = envNextValue;
 
             env4Value = this->env4ValueMem;
             envNextValue = currentTimbre->env4_.getNextAmpExp(&envState4_);
-            env4Inc = (envNextValue - env4Value) * inv32;
+            env4Inc = (envNextValue - env4Value) * invBlockSize;
             this->env4ValueMem = envNextValue;
 
             oscState4_.frequency = oscState4_.mainFrequencyPlusMatrix;
@@ -1045,22 +1076,22 @@ void Voice::nextBlock() {
 
             env1Value = this->env1ValueMem;
             envNextValue = currentTimbre->env1_.getNextAmpExp(&envState1_);
-            env1Inc = (envNextValue - env1Value) * inv32;  // divide by 32
+            env1Inc = (envNextValue - env1Value) * invBlockSize;
             this->env1ValueMem = envNextValue;
 
             env2Value = this->env2ValueMem;
             envNextValue = currentTimbre->env2_.getNextAmpExp(&envState2_);
-            env2Inc = (envNextValue - env2Value) * inv32;
+            env2Inc = (envNextValue - env2Value) * invBlockSize;
             this->env2ValueMem = envNextValue;
 
             env3Value = this->env3ValueMem;
             envNextValue = currentTimbre->env3_.getNextAmpExp(&envState3_);
-            env3Inc = (envNextValue - env3Value) * inv32;
+            env3Inc = (envNextValue - env3Value) * invBlockSize;
             this->env3ValueMem = envNextValue;
 
             env4Value = this->env4ValueMem;
             envNextValue = currentTimbre->env4_.getNextAmpExp(&envState4_);
-            env4Inc = (envNextValue - env4Value) * inv32;
+            env4Inc = (envNextValue - env4Value) * invBlockSize;
             this->env4ValueMem = envNextValue;
 
             oscState4_.frequency = oscState4_.mainFrequencyPlusMatrix;
@@ -1131,22 +1162,22 @@ void Voice::nextBlock() {
 
             env1Value = this->env1ValueMem;
             envNextValue = currentTimbre->env1_.getNextAmpExp(&envState1_);
-            env1Inc = (envNextValue - env1Value) * inv32;  // divide by 32
+            env1Inc = (envNextValue - env1Value) * invBlockSize;
             this->env1ValueMem = envNextValue;
 
             env2Value = this->env2ValueMem;
             envNextValue = currentTimbre->env2_.getNextAmpExp(&envState2_);
-            env2Inc = (envNextValue - env2Value) * inv32;
+            env2Inc = (envNextValue - env2Value) * invBlockSize;
             this->env2ValueMem = envNextValue;
 
             env3Value = this->env3ValueMem;
             envNextValue = currentTimbre->env3_.getNextAmpExp(&envState3_);
-            env3Inc = (envNextValue - env3Value) * inv32;
+            env3Inc = (envNextValue - env3Value) * invBlockSize;
             this->env3ValueMem = envNextValue;
 
             env4Value = this->env4ValueMem;
             envNextValue = currentTimbre->env4_.getNextAmpExp(&envState4_);
-            env4Inc = (envNextValue - env4Value) * inv32;
+            env4Inc = (envNextValue - env4Value) * invBlockSize;
             this->env4ValueMem = envNextValue;
 
             oscState4_.frequency = oscState4_.mainFrequencyPlusMatrix;
@@ -1212,32 +1243,32 @@ void Voice::nextBlock() {
 
             env1Value = this->env1ValueMem;
             envNextValue = currentTimbre->env1_.getNextAmpExp(&envState1_);
-            env1Inc = (envNextValue - env1Value) * inv32;  // divide by 32
+            env1Inc = (envNextValue - env1Value) * invBlockSize;
             this->env1ValueMem = envNextValue;
 
             env2Value = this->env2ValueMem;
             envNextValue = currentTimbre->env2_.getNextAmpExp(&envState2_);
-            env2Inc = (envNextValue - env2Value) * inv32;
+            env2Inc = (envNextValue - env2Value) * invBlockSize;
             this->env2ValueMem = envNextValue;
 
             env3Value = this->env3ValueMem;
             envNextValue = currentTimbre->env3_.getNextAmpExp(&envState3_);
-            env3Inc = (envNextValue - env3Value) * inv32;
+            env3Inc = (envNextValue - env3Value) * invBlockSize;
             this->env3ValueMem = envNextValue;
 
             env4Value = this->env4ValueMem;
             envNextValue = currentTimbre->env4_.getNextAmpExp(&envState4_);
-            env4Inc = (envNextValue - env4Value) * inv32;
+            env4Inc = (envNextValue - env4Value) * invBlockSize;
             this->env4ValueMem = envNextValue;
 
             env5Value = this->env5ValueMem;
             envNextValue = currentTimbre->env5_.getNextAmpExp(&envState5_);
-            env5Inc = (envNextValue - env5Value) * inv32;
+            env5Inc = (envNextValue - env5Value) * invBlockSize;
             this->env5ValueMem = envNextValue;
 
             env6Value = this->env6ValueMem;
             envNextValue = currentTimbre->env6_.getNextAmpExp(&envState6_);
-            env6Inc = (envNextValue - env6Value) * inv32;
+            env6Inc = (envNextValue - env6Value) * invBlockSize;
             this->env6ValueMem = envNextValue;
 
             oscState2_.frequency = oscState2_.mainFrequencyPlusMatrix;
@@ -1318,32 +1349,32 @@ void Voice::nextBlock() {
 
             env1Value = this->env1ValueMem;
             envNextValue = currentTimbre->env1_.getNextAmpExp(&envState1_);
-            env1Inc = (envNextValue - env1Value) * inv32;  // divide by 32
+            env1Inc = (envNextValue - env1Value) * invBlockSize;
             this->env1ValueMem = envNextValue;
 
             env2Value = this->env2ValueMem;
             envNextValue = currentTimbre->env2_.getNextAmpExp(&envState2_);
-            env2Inc = (envNextValue - env2Value) * inv32;
+            env2Inc = (envNextValue - env2Value) * invBlockSize;
             this->env2ValueMem = envNextValue;
 
             env3Value = this->env3ValueMem;
             envNextValue = currentTimbre->env3_.getNextAmpExp(&envState3_);
-            env3Inc = (envNextValue - env3Value) * inv32;
+            env3Inc = (envNextValue - env3Value) * invBlockSize;
             this->env3ValueMem = envNextValue;
 
             env4Value = this->env4ValueMem;
             envNextValue = currentTimbre->env4_.getNextAmpExp(&envState4_);
-            env4Inc = (envNextValue - env4Value) * inv32;
+            env4Inc = (envNextValue - env4Value) * invBlockSize;
             this->env4ValueMem = envNextValue;
 
             env5Value = this->env5ValueMem;
             envNextValue = currentTimbre->env5_.getNextAmpExp(&envState5_);
-            env5Inc = (envNextValue - env5Value) * inv32;
+            env5Inc = (envNextValue - env5Value) * invBlockSize;
             this->env5ValueMem = envNextValue;
 
             env6Value = this->env6ValueMem;
             envNextValue = currentTimbre->env6_.getNextAmpExp(&envState6_);
-            env6Inc = (envNextValue - env6Value) * inv32;
+            env6Inc = (envNextValue - env6Value) * invBlockSize;
             this->env6ValueMem = envNextValue;
 
             oscState2_.frequency = oscState2_.mainFrequencyPlusMatrix;
@@ -1429,32 +1460,32 @@ void Voice::nextBlock() {
 
             env1Value = this->env1ValueMem;
             envNextValue = currentTimbre->env1_.getNextAmpExp(&envState1_);
-            env1Inc = (envNextValue - env1Value) * inv32;  // divide by 32
+            env1Inc = (envNextValue - env1Value) * invBlockSize;
             this->env1ValueMem = envNextValue;
 
             env2Value = this->env2ValueMem;
             envNextValue = currentTimbre->env2_.getNextAmpExp(&envState2_);
-            env2Inc = (envNextValue - env2Value) * inv32;
+            env2Inc = (envNextValue - env2Value) * invBlockSize;
             this->env2ValueMem = envNextValue;
 
             env3Value = this->env3ValueMem;
             envNextValue = currentTimbre->env3_.getNextAmpExp(&envState3_);
-            env3Inc = (envNextValue - env3Value) * inv32;
+            env3Inc = (envNextValue - env3Value) * invBlockSize;
             this->env3ValueMem = envNextValue;
 
             env4Value = this->env4ValueMem;
             envNextValue = currentTimbre->env4_.getNextAmpExp(&envState4_);
-            env4Inc = (envNextValue - env4Value) * inv32;
+            env4Inc = (envNextValue - env4Value) * invBlockSize;
             this->env4ValueMem = envNextValue;
 
             env5Value = this->env5ValueMem;
             envNextValue = currentTimbre->env5_.getNextAmpExp(&envState5_);
-            env5Inc = (envNextValue - env5Value) * inv32;
+            env5Inc = (envNextValue - env5Value) * invBlockSize;
             this->env5ValueMem = envNextValue;
 
             env6Value = this->env6ValueMem;
             envNextValue = currentTimbre->env6_.getNextAmpExp(&envState6_);
-            env6Inc = (envNextValue - env6Value) * inv32;
+            env6Inc = (envNextValue - env6Value) * invBlockSize;
             this->env6ValueMem = envNextValue;
 
             oscState2_.frequency = oscState2_.mainFrequencyPlusMatrix;
@@ -1551,32 +1582,32 @@ void Voice::nextBlock() {
 
             env1Value = this->env1ValueMem;
             envNextValue = currentTimbre->env1_.getNextAmpExp(&envState1_);
-            env1Inc = (envNextValue - env1Value) * inv32;  // divide by 32
+            env1Inc = (envNextValue - env1Value) * invBlockSize;
             this->env1ValueMem = envNextValue;
 
             env2Value = this->env2ValueMem;
             envNextValue = currentTimbre->env2_.getNextAmpExp(&envState2_);
-            env2Inc = (envNextValue - env2Value) * inv32;
+            env2Inc = (envNextValue - env2Value) * invBlockSize;
             this->env2ValueMem = envNextValue;
 
             env3Value = this->env3ValueMem;
             envNextValue = currentTimbre->env3_.getNextAmpExp(&envState3_);
-            env3Inc = (envNextValue - env3Value) * inv32;
+            env3Inc = (envNextValue - env3Value) * invBlockSize;
             this->env3ValueMem = envNextValue;
 
             env4Value = this->env4ValueMem;
             envNextValue = currentTimbre->env4_.getNextAmpExp(&envState4_);
-            env4Inc = (envNextValue - env4Value) * inv32;
+            env4Inc = (envNextValue - env4Value) * invBlockSize;
             this->env4ValueMem = envNextValue;
 
             env5Value = this->env5ValueMem;
             envNextValue = currentTimbre->env5_.getNextAmpExp(&envState5_);
-            env5Inc = (envNextValue - env5Value) * inv32;
+            env5Inc = (envNextValue - env5Value) * invBlockSize;
             this->env5ValueMem = envNextValue;
 
             env6Value = this->env6ValueMem;
             envNextValue = currentTimbre->env6_.getNextAmpExp(&envState6_);
-            env6Inc = (envNextValue - env6Value) * inv32;
+            env6Inc = (envNextValue - env6Value) * invBlockSize;
             this->env6ValueMem = envNextValue;
 
             oscState2_.frequency = oscState2_.mainFrequencyPlusMatrix;
@@ -1674,32 +1705,32 @@ void Voice::nextBlock() {
 
             env1Value = this->env1ValueMem;
             envNextValue = currentTimbre->env1_.getNextAmpExp(&envState1_);
-            env1Inc = (envNextValue - env1Value) * inv32;  // divide by 32
+            env1Inc = (envNextValue - env1Value) * invBlockSize;
             this->env1ValueMem = envNextValue;
 
             env2Value = this->env2ValueMem;
             envNextValue = currentTimbre->env2_.getNextAmpExp(&envState2_);
-            env2Inc = (envNextValue - env2Value) * inv32;
+            env2Inc = (envNextValue - env2Value) * invBlockSize;
             this->env2ValueMem = envNextValue;
 
             env3Value = this->env3ValueMem;
             envNextValue = currentTimbre->env3_.getNextAmpExp(&envState3_);
-            env3Inc = (envNextValue - env3Value) * inv32;
+            env3Inc = (envNextValue - env3Value) * invBlockSize;
             this->env3ValueMem = envNextValue;
 
             env4Value = this->env4ValueMem;
             envNextValue = currentTimbre->env4_.getNextAmpExp(&envState4_);
-            env4Inc = (envNextValue - env4Value) * inv32;
+            env4Inc = (envNextValue - env4Value) * invBlockSize;
             this->env4ValueMem = envNextValue;
 
             env5Value = this->env5ValueMem;
             envNextValue = currentTimbre->env5_.getNextAmpExp(&envState5_);
-            env5Inc = (envNextValue - env5Value) * inv32;
+            env5Inc = (envNextValue - env5Value) * invBlockSize;
             this->env5ValueMem = envNextValue;
 
             env6Value = this->env6ValueMem;
             envNextValue = currentTimbre->env6_.getNextAmpExp(&envState6_);
-            env6Inc = (envNextValue - env6Value) * inv32;
+            env6Inc = (envNextValue - env6Value) * invBlockSize;
             this->env6ValueMem = envNextValue;
 
             oscState3_.frequency = oscState3_.mainFrequencyPlusMatrix;
@@ -1792,32 +1823,32 @@ void Voice::nextBlock() {
 
             env1Value = this->env1ValueMem;
             envNextValue = currentTimbre->env1_.getNextAmpExp(&envState1_);
-            env1Inc = (envNextValue - env1Value) * inv32;  // divide by 32
+            env1Inc = (envNextValue - env1Value) * invBlockSize;
             this->env1ValueMem = envNextValue;
 
             env2Value = this->env2ValueMem;
             envNextValue = currentTimbre->env2_.getNextAmpExp(&envState2_);
-            env2Inc = (envNextValue - env2Value) * inv32;
+            env2Inc = (envNextValue - env2Value) * invBlockSize;
             this->env2ValueMem = envNextValue;
 
             env3Value = this->env3ValueMem;
             envNextValue = currentTimbre->env3_.getNextAmpExp(&envState3_);
-            env3Inc = (envNextValue - env3Value) * inv32;
+            env3Inc = (envNextValue - env3Value) * invBlockSize;
             this->env3ValueMem = envNextValue;
 
             env4Value = this->env4ValueMem;
             envNextValue = currentTimbre->env4_.getNextAmpExp(&envState4_);
-            env4Inc = (envNextValue - env4Value) * inv32;
+            env4Inc = (envNextValue - env4Value) * invBlockSize;
             this->env4ValueMem = envNextValue;
 
             env5Value = this->env5ValueMem;
             envNextValue = currentTimbre->env5_.getNextAmpExp(&envState5_);
-            env5Inc = (envNextValue - env5Value) * inv32;
+            env5Inc = (envNextValue - env5Value) * invBlockSize;
             this->env5ValueMem = envNextValue;
 
             env6Value = this->env6ValueMem;
             envNextValue = currentTimbre->env6_.getNextAmpExp(&envState6_);
-            env6Inc = (envNextValue - env6Value) * inv32;
+            env6Inc = (envNextValue - env6Value) * invBlockSize;
             this->env6ValueMem = envNextValue;
 
             oscState2_.frequency = oscState2_.mainFrequencyPlusMatrix;
@@ -1896,32 +1927,32 @@ void Voice::nextBlock() {
 
             env1Value = this->env1ValueMem;
             envNextValue = currentTimbre->env1_.getNextAmpExp(&envState1_);
-            env1Inc = (envNextValue - env1Value) * inv32;  // divide by 32
+            env1Inc = (envNextValue - env1Value) * invBlockSize;
             this->env1ValueMem = envNextValue;
 
             env2Value = this->env2ValueMem;
             envNextValue = currentTimbre->env2_.getNextAmpExp(&envState2_);
-            env2Inc = (envNextValue - env2Value) * inv32;
+            env2Inc = (envNextValue - env2Value) * invBlockSize;
             this->env2ValueMem = envNextValue;
 
             env3Value = this->env3ValueMem;
             envNextValue = currentTimbre->env3_.getNextAmpExp(&envState3_);
-            env3Inc = (envNextValue - env3Value) * inv32;
+            env3Inc = (envNextValue - env3Value) * invBlockSize;
             this->env3ValueMem = envNextValue;
 
             env4Value = this->env4ValueMem;
             envNextValue = currentTimbre->env4_.getNextAmpExp(&envState4_);
-            env4Inc = (envNextValue - env4Value) * inv32;
+            env4Inc = (envNextValue - env4Value) * invBlockSize;
             this->env4ValueMem = envNextValue;
 
             env5Value = this->env5ValueMem;
             envNextValue = currentTimbre->env5_.getNextAmpExp(&envState5_);
-            env5Inc = (envNextValue - env5Value) * inv32;
+            env5Inc = (envNextValue - env5Value) * invBlockSize;
             this->env5ValueMem = envNextValue;
 
             env6Value = this->env6ValueMem;
             envNextValue = currentTimbre->env6_.getNextAmpExp(&envState6_);
-            env6Inc = (envNextValue - env6Value) * inv32;
+            env6Inc = (envNextValue - env6Value) * invBlockSize;
             this->env6ValueMem = envNextValue;
 
             oscState2_.frequency = oscState2_.mainFrequencyPlusMatrix;
@@ -2011,32 +2042,32 @@ void Voice::nextBlock() {
 
             env1Value = this->env1ValueMem;
             envNextValue = currentTimbre->env1_.getNextAmpExp(&envState1_);
-            env1Inc = (envNextValue - env1Value) * inv32;  // divide by 32
+            env1Inc = (envNextValue - env1Value) * invBlockSize;
             this->env1ValueMem = envNextValue;
 
             env2Value = this->env2ValueMem;
             envNextValue = currentTimbre->env2_.getNextAmpExp(&envState2_);
-            env2Inc = (envNextValue - env2Value) * inv32;
+            env2Inc = (envNextValue - env2Value) * invBlockSize;
             this->env2ValueMem = envNextValue;
 
             env3Value = this->env3ValueMem;
             envNextValue = currentTimbre->env3_.getNextAmpExp(&envState3_);
-            env3Inc = (envNextValue - env3Value) * inv32;
+            env3Inc = (envNextValue - env3Value) * invBlockSize;
             this->env3ValueMem = envNextValue;
 
             env4Value = this->env4ValueMem;
             envNextValue = currentTimbre->env4_.getNextAmpExp(&envState4_);
-            env4Inc = (envNextValue - env4Value) * inv32;
+            env4Inc = (envNextValue - env4Value) * invBlockSize;
             this->env4ValueMem = envNextValue;
 
             env5Value = this->env5ValueMem;
             envNextValue = currentTimbre->env5_.getNextAmpExp(&envState5_);
-            env5Inc = (envNextValue - env5Value) * inv32;
+            env5Inc = (envNextValue - env5Value) * invBlockSize;
             this->env5ValueMem = envNextValue;
 
             env6Value = this->env6ValueMem;
             envNextValue = currentTimbre->env6_.getNextAmpExp(&envState6_);
-            env6Inc = (envNextValue - env6Value) * inv32;
+            env6Inc = (envNextValue - env6Value) * invBlockSize;
             this->env6ValueMem = envNextValue;
 
             oscState3_.frequency = oscState3_.mainFrequencyPlusMatrix;
@@ -2125,32 +2156,32 @@ void Voice::nextBlock() {
 
             env1Value = this->env1ValueMem;
             envNextValue = currentTimbre->env1_.getNextAmpExp(&envState1_);
-            env1Inc = (envNextValue - env1Value) * inv32;  // divide by 32
+            env1Inc = (envNextValue - env1Value) * invBlockSize;
             this->env1ValueMem = envNextValue;
 
             env2Value = this->env2ValueMem;
             envNextValue = currentTimbre->env2_.getNextAmpExp(&envState2_);
-            env2Inc = (envNextValue - env2Value) * inv32;
+            env2Inc = (envNextValue - env2Value) * invBlockSize;
             this->env2ValueMem = envNextValue;
 
             env3Value = this->env3ValueMem;
             envNextValue = currentTimbre->env3_.getNextAmpExp(&envState3_);
-            env3Inc = (envNextValue - env3Value) * inv32;
+            env3Inc = (envNextValue - env3Value) * invBlockSize;
             this->env3ValueMem = envNextValue;
 
             env4Value = this->env4ValueMem;
             envNextValue = currentTimbre->env4_.getNextAmpExp(&envState4_);
-            env4Inc = (envNextValue - env4Value) * inv32;
+            env4Inc = (envNextValue - env4Value) * invBlockSize;
             this->env4ValueMem = envNextValue;
 
             env5Value = this->env5ValueMem;
             envNextValue = currentTimbre->env5_.getNextAmpExp(&envState5_);
-            env5Inc = (envNextValue - env5Value) * inv32;
+            env5Inc = (envNextValue - env5Value) * invBlockSize;
             this->env5ValueMem = envNextValue;
 
             env6Value = this->env6ValueMem;
             envNextValue = currentTimbre->env6_.getNextAmpExp(&envState6_);
-            env6Inc = (envNextValue - env6Value) * inv32;
+            env6Inc = (envNextValue - env6Value) * invBlockSize;
             this->env6ValueMem = envNextValue;
 
             oscState2_.frequency = oscState2_.mainFrequencyPlusMatrix;
@@ -2232,32 +2263,32 @@ void Voice::nextBlock() {
 
             env1Value = this->env1ValueMem;
             envNextValue = currentTimbre->env1_.getNextAmpExp(&envState1_);
-            env1Inc = (envNextValue - env1Value) * inv32;  // divide by 32
+            env1Inc = (envNextValue - env1Value) * invBlockSize;
             this->env1ValueMem = envNextValue;
 
             env2Value = this->env2ValueMem;
             envNextValue = currentTimbre->env2_.getNextAmpExp(&envState2_);
-            env2Inc = (envNextValue - env2Value) * inv32;
+            env2Inc = (envNextValue - env2Value) * invBlockSize;
             this->env2ValueMem = envNextValue;
 
             env3Value = this->env3ValueMem;
             envNextValue = currentTimbre->env3_.getNextAmpExp(&envState3_);
-            env3Inc = (envNextValue - env3Value) * inv32;
+            env3Inc = (envNextValue - env3Value) * invBlockSize;
             this->env3ValueMem = envNextValue;
 
             env4Value = this->env4ValueMem;
             envNextValue = currentTimbre->env4_.getNextAmpExp(&envState4_);
-            env4Inc = (envNextValue - env4Value) * inv32;
+            env4Inc = (envNextValue - env4Value) * invBlockSize;
             this->env4ValueMem = envNextValue;
 
             env5Value = this->env5ValueMem;
             envNextValue = currentTimbre->env5_.getNextAmpExp(&envState5_);
-            env5Inc = (envNextValue - env5Value) * inv32;
+            env5Inc = (envNextValue - env5Value) * invBlockSize;
             this->env5ValueMem = envNextValue;
 
             env6Value = this->env6ValueMem;
             envNextValue = currentTimbre->env6_.getNextAmpExp(&envState6_);
-            env6Inc = (envNextValue - env6Value) * inv32;
+            env6Inc = (envNextValue - env6Value) * invBlockSize;
             this->env6ValueMem = envNextValue;
 
             oscState2_.frequency = oscState2_.mainFrequencyPlusMatrix;
@@ -2349,32 +2380,32 @@ void Voice::nextBlock() {
 
             env1Value = this->env1ValueMem;
             envNextValue = currentTimbre->env1_.getNextAmpExp(&envState1_);
-            env1Inc = (envNextValue - env1Value) * inv32;  // divide by 32
+            env1Inc = (envNextValue - env1Value) * invBlockSize;
             this->env1ValueMem = envNextValue;
 
             env2Value = this->env2ValueMem;
             envNextValue = currentTimbre->env2_.getNextAmpExp(&envState2_);
-            env2Inc = (envNextValue - env2Value) * inv32;
+            env2Inc = (envNextValue - env2Value) * invBlockSize;
             this->env2ValueMem = envNextValue;
 
             env3Value = this->env3ValueMem;
             envNextValue = currentTimbre->env3_.getNextAmpExp(&envState3_);
-            env3Inc = (envNextValue - env3Value) * inv32;
+            env3Inc = (envNextValue - env3Value) * invBlockSize;
             this->env3ValueMem = envNextValue;
 
             env4Value = this->env4ValueMem;
             envNextValue = currentTimbre->env4_.getNextAmpExp(&envState4_);
-            env4Inc = (envNextValue - env4Value) * inv32;
+            env4Inc = (envNextValue - env4Value) * invBlockSize;
             this->env4ValueMem = envNextValue;
 
             env5Value = this->env5ValueMem;
             envNextValue = currentTimbre->env5_.getNextAmpExp(&envState5_);
-            env5Inc = (envNextValue - env5Value) * inv32;
+            env5Inc = (envNextValue - env5Value) * invBlockSize;
             this->env5ValueMem = envNextValue;
 
             env6Value = this->env6ValueMem;
             envNextValue = currentTimbre->env6_.getNextAmpExp(&envState6_);
-            env6Inc = (envNextValue - env6Value) * inv32;
+            env6Inc = (envNextValue - env6Value) * invBlockSize;
             this->env6ValueMem = envNextValue;
 
             oscState2_.frequency = oscState2_.mainFrequencyPlusMatrix;
@@ -2476,32 +2507,32 @@ void Voice::nextBlock() {
 
             env1Value = this->env1ValueMem;
             envNextValue = currentTimbre->env1_.getNextAmpExp(&envState1_);
-            env1Inc = (envNextValue - env1Value) * inv32;  // divide by 32
+            env1Inc = (envNextValue - env1Value) * invBlockSize;
             this->env1ValueMem = envNextValue;
 
             env2Value = this->env2ValueMem;
             envNextValue = currentTimbre->env2_.getNextAmpExp(&envState2_);
-            env2Inc = (envNextValue - env2Value) * inv32;
+            env2Inc = (envNextValue - env2Value) * invBlockSize;
             this->env2ValueMem = envNextValue;
 
             env3Value = this->env3ValueMem;
             envNextValue = currentTimbre->env3_.getNextAmpExp(&envState3_);
-            env3Inc = (envNextValue - env3Value) * inv32;
+            env3Inc = (envNextValue - env3Value) * invBlockSize;
             this->env3ValueMem = envNextValue;
 
             env4Value = this->env4ValueMem;
             envNextValue = currentTimbre->env4_.getNextAmpExp(&envState4_);
-            env4Inc = (envNextValue - env4Value) * inv32;
+            env4Inc = (envNextValue - env4Value) * invBlockSize;
             this->env4ValueMem = envNextValue;
 
             env5Value = this->env5ValueMem;
             envNextValue = currentTimbre->env5_.getNextAmpExp(&envState5_);
-            env5Inc = (envNextValue - env5Value) * inv32;
+            env5Inc = (envNextValue - env5Value) * invBlockSize;
             this->env5ValueMem = envNextValue;
 
             env6Value = this->env6ValueMem;
             envNextValue = currentTimbre->env6_.getNextAmpExp(&envState6_);
-            env6Inc = (envNextValue - env6Value) * inv32;
+            env6Inc = (envNextValue - env6Value) * invBlockSize;
             this->env6ValueMem = envNextValue;
 
             oscState2_.frequency = oscState2_.mainFrequencyPlusMatrix;
@@ -2601,32 +2632,32 @@ void Voice::nextBlock() {
 
             env1Value = this->env1ValueMem;
             envNextValue = currentTimbre->env1_.getNextAmpExp(&envState1_);
-            env1Inc = (envNextValue - env1Value) * inv32;  // divide by 32
+            env1Inc = (envNextValue - env1Value) * invBlockSize;
             this->env1ValueMem = envNextValue;
 
             env2Value = this->env2ValueMem;
             envNextValue = currentTimbre->env2_.getNextAmpExp(&envState2_);
-            env2Inc = (envNextValue - env2Value) * inv32;
+            env2Inc = (envNextValue - env2Value) * invBlockSize;
             this->env2ValueMem = envNextValue;
 
             env3Value = this->env3ValueMem;
             envNextValue = currentTimbre->env3_.getNextAmpExp(&envState3_);
-            env3Inc = (envNextValue - env3Value) * inv32;
+            env3Inc = (envNextValue - env3Value) * invBlockSize;
             this->env3ValueMem = envNextValue;
 
             env4Value = this->env4ValueMem;
             envNextValue = currentTimbre->env4_.getNextAmpExp(&envState4_);
-            env4Inc = (envNextValue - env4Value) * inv32;
+            env4Inc = (envNextValue - env4Value) * invBlockSize;
             this->env4ValueMem = envNextValue;
 
             env5Value = this->env5ValueMem;
             envNextValue = currentTimbre->env5_.getNextAmpExp(&envState5_);
-            env5Inc = (envNextValue - env5Value) * inv32;
+            env5Inc = (envNextValue - env5Value) * invBlockSize;
             this->env5ValueMem = envNextValue;
 
             env6Value = this->env6ValueMem;
             envNextValue = currentTimbre->env6_.getNextAmpExp(&envState6_);
-            env6Inc = (envNextValue - env6Value) * inv32;
+            env6Inc = (envNextValue - env6Value) * invBlockSize;
             this->env6ValueMem = envNextValue;
 
             oscState3_.frequency = oscState3_.mainFrequencyPlusMatrix;
@@ -2709,32 +2740,32 @@ void Voice::nextBlock() {
 
             env1Value = this->env1ValueMem;
             envNextValue = currentTimbre->env1_.getNextAmpExp(&envState1_);
-            env1Inc = (envNextValue - env1Value) * inv32;  // divide by 32
+            env1Inc = (envNextValue - env1Value) * invBlockSize;
             this->env1ValueMem = envNextValue;
 
             env2Value = this->env2ValueMem;
             envNextValue = currentTimbre->env2_.getNextAmpExp(&envState2_);
-            env2Inc = (envNextValue - env2Value) * inv32;
+            env2Inc = (envNextValue - env2Value) * invBlockSize;
             this->env2ValueMem = envNextValue;
 
             env3Value = this->env3ValueMem;
             envNextValue = currentTimbre->env3_.getNextAmpExp(&envState3_);
-            env3Inc = (envNextValue - env3Value) * inv32;
+            env3Inc = (envNextValue - env3Value) * invBlockSize;
             this->env3ValueMem = envNextValue;
 
             env4Value = this->env4ValueMem;
             envNextValue = currentTimbre->env4_.getNextAmpExp(&envState4_);
-            env4Inc = (envNextValue - env4Value) * inv32;
+            env4Inc = (envNextValue - env4Value) * invBlockSize;
             this->env4ValueMem = envNextValue;
 
             env5Value = this->env5ValueMem;
             envNextValue = currentTimbre->env5_.getNextAmpExp(&envState5_);
-            env5Inc = (envNextValue - env5Value) * inv32;
+            env5Inc = (envNextValue - env5Value) * invBlockSize;
             this->env5ValueMem = envNextValue;
 
             env6Value = this->env6ValueMem;
             envNextValue = currentTimbre->env6_.getNextAmpExp(&envState6_);
-            env6Inc = (envNextValue - env6Value) * inv32;
+            env6Inc = (envNextValue - env6Value) * invBlockSize;
             this->env6ValueMem = envNextValue;
 
             oscState3_.frequency = oscState3_.mainFrequencyPlusMatrix;
@@ -2810,32 +2841,32 @@ void Voice::nextBlock() {
 
             env1Value = this->env1ValueMem;
             envNextValue = currentTimbre->env1_.getNextAmpExp(&envState1_);
-            env1Inc = (envNextValue - env1Value) * inv32;  // divide by 32
+            env1Inc = (envNextValue - env1Value) * invBlockSize;
             this->env1ValueMem = envNextValue;
 
             env2Value = this->env2ValueMem;
             envNextValue = currentTimbre->env2_.getNextAmpExp(&envState2_);
-            env2Inc = (envNextValue - env2Value) * inv32;
+            env2Inc = (envNextValue - env2Value) * invBlockSize;
             this->env2ValueMem = envNextValue;
 
             env3Value = this->env3ValueMem;
             envNextValue = currentTimbre->env3_.getNextAmpExp(&envState3_);
-            env3Inc = (envNextValue - env3Value) * inv32;
+            env3Inc = (envNextValue - env3Value) * invBlockSize;
             this->env3ValueMem = envNextValue;
 
             env4Value = this->env4ValueMem;
             envNextValue = currentTimbre->env4_.getNextAmpExp(&envState4_);
-            env4Inc = (envNextValue - env4Value) * inv32;
+            env4Inc = (envNextValue - env4Value) * invBlockSize;
             this->env4ValueMem = envNextValue;
 
             env5Value = this->env5ValueMem;
             envNextValue = currentTimbre->env5_.getNextAmpExp(&envState5_);
-            env5Inc = (envNextValue - env5Value) * inv32;
+            env5Inc = (envNextValue - env5Value) * invBlockSize;
             this->env5ValueMem = envNextValue;
 
             env6Value = this->env6ValueMem;
             envNextValue = currentTimbre->env6_.getNextAmpExp(&envState6_);
-            env6Inc = (envNextValue - env6Value) * inv32;
+            env6Inc = (envNextValue - env6Value) * invBlockSize;
             this->env6ValueMem = envNextValue;
 
             oscState3_.frequency = oscState3_.mainFrequencyPlusMatrix;
@@ -2909,32 +2940,32 @@ void Voice::nextBlock() {
 
             env1Value = this->env1ValueMem;
             envNextValue = currentTimbre->env1_.getNextAmpExp(&envState1_);
-            env1Inc = (envNextValue - env1Value) * inv32;  // divide by 32
+            env1Inc = (envNextValue - env1Value) * invBlockSize;
             this->env1ValueMem = envNextValue;
 
             env2Value = this->env2ValueMem;
             envNextValue = currentTimbre->env2_.getNextAmpExp(&envState2_);
-            env2Inc = (envNextValue - env2Value) * inv32;
+            env2Inc = (envNextValue - env2Value) * invBlockSize;
             this->env2ValueMem = envNextValue;
 
             env3Value = this->env3ValueMem;
             envNextValue = currentTimbre->env3_.getNextAmpExp(&envState3_);
-            env3Inc = (envNextValue - env3Value) * inv32;
+            env3Inc = (envNextValue - env3Value) * invBlockSize;
             this->env3ValueMem = envNextValue;
 
             env4Value = this->env4ValueMem;
             envNextValue = currentTimbre->env4_.getNextAmpExp(&envState4_);
-            env4Inc = (envNextValue - env4Value) * inv32;
+            env4Inc = (envNextValue - env4Value) * invBlockSize;
             this->env4ValueMem = envNextValue;
 
             env5Value = this->env5ValueMem;
             envNextValue = currentTimbre->env5_.getNextAmpExp(&envState5_);
-            env5Inc = (envNextValue - env5Value) * inv32;
+            env5Inc = (envNextValue - env5Value) * invBlockSize;
             this->env5ValueMem = envNextValue;
 
             env6Value = this->env6ValueMem;
             envNextValue = currentTimbre->env6_.getNextAmpExp(&envState6_);
-            env6Inc = (envNextValue - env6Value) * inv32;
+            env6Inc = (envNextValue - env6Value) * invBlockSize;
             this->env6ValueMem = envNextValue;
 
             oscState2_.frequency = oscState2_.mainFrequencyPlusMatrix;
@@ -3008,32 +3039,32 @@ void Voice::nextBlock() {
 
             env1Value = this->env1ValueMem;
             envNextValue = currentTimbre->env1_.getNextAmpExp(&envState1_);
-            env1Inc = (envNextValue - env1Value) * inv32;  // divide by 32
+            env1Inc = (envNextValue - env1Value) * invBlockSize;
             this->env1ValueMem = envNextValue;
 
             env2Value = this->env2ValueMem;
             envNextValue = currentTimbre->env2_.getNextAmpExp(&envState2_);
-            env2Inc = (envNextValue - env2Value) * inv32;
+            env2Inc = (envNextValue - env2Value) * invBlockSize;
             this->env2ValueMem = envNextValue;
 
             env3Value = this->env3ValueMem;
             envNextValue = currentTimbre->env3_.getNextAmpExp(&envState3_);
-            env3Inc = (envNextValue - env3Value) * inv32;
+            env3Inc = (envNextValue - env3Value) * invBlockSize;
             this->env3ValueMem = envNextValue;
 
             env4Value = this->env4ValueMem;
             envNextValue = currentTimbre->env4_.getNextAmpExp(&envState4_);
-            env4Inc = (envNextValue - env4Value) * inv32;
+            env4Inc = (envNextValue - env4Value) * invBlockSize;
             this->env4ValueMem = envNextValue;
 
             env5Value = this->env5ValueMem;
             envNextValue = currentTimbre->env5_.getNextAmpExp(&envState5_);
-            env5Inc = (envNextValue - env5Value) * inv32;
+            env5Inc = (envNextValue - env5Value) * invBlockSize;
             this->env5ValueMem = envNextValue;
 
             env6Value = this->env6ValueMem;
             envNextValue = currentTimbre->env6_.getNextAmpExp(&envState6_);
-            env6Inc = (envNextValue - env6Value) * inv32;
+            env6Inc = (envNextValue - env6Value) * invBlockSize;
             this->env6ValueMem = envNextValue;
 
             oscState1_.frequency = oscState1_.mainFrequencyPlusMatrix;
@@ -3114,32 +3145,32 @@ void Voice::nextBlock() {
 
             env1Value = this->env1ValueMem;
             envNextValue = currentTimbre->env1_.getNextAmpExp(&envState1_);
-            env1Inc = (envNextValue - env1Value) * inv32;  // divide by 32
+            env1Inc = (envNextValue - env1Value) * invBlockSize;
             this->env1ValueMem = envNextValue;
 
             env2Value = this->env2ValueMem;
             envNextValue = currentTimbre->env2_.getNextAmpExp(&envState2_);
-            env2Inc = (envNextValue - env2Value) * inv32;
+            env2Inc = (envNextValue - env2Value) * invBlockSize;
             this->env2ValueMem = envNextValue;
 
             env3Value = this->env3ValueMem;
             envNextValue = currentTimbre->env3_.getNextAmpExp(&envState3_);
-            env3Inc = (envNextValue - env3Value) * inv32;
+            env3Inc = (envNextValue - env3Value) * invBlockSize;
             this->env3ValueMem = envNextValue;
 
             env4Value = this->env4ValueMem;
             envNextValue = currentTimbre->env4_.getNextAmpExp(&envState4_);
-            env4Inc = (envNextValue - env4Value) * inv32;
+            env4Inc = (envNextValue - env4Value) * invBlockSize;
             this->env4ValueMem = envNextValue;
 
             env5Value = this->env5ValueMem;
             envNextValue = currentTimbre->env5_.getNextAmpExp(&envState5_);
-            env5Inc = (envNextValue - env5Value) * inv32;
+            env5Inc = (envNextValue - env5Value) * invBlockSize;
             this->env5ValueMem = envNextValue;
 
             env6Value = this->env6ValueMem;
             envNextValue = currentTimbre->env6_.getNextAmpExp(&envState6_);
-            env6Inc = (envNextValue - env6Value) * inv32;
+            env6Inc = (envNextValue - env6Value) * invBlockSize;
             this->env6ValueMem = envNextValue;
 
             oscState2_.frequency = oscState2_.mainFrequencyPlusMatrix;
@@ -3224,32 +3255,32 @@ void Voice::nextBlock() {
 
             env1Value = this->env1ValueMem;
             envNextValue = currentTimbre->env1_.getNextAmpExp(&envState1_);
-            env1Inc = (envNextValue - env1Value) * inv32;  // divide by 32
+            env1Inc = (envNextValue - env1Value) * invBlockSize;
             this->env1ValueMem = envNextValue;
 
             env2Value = this->env2ValueMem;
             envNextValue = currentTimbre->env2_.getNextAmpExp(&envState2_);
-            env2Inc = (envNextValue - env2Value) * inv32;
+            env2Inc = (envNextValue - env2Value) * invBlockSize;
             this->env2ValueMem = envNextValue;
 
             env3Value = this->env3ValueMem;
             envNextValue = currentTimbre->env3_.getNextAmpExp(&envState3_);
-            env3Inc = (envNextValue - env3Value) * inv32;
+            env3Inc = (envNextValue - env3Value) * invBlockSize;
             this->env3ValueMem = envNextValue;
 
             env4Value = this->env4ValueMem;
             envNextValue = currentTimbre->env4_.getNextAmpExp(&envState4_);
-            env4Inc = (envNextValue - env4Value) * inv32;
+            env4Inc = (envNextValue - env4Value) * invBlockSize;
             this->env4ValueMem = envNextValue;
 
             env5Value = this->env5ValueMem;
             envNextValue = currentTimbre->env5_.getNextAmpExp(&envState5_);
-            env5Inc = (envNextValue - env5Value) * inv32;
+            env5Inc = (envNextValue - env5Value) * invBlockSize;
             this->env5ValueMem = envNextValue;
 
             env6Value = this->env6ValueMem;
             envNextValue = currentTimbre->env6_.getNextAmpExp(&envState6_);
-            env6Inc = (envNextValue - env6Value) * inv32;
+            env6Inc = (envNextValue - env6Value) * invBlockSize;
             this->env6ValueMem = envNextValue;
 
             oscState1_.frequency = oscState1_.mainFrequencyPlusMatrix;
@@ -3331,32 +3362,32 @@ void Voice::nextBlock() {
 
             env1Value = this->env1ValueMem;
             envNextValue = currentTimbre->env1_.getNextAmpExp(&envState1_);
-            env1Inc = (envNextValue - env1Value) * inv32;  // divide by 32
+            env1Inc = (envNextValue - env1Value) * invBlockSize;
             this->env1ValueMem = envNextValue;
 
             env2Value = this->env2ValueMem;
             envNextValue = currentTimbre->env2_.getNextAmpExp(&envState2_);
-            env2Inc = (envNextValue - env2Value) * inv32;
+            env2Inc = (envNextValue - env2Value) * invBlockSize;
             this->env2ValueMem = envNextValue;
 
             env3Value = this->env3ValueMem;
             envNextValue = currentTimbre->env3_.getNextAmpExp(&envState3_);
-            env3Inc = (envNextValue - env3Value) * inv32;
+            env3Inc = (envNextValue - env3Value) * invBlockSize;
             this->env3ValueMem = envNextValue;
 
             env4Value = this->env4ValueMem;
             envNextValue = currentTimbre->env4_.getNextAmpExp(&envState4_);
-            env4Inc = (envNextValue - env4Value) * inv32;
+            env4Inc = (envNextValue - env4Value) * invBlockSize;
             this->env4ValueMem = envNextValue;
 
             env5Value = this->env5ValueMem;
             envNextValue = currentTimbre->env5_.getNextAmpExp(&envState5_);
-            env5Inc = (envNextValue - env5Value) * inv32;
+            env5Inc = (envNextValue - env5Value) * invBlockSize;
             this->env5ValueMem = envNextValue;
 
             env6Value = this->env6ValueMem;
             envNextValue = currentTimbre->env6_.getNextAmpExp(&envState6_);
-            env6Inc = (envNextValue - env6Value) * inv32;
+            env6Inc = (envNextValue - env6Value) * invBlockSize;
             this->env6ValueMem = envNextValue;
 
             oscState1_.frequency = oscState1_.mainFrequencyPlusMatrix;
@@ -3437,32 +3468,32 @@ void Voice::nextBlock() {
 
             env1Value = this->env1ValueMem;
             envNextValue = currentTimbre->env1_.getNextAmpExp(&envState1_);
-            env1Inc = (envNextValue - env1Value) * inv32;  // divide by 32
+            env1Inc = (envNextValue - env1Value) * invBlockSize;
             this->env1ValueMem = envNextValue;
 
             env2Value = this->env2ValueMem;
             envNextValue = currentTimbre->env2_.getNextAmpExp(&envState2_);
-            env2Inc = (envNextValue - env2Value) * inv32;
+            env2Inc = (envNextValue - env2Value) * invBlockSize;
             this->env2ValueMem = envNextValue;
 
             env3Value = this->env3ValueMem;
             envNextValue = currentTimbre->env3_.getNextAmpExp(&envState3_);
-            env3Inc = (envNextValue - env3Value) * inv32;
+            env3Inc = (envNextValue - env3Value) * invBlockSize;
             this->env3ValueMem = envNextValue;
 
             env4Value = this->env4ValueMem;
             envNextValue = currentTimbre->env4_.getNextAmpExp(&envState4_);
-            env4Inc = (envNextValue - env4Value) * inv32;
+            env4Inc = (envNextValue - env4Value) * invBlockSize;
             this->env4ValueMem = envNextValue;
 
             env5Value = this->env5ValueMem;
             envNextValue = currentTimbre->env5_.getNextAmpExp(&envState5_);
-            env5Inc = (envNextValue - env5Value) * inv32;
+            env5Inc = (envNextValue - env5Value) * invBlockSize;
             this->env5ValueMem = envNextValue;
 
             env6Value = this->env6ValueMem;
             envNextValue = currentTimbre->env6_.getNextAmpExp(&envState6_);
-            env6Inc = (envNextValue - env6Value) * inv32;
+            env6Inc = (envNextValue - env6Value) * invBlockSize;
             this->env6ValueMem = envNextValue;
 
             oscState1_.frequency = oscState1_.mainFrequencyPlusMatrix;
@@ -3541,32 +3572,32 @@ void Voice::nextBlock() {
 
             env1Value = this->env1ValueMem;
             envNextValue = currentTimbre->env1_.getNextAmpExp(&envState1_);
-            env1Inc = (envNextValue - env1Value) * inv32;  // divide by 32
+            env1Inc = (envNextValue - env1Value) * invBlockSize;
             this->env1ValueMem = envNextValue;
 
             env2Value = this->env2ValueMem;
             envNextValue = currentTimbre->env2_.getNextAmpExp(&envState2_);
-            env2Inc = (envNextValue - env2Value) * inv32;
+            env2Inc = (envNextValue - env2Value) * invBlockSize;
             this->env2ValueMem = envNextValue;
 
             env3Value = this->env3ValueMem;
             envNextValue = currentTimbre->env3_.getNextAmpExp(&envState3_);
-            env3Inc = (envNextValue - env3Value) * inv32;
+            env3Inc = (envNextValue - env3Value) * invBlockSize;
             this->env3ValueMem = envNextValue;
 
             env4Value = this->env4ValueMem;
             envNextValue = currentTimbre->env4_.getNextAmpExp(&envState4_);
-            env4Inc = (envNextValue - env4Value) * inv32;
+            env4Inc = (envNextValue - env4Value) * invBlockSize;
             this->env4ValueMem = envNextValue;
 
             env5Value = this->env5ValueMem;
             envNextValue = currentTimbre->env5_.getNextAmpExp(&envState5_);
-            env5Inc = (envNextValue - env5Value) * inv32;
+            env5Inc = (envNextValue - env5Value) * invBlockSize;
             this->env5ValueMem = envNextValue;
 
             env6Value = this->env6ValueMem;
             envNextValue = currentTimbre->env6_.getNextAmpExp(&envState6_);
-            env6Inc = (envNextValue - env6Value) * inv32;
+            env6Inc = (envNextValue - env6Value) * invBlockSize;
             this->env6ValueMem = envNextValue;
 
             oscState1_.frequency = oscState1_.mainFrequencyPlusMatrix;
@@ -3645,22 +3676,22 @@ void Voice::nextBlock() {
 
             env1Value = this->env1ValueMem;
             envNextValue = currentTimbre->env1_.getNextAmpExp(&envState1_);
-            env1Inc = (envNextValue - env1Value) * inv32;  // divide by 32
+            env1Inc = (envNextValue - env1Value) * invBlockSize;
             this->env1ValueMem = envNextValue;
 
             env2Value = this->env2ValueMem;
             envNextValue = currentTimbre->env2_.getNextAmpExp(&envState2_);
-            env2Inc = (envNextValue - env2Value) * inv32;
+            env2Inc = (envNextValue - env2Value) * invBlockSize;
             this->env2ValueMem = envNextValue;
 
             env3Value = this->env3ValueMem;
             envNextValue = currentTimbre->env3_.getNextAmpExp(&envState3_);
-            env3Inc = (envNextValue - env3Value) * inv32;
+            env3Inc = (envNextValue - env3Value) * invBlockSize;
             this->env3ValueMem = envNextValue;
 
             env4Value = this->env4ValueMem;
             envNextValue = currentTimbre->env4_.getNextAmpExp(&envState4_);
-            env4Inc = (envNextValue - env4Value) * inv32;
+            env4Inc = (envNextValue - env4Value) * invBlockSize;
             this->env4ValueMem = envNextValue;
 
             oscState4_.frequency = oscState4_.mainFrequencyPlusMatrix;
@@ -3690,7 +3721,7 @@ void Voice::nextBlock() {
 
                 // sync slave osc
                 if (unlikely(isSync)) {
-                    oscState1_.index = currentTimbre->osc1_.geIndexFromtPhase(phase);
+                    oscState1_.phase = oscState3_.phase;
                 }
 
                 oscState1_.frequency = freq3 * voiceIm1 + osc1FrequencyPlusMatrix;
@@ -3740,22 +3771,22 @@ void Voice::nextBlock() {
 
             env1Value = this->env1ValueMem;
             envNextValue = currentTimbre->env1_.getNextAmpExp(&envState1_);
-            env1Inc = (envNextValue - env1Value) * inv32;  // divide by 32
+            env1Inc = (envNextValue - env1Value) * invBlockSize;
             this->env1ValueMem = envNextValue;
 
             env2Value = this->env2ValueMem;
             envNextValue = currentTimbre->env2_.getNextAmpExp(&envState2_);
-            env2Inc = (envNextValue - env2Value) * inv32;
+            env2Inc = (envNextValue - env2Value) * invBlockSize;
             this->env2ValueMem = envNextValue;
 
             env3Value = this->env3ValueMem;
             envNextValue = currentTimbre->env3_.getNextAmpExp(&envState3_);
-            env3Inc = (envNextValue - env3Value) * inv32;
+            env3Inc = (envNextValue - env3Value) * invBlockSize;
             this->env3ValueMem = envNextValue;
 
             env4Value = this->env4ValueMem;
             envNextValue = currentTimbre->env4_.getNextAmpExp(&envState4_);
-            env4Inc = (envNextValue - env4Value) * inv32;
+            env4Inc = (envNextValue - env4Value) * invBlockSize;
             this->env4ValueMem = envNextValue;
 
             oscState4_.frequency = oscState4_.mainFrequencyPlusMatrix;
@@ -3788,8 +3819,8 @@ void Voice::nextBlock() {
 
                 // sync slave osc
                 if (unlikely(isSync)) {
-                    oscState1_.index = currentTimbre->osc1_.geIndexFromtPhase(phase);
-                    oscState2_.index = currentTimbre->osc2_.geIndexFromtPhase(phase);
+                    oscState1_.phase = oscState3_.phase;
+                    oscState2_.phase = oscState3_.phase;
                 }
 
                 oscState1_.frequency = freq3 * voiceIm1 + osc1FrequencyPlusMatrix + freq4 * voiceIm3;
@@ -3840,22 +3871,22 @@ void Voice::nextBlock() {
 
             env1Value = this->env1ValueMem;
             envNextValue = currentTimbre->env1_.getNextAmpExp(&envState1_);
-            env1Inc = (envNextValue - env1Value) * inv32;  // divide by 32
+            env1Inc = (envNextValue - env1Value) * invBlockSize;
             this->env1ValueMem = envNextValue;
 
             env2Value = this->env2ValueMem;
             envNextValue = currentTimbre->env2_.getNextAmpExp(&envState2_);
-            env2Inc = (envNextValue - env2Value) * inv32;
+            env2Inc = (envNextValue - env2Value) * invBlockSize;
             this->env2ValueMem = envNextValue;
 
             env3Value = this->env3ValueMem;
             envNextValue = currentTimbre->env3_.getNextAmpExp(&envState3_);
-            env3Inc = (envNextValue - env3Value) * inv32;
+            env3Inc = (envNextValue - env3Value) * invBlockSize;
             this->env3ValueMem = envNextValue;
 
             env4Value = this->env4ValueMem;
             envNextValue = currentTimbre->env4_.getNextAmpExp(&envState4_);
-            env4Inc = (envNextValue - env4Value) * inv32;
+            env4Inc = (envNextValue - env4Value) * invBlockSize;
             this->env4ValueMem = envNextValue;
 
             float div3TimesVelocity = .33f * this->velocity;
@@ -3886,9 +3917,9 @@ void Voice::nextBlock() {
 
                 // sync slave osc
                 if (unlikely(isSync)) {
-                    oscState1_.index = currentTimbre->osc1_.geIndexFromtPhase(phase);
-                    oscState2_.index = currentTimbre->osc2_.geIndexFromtPhase(phase);
-                    oscState3_.index = currentTimbre->osc3_.geIndexFromtPhase(phase);
+                    oscState1_.phase = oscState4_.phase;
+                    oscState2_.phase = oscState4_.phase;
+                    oscState3_.phase = oscState4_.phase;
                 }
 
                 oscState3_.frequency = freq4 * voiceIm3 + osc3FrequencyPlusMatrix;
@@ -3948,22 +3979,22 @@ void Voice::nextBlock() {
 
             env1Value = this->env1ValueMem;
             envNextValue = currentTimbre->env1_.getNextAmpExp(&envState1_);
-            env1Inc = (envNextValue - env1Value) * inv32;  // divide by 32
+            env1Inc = (envNextValue - env1Value) * invBlockSize;
             this->env1ValueMem = envNextValue;
 
             env2Value = this->env2ValueMem;
             envNextValue = currentTimbre->env2_.getNextAmpExp(&envState2_);
-            env2Inc = (envNextValue - env2Value) * inv32;
+            env2Inc = (envNextValue - env2Value) * invBlockSize;
             this->env2ValueMem = envNextValue;
 
             env3Value = this->env3ValueMem;
             envNextValue = currentTimbre->env3_.getNextAmpExp(&envState3_);
-            env3Inc = (envNextValue - env3Value) * inv32;
+            env3Inc = (envNextValue - env3Value) * invBlockSize;
             this->env3ValueMem = envNextValue;
 
             env4Value = this->env4ValueMem;
             envNextValue = currentTimbre->env4_.getNextAmpExp(&envState4_);
-            env4Inc = (envNextValue - env4Value) * inv32;
+            env4Inc = (envNextValue - env4Value) * invBlockSize;
             this->env4ValueMem = envNextValue;
 
             oscState2_.frequency = oscState2_.mainFrequencyPlusMatrix;
@@ -3998,7 +4029,7 @@ void Voice::nextBlock() {
 
                 // sync slave osc
                 if (unlikely(isSync)) {
-                    oscState1_.index = currentTimbre->osc1_.geIndexFromtPhase(phase);
+                    oscState1_.phase = oscState4_.phase;
                 }
 
                 oscState1_.frequency = freq2 * voiceIm1 + freq3 * voiceIm2 + freq4 * voiceIm3 + osc1FrequencyPlusMatrix;
@@ -4051,6 +4082,7 @@ void Voice::setCurrentTimbre(Timbre *timbre) {
     struct StepSequencerSteps *stepseqs[] = { &timbre->getParamRaw()->lfoSteps1, &timbre->getParamRaw()->lfoSteps2 };
 
     this->currentTimbre = timbre;
+    controlValuesChanged();
 
     matrix.init(&timbre->getParamRaw()->matrixRowState1);
 
@@ -7436,8 +7468,10 @@ void Voice::fxAfterBlock() {
 
             bool accent = velocity > 0.629f && !isReleased();
 
-            const float ga = 0.9764716867f; //= exp(-1/(PREENFM_FREQUENCY * attack / BLOCK_SIZE))
-            const float gr = 0.9979969962f; //= exp(-1/(PREENFM_FREQUENCY * release / BLOCK_SIZE))
+            //= exp(-1/(PREENFM_FREQUENCY * attack / BLOCK_SIZE))
+            const float ga = BLOCK_SIZE == 16 ? 0.9881658194f : (BLOCK_SIZE == 32 ? 0.9764716867f : 0.9534969549f);
+            //= exp(-1/(PREENFM_FREQUENCY * release / BLOCK_SIZE))
+            const float gr = BLOCK_SIZE == 16 ? 0.9989979961f : (BLOCK_SIZE == 32 ? 0.9979969962f : 0.9959980044f);
 
             //accent cv (fxParamA1) :
             if ((accent && (fxParamB2-- > 0))) {
@@ -7446,7 +7480,7 @@ void Voice::fxAfterBlock() {
                 fxParamA1 = (fxParamA1 * 24.1f + fxParamA2) * 0.04f; //faster build up
             } else {
                 fxParamA2 *= gr;
-                fxParamB2 = 720; // = accent dur
+                fxParamB2 = 23040 / BLOCK_SIZE; // = accent dur (720 blocks of 32 samples)
                 fxParamA1 = (fxParamA1 * 24 + fxParamA2) * 0.04f; //smooth release
             }
 
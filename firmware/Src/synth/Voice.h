@@ -28,15 +28,27 @@
  \param [in]    sat  Bit position to saturate to (0..31)
  \return             Saturated value
  */
+#ifdef __arm__
 #define __USAT(ARG1,ARG2) \
 ({                          \
   uint32_t __RES, __ARG1 = (ARG1); \
   asm ("usat %0, %1, %2" : "=r" (__RES) :  "I" (ARG2), "r" (__ARG1) ); \
   __RES; \
  })
+#else
+// Host build (scripts/host)
+#define __USAT(ARG1,ARG2) \
+({                          \
+  int32_t __ARG1 = (ARG1); \
+  (uint32_t) (__ARG1 < 0 ? 0 : (__ARG1 > (1 << (ARG2)) - 1 ? (1 << (ARG2)) - 1 : __ARG1)); \
+ })
+#endif
 
 class Timbre;
 
+#define NUMBER_OF_MODULATION_INDEX_DESTINATIONS 6
+#define NUMBER_OF_MIX_AND_PAN_DESTINATIONS 10
+
 class Voice {
     friend class Timbre;
 
@@ -69,6 +81,10 @@ public:
     bool isNewNotePending() {
         return this->newNotePending;
     }
+    // Operator 1 is a carrier in all algos
+    bool isInAttack() {
+        return this->envState1_.envState == ENV_STATE_ON_A;
+    }
     uint32_t getIndex() {
         return this->index;
     }
@@ -82,6 +98,7 @@ public:
         return this->noteFrequency;
     }
     float getNoteRealFrequencyEstimation(float newNoteFrequency);
+    float getCarrierEnvLevel();
     char getNextPendingNote() {
         return this->pendingNote;
     }
@@ -103,7 +120,23 @@ public:
         return gliding;
     }
 
+    // Modulation indexes, mix and pans are only recomputed when the params, the velocity
+    // or the matrix destinations they read have changed since the previous block
+    void controlValuesChanged() {
+        this->modulationIndexesDirty = true;
+        this->mixOscsAndPansDirty = true;
+    }
+
     void updateAllModulationIndexes() {
+        bool matrixChanged = matrixDestinationsChanged(modulationIndexDestinations, NUMBER_OF_MODULATION_INDEX_DESTINATIONS,
+            modulationIndexMatrixValues);
+        if (likely(!matrixChanged && !modulationIndexesDirty && modulationIndexesParamsVersion == currentTimbre->paramsVersion_)) {
+            return;
+        }
+        modulationIndexesDirty = false;
+        modulationIndexesParamsVersion = currentTimbre->paramsVersion_;
+        currentTimbre->controlUpdates_++;
+
         int numberOfIMs = algoInformation[(int) (currentTimbre->getParamRaw()->engine1.algo)].im;
 
         // Feedback range is [0:1] compared to [0:16] of other modulation, let's divide the modulation impact by 16 (* 0.0625)
@@ -149,11 +182,29 @@ public:
     }
 
     void updateAllMixOscsAndPans() {
+        // add a LP on mix when MPE to mitigate noise dur to midi CC being [0-127]
+        bool notMPE = currentTimbre->timbreNumber_ != 0 || currentTimbre->getMPESetting() == 0;
+
+        bool matrixChanged = matrixDestinationsChanged(mixOscsAndPansDestinations, NUMBER_OF_MIX_AND_PAN_DESTINATIONS,
+            mixOscsAndPansMatrixValues);
+        // Pans (and mix when MPE) are low passed : keep computing until they don't move anymore
+        if (likely(!matrixChanged && !mixOscsAndPansDirty && mixOscsAndPansParamsVersion == currentTimbre->paramsVersion_
+            && mixOscsAndPansNotMPE == notMPE)) {
+            return;
+        }
+        mixOscsAndPansParamsVersion = currentTimbre->paramsVersion_;
+        mixOscsAndPansNotMPE = notMPE;
+        currentTimbre->controlUpdates_++;
+
+        mixOscsAndPansDirty = computeAllMixOscsAndPans(notMPE);
+    }
+
+    // Returns true while the low passed values are still moving
+    bool computeAllMixOscsAndPans(bool notMPE) {
         float inv65535 = .0000152587890625; // 1/ 65535
         int pan;
         int numberOfMix = algoInformation[(int) (currentTimbre->getParamRaw()->engine1.algo)].mix;
-        // add a LP on mix when MPE to mitigate noise dur to midi CC being [0-127]
-        bool notMPE = currentTimbre->timbreNumber_ != 0 || currentTimbre->getMPESetting() == 0;
+        bool moving = false;
 
 
         mix1 = currentTimbre->getParamRaw()->engineMix1.mixOsc1 + matrix.getDestination(MIX_OSC1) + matrix.getDestination(ALL_MIX);
@@ -162,16 +213,16 @@ public:
             mix1 = __USAT((int)(mix1 * 65536) , 16) * inv65535;
         } else {
             mix1 = __USAT((int)((mix1 * .05 + mix1Previous * .95) * 65536) , 16) * inv65535;
+            moving |= mix1 != mix1Previous;
             mix1Previous = mix1;
         }
         float pan1 = currentTimbre->getParamRaw()->engineMix1.panOsc1 + matrix.getDestination(PAN_OSC1) + matrix.getDestination(ALL_PAN) + 1.0f;
         // pan1 is between -1 and 1 : Scale from 0.0 to 256
         pan = __USAT((int )(pan1 * 128), 8);
-        pan1Left = panTable[pan] * .05f + pan1Left * .95f;
-        pan1Right = panTable[256 - pan] * .05f + pan1Right * .95f;
+        moving |= smoothPan(pan, pan1Left, pan1Right);
 
         if (unlikely(numberOfMix == 1)) {
-            return;
+            return moving;
         }
 
         mix2 = currentTimbre->getParamRaw()->engineMix1.mixOsc2 + matrix.getDestination(MIX_OSC2) + matrix.getDestination(ALL_MIX);
@@ -179,15 +230,15 @@ public:
             mix2 = __USAT((int)(mix2 * 65535) , 16) * inv65535;
         } else {
             mix2 = __USAT((int)((mix2 * .05 + mix2Previous * .95) * 65535) , 16) * inv65535;
+            moving |= mix2 != mix2Previous;
             mix2Previous = mix2;
         }
         float pan2 = currentTimbre->getParamRaw()->engineMix1.panOsc2 + matrix.getDestination(PAN_OSC2) + matrix.getDestination(ALL_PAN) + 1.0f;
         pan = __USAT((int )(pan2 * 128), 8);
-        pan2Left = panTable[pan] * .05f + pan2Left * .95f;
-        pan2Right = panTable[256 - pan] * .05f + pan2Right * .95f;
+        moving |= smoothPan(pan, pan2Left, pan2Right);
 
         if (unlikely(numberOfMix == 2)) {
-            return;
+            return moving;
         }
 
         mix3 = currentTimbre->getParamRaw()->engineMix2.mixOsc3 + matrix.getDestination(MIX_OSC3) + matrix.getDestination(ALL_MIX);
@@ -195,15 +246,15 @@ public:
             mix3 = __USAT((int)(mix3 * 65535) , 16) * inv65535;
         } else {
             mix3 = __USAT((int)((mix3 * .05 + mix3Previous * .95) * 65535) , 16) * inv65535;
+            moving |= mix3 != mix3Previous;
             mix3Previous = mix3;
         }
         float pan3 = currentTimbre->getParamRaw()->engineMix2.panOsc3 + matrix.getDestination(PAN_OSC3) + matrix.getDestination(ALL_PAN) + 1.0f;
         pan = __USAT((int )(pan3 * 128), 8);
-        pan3Left = panTable[pan] * .05f + pan3Left * .95f;
-        pan3Right = panTable[256 - pan] * .05f + pan3Right * .95f;
+        moving |= smoothPan(pan, pan3Left, pan3Right);
 
         if (numberOfMix == 3) {
-            return;
+            return moving;
         }
 
         // No matrix for mix4 and pan4
@@ -212,15 +263,15 @@ public:
             mix4 = __USAT((int)(mix4 * 65535) , 16) * inv65535;
         } else {
             mix4 = __USAT((int)((mix4 * .05 + mix4Previous * .95) * 65535) , 16) * inv65535;
+            moving |= mix4 != mix4Previous;
             mix4Previous = mix4;
         }
         float pan4 = currentTimbre->getParamRaw()->engineMix2.panOsc4 + matrix.getDestination(PAN_OSC4) + matrix.getDestination(ALL_PAN) + 1.0f;
         pan = __USAT((int )(pan4 * 128), 8);
-        pan4Left = panTable[pan] * .05f + pan4Left * .95f;
-        pan4Right = panTable[256 - pan] * .05f + pan4Right * .95f;
+        moving |= smoothPan(pan, pan4Left, pan4Right);
 
         if (numberOfMix == 4) {
-            return;
+            return moving;
         }
 
         mix5 = currentTimbre->getParamRaw()->engineMix3.mixOsc5 + matrix.getDestination(ALL_MIX);
@@ -228,26 +279,28 @@ public:
             mix5 = __USAT((int)(mix5 * 65535) , 16) * inv65535;
         } else {
             mix5 = __USAT((int)((mix5 * .05 + mix5Previous * .95) * 65535) , 16) * inv65535;
+            moving |= mix5 != mix5Previous;
             mix5Previous = mix5;
         }
 
         float pan5 = currentTimbre->getParamRaw()->engineMix3.panOsc5 + matrix.getDestination(ALL_PAN) + 1.0f;
         pan = __USAT((int )(pan5 * 128), 8);
-        pan5Left = panTable[pan] * .05f + pan5Left * .95f;
-        pan5Right = panTable[256 - pan] * .05f + pan5Right * .95f;
+        moving |= smoothPan(pan, pan5Left, pan5Right);
 
         mix6 = currentTimbre->getParamRaw()->engineMix3.mixOsc6 + matrix.getDestination(ALL_MIX);
         if (likely(notMPE)) {
             mix6 = __USAT((int)(mix6 * 65535) , 16) * inv65535;
         } else {
             mix6 = __USAT((int)((mix6 * .05 + mix6Previous * .95) * 65535) , 16) * inv65535;
+            moving |= mix6 != mix6Previous;
             mix6Previous = mix6;
         }
 
         float pan6 = currentTimbre->getParamRaw()->engineMix3.panOsc6 + matrix.getDestination(ALL_PAN) + 1.0f;
         pan = __USAT((int )(pan6 * 128), 8);
-        pan6Left = panTable[pan] * .05f + pan6Left * .95f;
-        pan6Right = panTable[256 - pan] * .05f + pan6Right * .95f;
+        moving |= smoothPan(pan, pan6Left, pan6Right);
+
+        return moving;
     }
 
     void midiClockSongPositionStep(int songPosition, bool recomputeNext);
@@ -302,17 +355,22 @@ public:
         }
     }
 
-    void prepareMatrixForNewBlock() {
+    // Next values of the LFOs, LFO envelopes and step sequencers of this voice
+    void nextMatrixSources(bool keepLfoRunning) {
+        bool lfoActive = isPlaying() || keepLfoRunning;
 
         // first 3 LFO can be free running
-        if (likely(currentTimbre->isLfoUsed(0))) {
-            this->lfoOsc[0].nextValueInMatrix();
-        }
-        if (likely(currentTimbre->isLfoUsed(1))) {
-            this->lfoOsc[1].nextValueInMatrix();
-        }
-        if (likely(currentTimbre->isLfoUsed(2))) {
-            this->lfoOsc[2].nextValueInMatrix();
+        // Shared ones are computed by the timbre, the others only when needed by this voice
+        for (int k = 0; k < NUMBER_OF_LFO_OSC; k++) {
+            if (likely(currentTimbre->isLfoUsed(k))) {
+                if (currentTimbre->isLfoShared(k)) {
+                    if (lfoActive) {
+                        this->matrix.setSource((SourceEnum) (MATRIX_SOURCE_LFO1 + k), currentTimbre->getSharedLfoValue(k));
+                    }
+                } else if (lfoActive || !this->lfoOsc[k].isRestartedOnNoteOn()) {
+                    this->lfoOsc[k].nextValueInMatrix();
+                }
+            }
         }
 
         // Only compute the rest if playing
@@ -329,12 +387,44 @@ public:
             if (likely(currentTimbre->isLfoUsed(6))) {
                 this->lfoStepSeq[1].nextValueInMatrix();
             }
+        }
+    }
 
+    void prepareMatrixForNewBlock(bool keepLfoRunning) {
+        nextMatrixSources(keepLfoRunning);
+        if (likely(isPlaying())) {
             this->matrix.computeAllDestinations();
             updateAllModulationIndexes();
         }
     }
 
+    // Unison : same note, velocity and LFOs as unisonVoice, its destinations and modulation indexes are taken.
+    // The sources of this voice are not computed, copyMatrixSources catches up when the timbre leaves unison.
+    void prepareMatrixForNewBlock(Voice *unisonVoice) {
+        if (likely(isPlaying())) {
+            this->matrix.copyDestinations(&unisonVoice->matrix);
+            this->feedbackModulation = unisonVoice->feedbackModulation;
+            this->modulationIndex1 = unisonVoice->modulationIndex1;
+            this->modulationIndex2 = unisonVoice->modulationIndex2;
+            this->modulationIndex3 = unisonVoice->modulationIndex3;
+            this->modulationIndex4 = unisonVoice->modulationIndex4;
+            this->modulationIndex5 = unisonVoice->modulationIndex5;
+            // Not computed from this voice matrix
+            this->modulationIndexesDirty = true;
+        }
+    }
+
+    // The LFOs, LFO envelopes and step sequencers continue from the ones of unisonVoice
+    void copyMatrixSources(const Voice *unisonVoice) {
+        for (int k = 0; k < NUMBER_OF_LFO_OSC; k++) {
+            this->lfoOsc[k].copyState(&unisonVoice->lfoOsc[k]);
+        }
+        this->lfoEnv[0].copyState(&unisonVoice->lfoEnv[0]);
+        this->lfoEnv2[0].copyState(&unisonVoice->lfoEnv2[0]);
+        this->lfoStepSeq[0].copyState(&unisonVoice->lfoStepSeq[0]);
+        this->lfoStepSeq[1].copyState(&unisonVoice->lfoStepSeq[1]);
+    }
+
     void afterNewParamsLoad() {
         this->matrix.resetSources();
         this->matrix.resetAllDestination();
@@ -384,6 +474,29 @@ private:
     // private function for BP filter
     void recomputeBPValues(float q, float fSquare);
 
+    // Keeps the last value of the destinations, true if one of them moved
+    bool matrixDestinationsChanged(const uint8_t *destinations, int numberOfDestinations, float *lastValues) {
+        bool changed = false;
+        for (int d = 0; d < numberOfDestinations; d++) {
+            float value = matrix.getDestination((DestinationEnum) destinations[d]);
+            if (value != lastValues[d]) {
+                lastValues[d] = value;
+                changed = true;
+            }
+        }
+        return changed;
+    }
+
+    // pan is between 0 and 256, returns false when the low passed pan does not move anymore
+    bool smoothPan(int pan, float &panLeft, float &panRight) {
+        float newPanLeft = panTable[pan] * .05f + panLeft * .95f;
+        float newPanRight = panTable[256 - pan] * .05f + panRight * .95f;
+        bool moving = newPanLeft != panLeft || newPanRight != panRight;
+        panLeft = newPanLeft;
+        panRight = newPanRight;
+        return moving;
+    }
+
     // voice status
     bool released;
     bool playing;
@@ -461,6 +574,16 @@ private:
     float mix1Previous, mix2Previous, mix3Previous, mix4Previous, mix5Previous, mix6Previous;
     float pan1Left, pan2Left, pan3Left, pan4Left, pan5Left, pan6Left;
     float pan1Right, pan2Right, pan3Right, pan4Right, pan5Right, pan6Right;
+    // Change tracking of the values above
+    static const uint8_t modulationIndexDestinations[NUMBER_OF_MODULATION_INDEX_DESTINATIONS];
+    static const uint8_t mixOscsAndPansDestinations[NUMBER_OF_MIX_AND_PAN_DESTINATIONS];
+    float modulationIndexMatrixValues[NUMBER_OF_MODULATION_INDEX_DESTINATIONS];
+    float mixOscsAndPansMatrixValues[NUMBER_OF_MIX_AND_PAN_DESTINATIONS];
+    uint32_t modulationIndexesParamsVersion;
+    uint32_t mixOscsAndPansParamsVersion;
+    bool modulationIndexesDirty;
+    bool mixOscsAndPansDirty;
+    bool mixOscsAndPansNotMPE;
     //
     LfoOsc lfoOsc[NUMBER_OF_LFO_OSC];
     LfoEnv lfoEnv[NUMBER_OF_LFO_ENV];
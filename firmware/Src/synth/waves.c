@@ -24,7 +24,7 @@ float diatonicScaleFrequency[]  = {
 4698.636286678519   , 4978.031739553294   , 5274.04091060592    , 5587.65170292806    , 5919.910763386151   ,
 6271.926975707992   , 6644.875161279119   , 7040                , 7458.620184289442   , 7902.132820097983   ,
 8372.018089619156   , 8869.84419125991    , 9397.272573357039   , 9956.063479106588   , 10548.081821211841  ,
-11175.30340585612   , 11839.821526772303  };
+11175.30340585612   , 11839.821526772303  , 12543.853951415975  };
 
 float sinTable[]   = {
  // =================================================================
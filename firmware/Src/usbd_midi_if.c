@@ -23,12 +23,11 @@
 extern USBD_HandleTypeDef hUsbDeviceFS;
 
 // Only one function to register
-void preenfm3_usbDataReceive(uint8_t *buffer);
+uint8_t preenfm3_usbDataReceive(uint8_t *buffer);
 
 static int8_t dataReceived(uint8_t* buffer) {
-    preenfm3_usbDataReceive(buffer);
-
-    return USBD_OK;
+    // Busy : the endpoint NAKs until preenfm3DecodeMidiIn makes room
+    return preenfm3_usbDataReceive(buffer) ? USBD_OK : USBD_BUSY;
 }
 
 
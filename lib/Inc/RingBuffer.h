@@ -57,6 +57,10 @@ public:
 	    return count;
 	}
 
+	int getFreeCount() {
+	    return size - 1 - getCount();
+	}
+
 	void appendBlock(T* block, int number) {
 		for (int k=0; k<number ; k++) {
 			insert(block[k]);
@@ -53,7 +53,8 @@ enum {
     TFT_RESTART_REFRESH,
     TFT_PAUSE_REFRESH,
     TFT_WAITCYCLE,
-    TFT_STANDARD_LAST_ACTION = TFT_WAITCYCLE
+    TFT_DISPLAY_GLYPH_RUN,
+    TFT_STANDARD_LAST_ACTION = TFT_DISPLAY_GLYPH_RUN
 };
 
 
@@ -65,6 +66,22 @@ enum {
 
 #define TFT_NUMBER_OF_PARTS 8
 
+// Dirty rectangles narrower than the screen are packed here before being pushed
+#define TFT_PUSH_BUFFER_SIZE (240 * 20)
+
+// Glyph run : consecutive chars of one line blended in a single DMA2D pass
+// Pool entries are [color, bgColor, glyph indexes...], the pool size must divide 65536
+#define TFT_GLYPH_RUN_POOL_SIZE 1024
+#define TFT_GLYPH_RUN_POOL_MASK (TFT_GLYPH_RUN_POOL_SIZE - 1)
+#define TFT_GLYPH_RUN_MAX_CHARS (240 / 7)
+
+// Shadow grids of the chars on screen, one per char size
+// A big char cell is 11x20 pixels but only 18 lines are drawn
+#define TFT_SHADOW_BIG_COLUMNS (240 / TFT_BIG_CHAR_WIDTH)
+#define TFT_SHADOW_BIG_ROWS (320 / TFT_BIG_CHAR_HEIGHT)
+#define TFT_SHADOW_SMALL_COLUMNS (240 / TFT_SMALL_CHAR_WIDTH)
+#define TFT_SHADOW_SMALL_ROWS (320 / TFT_SMALL_CHAR_HEIGHT)
+
 
 #define RAM_D1_SECTION __attribute__((section(".ram_d1")))
 #define DMA2D_POSITION_NLR_PL         (uint32_t)POSITION_VAL(DMA2D_NLR_PL)        /*!< Required left shift to set pixels per lines value */
@@ -102,7 +119,7 @@ enum TFTActionType {
 };
 
 struct TFTAction {
-    uint8_t actionType :4;
+    uint8_t actionType :5;
     uint8_t param1;
     uint16_t param2;
     uint8_t param3;
@@ -112,6 +129,12 @@ struct TFTAction {
 
 #define OSCILLO_WIDTH 160
 #define OSCILLO_BUFFER_SIZE 1024
+// Capture tap written by the audio interrupt, must be a power of 2
+#define OSCILLO_TAP_SIZE 4096
+#define OSCILLO_TAP_MASK (OSCILLO_TAP_SIZE - 1)
+// Timebase 0 shows one period of the lowest note, n > 0 shows 2^(n-1) samples per pixel
+#define OSCILLO_TIMEBASE_AUTO 0
+#define OSCILLO_NUMBER_OF_TIMEBASES 5
 
 #define PFM_IS_DMA2D_READY() (hdma2d.Instance->CR & DMA2D_CR_START) == 0
 #define PFM_START_DMA2D() hdma2d.Instance->CR |= DMA2D_CR_START
@@ -150,7 +173,7 @@ public:
     void print(char c, TFT_COLOR color, TFT_COLOR bgColor);
     void printFloatWithOneDecimal(float f);
     void print(float f);
-    void setDirtyArea(uint16_t y, uint16_t height);
+    void setDirtyArea(uint16_t x, uint16_t y, uint16_t width, uint16_t height);
 
     void drawButton(const char* label, uint16_t y, uint8_t dyLine2, uint8_t buttonNumber, uint8_t numberOfStates, uint8_t activeState,
             TFT_COLOR background = COLOR_DARK_BLUE);
@@ -165,12 +188,16 @@ public:
     void fillArea(uint8_t x, uint16_t y, uint8_t width, uint16_t height, uint8_t color);
     virtual void clearActions() {
         tftActions.clear();
+        glyphRunPoolRead = glyphRunPoolWrite;
+        // Pending draws are lost, the shadow grids cannot be trusted
+        shadowInvalidate(0, 0, 240, 320);
     }
 
     // Oscillo
     void oscilloRrefresh();
     void oscilloNewLowerFrequency(float lf);
-    void oscilloRecord32Samples(float *samples);
+    void oscilloRecordSamples(float *samples, int numberOfSamples);
+    void oscilloSetTimebase(uint8_t timebase) { oscilloTimebase = timebase; }
 
     void drawAlgo(int algo);
     void highlightOperator(int op);
@@ -191,6 +218,17 @@ public:
     int getNumberOfPendingActions() {
         return tftActions.getCount();
     }
+    // Actions refused because the queue was full
+    uint32_t getNumberOfDroppedActions() {
+        return numberOfDroppedActions;
+    }
+    // Chars not queued because the same char is already on screen
+    uint32_t getShadowHits() {
+        return shadowHits;
+    }
+    uint32_t getShadowMisses() {
+        return shadowMisses;
+    }
 
     void printValueWithSpace(int value);
     void printFloatWithSpace(float value);
@@ -202,6 +240,8 @@ public:
 
     void drawLevelMetter(uint16_t x, uint16_t y, uint16_t width, uint16_t height, uint8_t pixelPerDb, float volume, bool isComp, float gr);
 
+    uint32_t getPushedBytesPerSecond() { return pushedBytesPerSecond; }
+
     bool mustBeReset() { return tftMustBeReset_; }
     void reset();
 
@@ -213,12 +253,22 @@ protected:
     uint8_t currentActionStep;
     TftAlgo *tftAlgo;
 
+    bool insertAction(const TFTAction &action);
+    void shadowInvalidate(uint8_t x, uint16_t y, uint8_t width, uint16_t height);
+
 private:
     void oscilloBgDrawOperatorShape(float* waveForm, int size);
     void oscilloBgDrawEnvelope();
     void oscilloBgDrawLfo();
     void oscilloFillWithRand(int randtype);
     void oscilloBgDrawLine(int16_t x1, int16_t y1, int16_t x2, int16_t y2, uint16_t color);
+    bool printRun(const char* str, int length, bool smallChars, uint8_t color, uint8_t bgColor);
+    int queueGlyphRun(const char* str, int length, bool smallChars, uint8_t color, uint8_t bgColor);
+    void queueChar(char c, bool smallChars, uint8_t color, uint8_t bgColor);
+    bool shadowMatch(int x, uint16_t y, bool smallChars, uint8_t glyph, uint8_t color, uint8_t bgColor);
+    void shadowSetChar(uint8_t x, uint16_t y, bool smallChars, uint8_t glyph, uint8_t color, uint8_t bgColor);
+    void shadowFill(uint8_t x, uint16_t y, uint8_t width, uint16_t height, uint8_t color);
+    void shadowUpdate(const TFTAction &action);
 
     uint32_t lastOscilloSaturateTic;
     uint32_t tftPushMillis;
@@ -237,13 +287,10 @@ private:
     float oscilloSamplePeriod;
     float oscilloLowerFrequency;
     float oscilloSampleInc;
-//	float oscilloSampleReadPtr;
-    int oscilloDataWritePtr;
-    float oscilloPhaseIndex;
-    uint32_t oscilloPhaseIndexToUse;
     float olscilloYScale;
+    volatile uint32_t oscilloTapWriteIndex;
+    uint8_t oscilloTimebase;
 
-    float oscilloFullPeriodSampl[OSCILLO_BUFFER_SIZE];
     uint8_t charBackgroundColor, charColor;
     uint16_t *bgColorChar[NUMBER_OF_TFT_COLORS];
     uint16_t *bgAlgo;
@@ -259,6 +306,22 @@ private:
     bool pushToTftInProgress;
     uint32_t tftDirtyBits;
     uint8_t part;
+    // Dirty rectangle of each part, bounds included
+    uint16_t dirtyX0[TFT_NUMBER_OF_PARTS];
+    uint16_t dirtyX1[TFT_NUMBER_OF_PARTS];
+    uint16_t dirtyY0[TFT_NUMBER_OF_PARTS];
+    uint16_t dirtyY1[TFT_NUMBER_OF_PARTS];
+    uint32_t pushedBytes;
+    uint32_t pushedBytesPerSecond;
+    uint32_t pushedBytesMillis;
+
+    // Glyph run pool, written by print, read by tic
+    uint8_t glyphRunPool[TFT_GLYPH_RUN_POOL_SIZE];
+    volatile uint16_t glyphRunPoolWrite;
+    volatile uint16_t glyphRunPoolRead;
+    uint32_t numberOfDroppedActions;
+    uint32_t shadowHits;
+    uint32_t shadowMisses;
 
     // 3 bytes to deal with power status
     uint8_t status_[4];
@@ -83,7 +83,7 @@ HAL_StatusTypeDef ILI9341_ReadPowerMode(uint8_t buff[1]);
 HAL_StatusTypeDef ILI9341_ReadDisplayStatus(uint8_t buff[5]);
 HAL_StatusTypeDef ILI9341_ReadPixelFormat(uint8_t buff[1]);
 
-HAL_StatusTypeDef ILI9341_SetAddressWindow(uint16_t y0, uint16_t y1);
+HAL_StatusTypeDef ILI9341_SetAddressWindow(uint16_t x0, uint16_t x1, uint16_t y0, uint16_t y1);
 
 #ifdef __cplusplus
 }
@@ -33,6 +33,14 @@
 RAM_D1_SECTION uint8_t tftForeground[60000];
 RAM_D1_SECTION uint16_t tftBackground[42860 * 2];
 RAM_D1_SECTION uint16_t tftMemory[240 * 320];
+RAM_D1_SECTION uint16_t tftPushBuffer[TFT_PUSH_BUFFER_SIZE];
+// RAM_D2 is full with the FxBus buffers
+RAM_D1_SECTION float oscilloTap[OSCILLO_TAP_SIZE];
+// One glyph run laid out as an A8 image, 18 lines of big chars or 10 lines of small chars
+RAM_D1_SECTION uint8_t tftGlyphRun[240 * 18];
+// What each char cell shows once the queued actions are done, 0 when unknown
+RAM_D1_SECTION uint32_t tftShadowBig[TFT_SHADOW_BIG_ROWS * TFT_SHADOW_BIG_COLUMNS];
+RAM_D1_SECTION uint32_t tftShadowSmall[TFT_SHADOW_SMALL_ROWS * TFT_SHADOW_SMALL_COLUMNS];
 
 extern DMA2D_HandleTypeDef hdma2d;
 extern RNG_HandleTypeDef hrng;
@@ -66,11 +74,75 @@ uint16_t convertTo565(uint32_t x) {
     return ((x & 0xf80000) >> 8) + ((x & 0xfc00) >> 5) + ((x & 0xf8) >> 3);
 }
 
+static inline uint8_t glyphIndex(uint8_t c, bool smallChars) {
+    if (smallChars) {
+        return ((c >= 32) && (c < 32 + 97)) ? c - 32 : 3;
+    }
+    return ((c >= 32) && (c <= 32 + NUMBER_OF_CHARS)) ? c - 32 : 3;
+}
+
+static inline uint32_t shadowKey(uint8_t glyph, uint8_t color, uint8_t bgColor) {
+    // A space only shows its background
+    if (glyph == 0) {
+        color = bgColor;
+    }
+    return 0x80000000 | glyph | (color << 8) | (bgColor << 16);
+}
+
+/*
+ * Cell of the shadow grid for a char drawn at x, y. 0 if the char is not aligned on the grid.
+ */
+static inline uint32_t* shadowCell(int x, uint16_t y, bool smallChars) {
+    if (smallChars) {
+        if ((x % TFT_SMALL_CHAR_WIDTH) != 0 || (y % TFT_SMALL_CHAR_HEIGHT) != 0
+                || x >= TFT_SHADOW_SMALL_COLUMNS * TFT_SMALL_CHAR_WIDTH || y >= TFT_SHADOW_SMALL_ROWS * TFT_SMALL_CHAR_HEIGHT) {
+            return 0;
+        }
+        return &tftShadowSmall[(y / TFT_SMALL_CHAR_HEIGHT) * TFT_SHADOW_SMALL_COLUMNS + x / TFT_SMALL_CHAR_WIDTH];
+    }
+    if ((x % TFT_BIG_CHAR_WIDTH) != 0 || (y % TFT_BIG_CHAR_HEIGHT) != 0
+            || x >= TFT_SHADOW_BIG_COLUMNS * TFT_BIG_CHAR_WIDTH || y >= TFT_SHADOW_BIG_ROWS * TFT_BIG_CHAR_HEIGHT) {
+        return 0;
+    }
+    return &tftShadowBig[(y / TFT_BIG_CHAR_HEIGHT) * TFT_SHADOW_BIG_COLUMNS + x / TFT_BIG_CHAR_WIDTH];
+}
+
+/*
+ * Cells of a shadow grid fully covered by the area get fillKey, cells partially covered become unknown.
+ * Only cellHeight lines of each row are drawn.
+ */
+static void shadowGridArea(uint32_t *grid, int columns, int rows, int cellWidth, int rowHeight, int cellHeight,
+        int x, int y, int width, int height, uint32_t fillKey) {
+    if (width <= 0 || height <= 0) {
+        return;
+    }
+    int xRight = x + width;
+    int yBottom = y + height;
+    int c1 = (xRight - 1) / cellWidth;
+    int r1 = (yBottom - 1) / rowHeight;
+    if (c1 >= columns) {
+        c1 = columns - 1;
+    }
+    if (r1 >= rows) {
+        r1 = rows - 1;
+    }
+    for (int r = y / rowHeight; r <= r1; r++) {
+        int cellY = r * rowHeight;
+        if (cellY + cellHeight <= y) {
+            continue;
+        }
+        bool fullHeight = cellY >= y && cellY + cellHeight <= yBottom;
+        for (int c = x / cellWidth; c <= c1; c++) {
+            int cellX = c * cellWidth;
+            bool full = fullHeight && cellX >= x && cellX + cellWidth <= xRight;
+            grid[r * columns + c] = full ? fillKey : 0;
+        }
+    }
+}
+
 TftDisplay::TftDisplay() {
     pushToTftInProgress = false;
 
-    tftDirtyBits = TFT_PART_ALL_BITS;
-
     areaY[TFT_PART_HEADER] = 0;
     areaHeight[TFT_PART_HEADER] = 40;
 
@@ -91,16 +163,29 @@ TftDisplay::TftDisplay() {
     areaY[TFT_PART_BUTTONS] = 270;
     areaHeight[TFT_PART_BUTTONS] = 50;
 
+    tftDirtyBits = 0;
+    setDirtyArea(0, 0, 240, 320);
+    pushedBytes = 0;
+    pushedBytesPerSecond = 0;
+    pushedBytesMillis = 0;
+    glyphRunPoolWrite = 0;
+    glyphRunPoolRead = 0;
+    numberOfDroppedActions = 0;
+    shadowHits = 0;
+    shadowMisses = 0;
+    shadowInvalidate(0, 0, 240, 320);
+
     currentAction.actionType = 0;
     lastOscilloSaturateTic = 0;
     currentActionStep = 0;
 
     oscilloSamplePeriod = PREENFM_FREQUENCY / 440;
     oscilloSampleInc = oscilloSamplePeriod / OSCILLO_WIDTH;
-    oscilloPhaseIndex = 0.0f;
+    oscilloTapWriteIndex = 0;
+    oscilloTimebase = OSCILLO_TIMEBASE_AUTO;
 
-    for (int o = 0; o < OSCILLO_BUFFER_SIZE; o++) {
-        oscilloFullPeriodSampl[o] = 0.0f;
+    for (int o = 0; o < OSCILLO_TAP_SIZE; o++) {
+        oscilloTap[o] = 0.0f;
     }
 
     memset(tftMemory, 0, 240 * 320 * 2);
@@ -275,40 +360,49 @@ void TftDisplay::reset() {
 
 
 
-void TftDisplay::setDirtyArea(uint16_t y, uint16_t height) {
-
-    uint16_t yBottom = y + height;
-
-    if (unlikely(y < 40)) {
-        tftDirtyBits |= 0b00000001;
-    }
-
-    if (unlikely(y < 80 && yBottom >= 40)) {
-        tftDirtyBits |= 0b00000010;
-    }
-
-    if (unlikely(y < 120 && yBottom >= 80)) {
-        tftDirtyBits |= 0b00000100;
-    }
-
-    if (unlikely(y < 160 && yBottom >= 120)) {
-        tftDirtyBits |= 0b00001000;
-    }
-
-    if (unlikely(y < 200 && yBottom >= 160)) {
-        tftDirtyBits |= 0b00010000;
-    }
+/*
+ * Grow the dirty rectangle of all the parts crossed by this area
+ */
+void TftDisplay::setDirtyArea(uint16_t x, uint16_t y, uint16_t width, uint16_t height) {
 
-    if (unlikely(y < 240 && yBottom >= 200)) {
-        tftDirtyBits |= 0b00100000;
+    if (unlikely(width == 0 || height == 0)) {
+        return;
     }
 
-    if (unlikely(y < 270 && yBottom >= 230)) {
-        tftDirtyBits |= 0b01000000;
+    uint16_t xRight = x + width - 1;
+    uint16_t yBottom = y + height - 1;
+    if (unlikely(xRight > 239)) {
+        xRight = 239;
     }
 
-    if (unlikely(yBottom >= 270)) {
-        tftDirtyBits |= 0b10000000;
+    for (int p = 0; p < TFT_NUMBER_OF_PARTS; p++) {
+        uint16_t partBottom = areaY[p] + areaHeight[p] - 1;
+        if (y > partBottom || yBottom < areaY[p]) {
+            continue;
+        }
+        uint16_t y0 = y > areaY[p] ? y : areaY[p];
+        uint16_t y1 = yBottom < partBottom ? yBottom : partBottom;
+
+        if ((tftDirtyBits & (1UL << p)) == 0) {
+            tftDirtyBits |= (1UL << p);
+            dirtyX0[p] = x;
+            dirtyX1[p] = xRight;
+            dirtyY0[p] = y0;
+            dirtyY1[p] = y1;
+        } else {
+            if (x < dirtyX0[p]) {
+                dirtyX0[p] = x;
+            }
+            if (xRight > dirtyX1[p]) {
+                dirtyX1[p] = xRight;
+            }
+            if (y0 < dirtyY0[p]) {
+                dirtyY0[p] = y0;
+            }
+            if (y1 > dirtyY1[p]) {
+                dirtyY1[p] = y1;
+            }
+        }
     }
 }
 
@@ -319,6 +413,12 @@ void TftDisplay::tic(bool checkDisplayPower) {
     uint32_t offset;
     uint32_t currentMillis = HAL_GetTick();
 
+    if (unlikely((currentMillis - pushedBytesMillis) >= 1000)) {
+        pushedBytesPerSecond = pushedBytes;
+        pushedBytes = 0;
+        pushedBytesMillis = currentMillis;
+    }
+
     if (unlikely((currentMillis - tftPushMillis) > 20)) {
 
         // Only if previous DMA pushed is finished
@@ -372,7 +472,7 @@ void TftDisplay::tic(bool checkDisplayPower) {
             WRITE_REG(hdma2d.Instance->BGMAR, (uint32_t )(bgColorChar[currentAction.param5]));
             WRITE_REG(hdma2d.Instance->OMAR, (uint32_t )(tftMemory + offset));
 
-            setDirtyArea(currentAction.param2, 18);
+            setDirtyArea(currentAction.param1, currentAction.param2, TFT_BIG_CHAR_WIDTH, 18);
 
             currentAction.actionType = 0;
 
@@ -393,12 +493,70 @@ void TftDisplay::tic(bool checkDisplayPower) {
             WRITE_REG(hdma2d.Instance->BGMAR, (uint32_t )(bgColorChar[currentAction.param5]));
             WRITE_REG(hdma2d.Instance->OMAR, (uint32_t )(tftMemory + offset));
 
-            setDirtyArea(currentAction.param2, 10);
+            setDirtyArea(currentAction.param1, currentAction.param2, TFT_SMALL_CHAR_WIDTH, 10);
 
             currentAction.actionType = 0;
             PFM_START_DMA2D();
         }
         break;
+    case TFT_DISPLAY_GLYPH_RUN:
+        // 2 steps
+        // 0 : lay the glyphs side by side and blend the whole run
+        // 1 : restore the RGB565 background layer used by all other actions
+        switch (currentActionStep) {
+        case 0:
+            if (PFM_IS_DMA2D_READY()) {
+                bool smallChars = currentAction.param5 == 1;
+                uint8_t glyphWidth = smallChars ? TFT_SMALL_CHAR_WIDTH : TFT_BIG_CHAR_WIDTH;
+                uint8_t glyphHeight = smallChars ? 10 : 18;
+                uint8_t *glyphs = smallChars ? fgSmallChars : fgBigChars;
+                uint8_t numberOfChars = currentAction.param3;
+                uint16_t runWidth = numberOfChars * glyphWidth;
+                uint16_t poolIndex = currentAction.param4;
+                uint8_t color = glyphRunPool[poolIndex++ & TFT_GLYPH_RUN_POOL_MASK];
+                uint8_t bgColor = glyphRunPool[poolIndex++ & TFT_GLYPH_RUN_POOL_MASK];
+
+                for (int g = 0; g < numberOfChars; g++) {
+                    uint8_t *glyph = glyphs + glyphRunPool[(poolIndex + g) & TFT_GLYPH_RUN_POOL_MASK] * glyphWidth * glyphHeight;
+                    uint8_t *run = tftGlyphRun + g * glyphWidth;
+                    for (int l = 0; l < glyphHeight; l++) {
+                        memcpy(run, glyph, glyphWidth);
+                        glyph += glyphWidth;
+                        run += runWidth;
+                    }
+                }
+                // The pool entry is not needed anymore
+                glyphRunPoolRead = poolIndex + numberOfChars;
+
+                WRITE_REG(hdma2d.Instance->FGCOLR, tftPalette[color]);
+                // A8 background with a fixed color and alpha : no need for a background buffer as wide as the run
+                WRITE_REG(hdma2d.Instance->BGCOLR, tftPalette[bgColor]);
+                MODIFY_REG(hdma2d.Instance->BGPFCCR, (DMA2D_BGPFCCR_CM | DMA2D_BGPFCCR_AM | DMA2D_BGPFCCR_ALPHA),
+                        (DMA2D_INPUT_A8 | (DMA2D_REPLACE_ALPHA << DMA2D_BGPFCCR_AM_Pos) | (0xffUL << DMA2D_BGPFCCR_ALPHA_Pos)));
+                MODIFY_REG(hdma2d.Instance->CR, DMA2D_CR_MODE, DMA2D_M2M_BLEND);
+
+                offset = currentAction.param2 * 240 + currentAction.param1;
+                MODIFY_REG(hdma2d.Instance->OOR, DMA2D_OOR_LO, 240 - runWidth);
+                MODIFY_REG(hdma2d.Instance->BGOR, DMA2D_OOR_LO, 0);
+                MODIFY_REG(hdma2d.Instance->NLR, (DMA2D_NLR_NL|DMA2D_NLR_PL), (glyphHeight | (runWidth << DMA2D_POSITION_NLR_PL)));
+                WRITE_REG(hdma2d.Instance->FGMAR, (uint32_t )tftGlyphRun);
+                WRITE_REG(hdma2d.Instance->BGMAR, (uint32_t )tftGlyphRun);
+                WRITE_REG(hdma2d.Instance->OMAR, (uint32_t )(tftMemory + offset));
+
+                setDirtyArea(currentAction.param1, currentAction.param2, runWidth, glyphHeight);
+
+                currentActionStep = 1;
+                PFM_START_DMA2D();
+            }
+            break;
+        case 1:
+            if (PFM_IS_DMA2D_READY()) {
+                MODIFY_REG(hdma2d.Instance->BGPFCCR, (DMA2D_BGPFCCR_CM | DMA2D_BGPFCCR_AM | DMA2D_BGPFCCR_ALPHA), DMA2D_INPUT_RGB565);
+                currentAction.actionType = 0;
+            }
+            break;
+        }
+        break;
     case TFT_DRAW_FILL_TFT:
         // CLEAR tftMemory
         // 4 steps : tft is divided in 4 parts
@@ -415,7 +573,7 @@ void TftDisplay::tic(bool checkDisplayPower) {
             PFM_START_DMA2D();
 
             if (currentAction.param3 == 0) {
-                tftDirtyBits = TFT_PART_ALL_BITS;
+                setDirtyArea(0, 0, 240, 320);
                 currentAction.actionType = 0;
             } else {
                 currentAction.param3--;
@@ -467,7 +625,7 @@ void TftDisplay::tic(bool checkDisplayPower) {
                 WRITE_REG(hdma2d.Instance->OMAR, (uint32_t )(fgOscillo));
                 PFM_START_DMA2D();
                 currentAction.actionType = 0;
-                tftDirtyBits |= TFT_PART_OSCILLO_BITS;
+                setDirtyArea(TFT_OSCILLO_X, TFT_OSCILLO_Y, 160, 100);
             }
             break;
         }
@@ -530,7 +688,7 @@ void TftDisplay::tic(bool checkDisplayPower) {
                 WRITE_REG(hdma2d.Instance->OMAR, (uint32_t)(tftMemory + TFT_ALGO_Y * 240 + TFT_ALGO_X));
                 PFM_START_DMA2D();
 
-                tftDirtyBits |= TFT_PART_OSCILLO_BITS;
+                setDirtyArea(TFT_ALGO_X, TFT_ALGO_Y, 80, 100);
                 currentAction.actionType = 0;
             }
             break;
@@ -610,7 +768,7 @@ void TftDisplay::tic(bool checkDisplayPower) {
 
             PFM_START_DMA2D();
 
-            setDirtyArea(currentAction.param2, currentAction.param4);
+            setDirtyArea(currentAction.param1, currentAction.param2, currentAction.param3, currentAction.param4);
             currentAction.actionType = 0;
         }
         break;
@@ -636,7 +794,8 @@ void TftDisplay::tic(bool checkDisplayPower) {
 
 /*
  * Push tftMemory to physical TFT
- * Screen is divided into UPDATE_NUMBER_OF_PARTS parts, and only at a time is pushed.
+ * Screen is divided into TFT_NUMBER_OF_PARTS parts, only the dirty rectangle of one part is pushed at a time.
+ * A rectangle narrower than the screen is not contiguous in tftMemory : DMA2D packs it in tftPushBuffer first.
  */
 bool TftDisplay::pushToTft() {
 
@@ -644,24 +803,55 @@ bool TftDisplay::pushToTft() {
         return false;
     }
 
-    // 4 max - can break before
-    int p;
-    for (p = 0; p < TFT_NUMBER_OF_PARTS ; p++) {
+    for (int p = 0; p < TFT_NUMBER_OF_PARTS ; p++) {
         if ((tftDirtyBits & (1UL << part)) > 0) {
+            uint16_t x0 = dirtyX0[part];
+            uint16_t x1 = dirtyX1[part];
+            uint16_t y0 = dirtyY0[part];
+            uint16_t y1 = dirtyY1[part];
+            uint16_t width = x1 - x0 + 1;
+            uint16_t height = y1 - y0 + 1;
+            uint8_t *pixels;
+
+            if (width == 240 || (width * height) > TFT_PUSH_BUFFER_SIZE) {
+                // Full lines
+                x0 = 0;
+                x1 = 239;
+                width = 240;
+                pixels = (uint8_t *) (tftMemory + y0 * 240);
+            } else {
+                // tftPushBuffer can still be read by previous SPI DMA
+                if ((hdma2d.Instance->CR & DMA2D_CR_START) != 0 || HAL_SPI_GetState(&ILI9341_SPI_PORT) != HAL_SPI_STATE_READY) {
+                    return false;
+                }
+                // Memory to memory : FG color mode is used for input and output
+                MODIFY_REG(hdma2d.Instance->CR, DMA2D_CR_MODE, DMA2D_M2M);
+                MODIFY_REG(hdma2d.Instance->FGPFCCR, DMA2D_FGPFCCR_CM, DMA2D_INPUT_RGB565);
+                MODIFY_REG(hdma2d.Instance->FGOR, DMA2D_FGOR_LO, 240 - width);
+                MODIFY_REG(hdma2d.Instance->OOR, DMA2D_OOR_LO, 0);
+                MODIFY_REG(hdma2d.Instance->NLR, (DMA2D_NLR_NL|DMA2D_NLR_PL), (height | (width << DMA2D_POSITION_NLR_PL)));
+                WRITE_REG(hdma2d.Instance->FGMAR, (uint32_t )(tftMemory + y0 * 240 + x0));
+                WRITE_REG(hdma2d.Instance->OMAR, (uint32_t )(tftPushBuffer));
+                PFM_START_DMA2D();
+                // A few microseconds : wait and give back the A8 foreground the other actions expect
+                while ((hdma2d.Instance->CR & DMA2D_CR_START) != 0) {
+                }
+                MODIFY_REG(hdma2d.Instance->FGPFCCR, DMA2D_FGPFCCR_CM, DMA2D_INPUT_A8);
+                MODIFY_REG(hdma2d.Instance->FGOR, DMA2D_FGOR_LO, 0);
+                pixels = (uint8_t *) tftPushBuffer;
+            }
+
             // Update TFT part
             ILI9341_Select();
 
-
-            uint16_t height = areaHeight[part];
-            uint16_t y = areaY[part];
-
-            if (ILI9341_SetAddressWindow(y, y + height - 1) == HAL_OK) {
+            if (ILI9341_SetAddressWindow(x0, x1, y0, y1) == HAL_OK) {
 
                 PFM_SET_PIN(ILI9341_DC_GPIO_Port, ILI9341_DC_Pin);
 
-                if (HAL_OK == HAL_SPI_Transmit_DMA(&ILI9341_SPI_PORT, (uint8_t *) tftMemory + (y * 240 * 2), height * 240 * 2)) {
+                if (HAL_OK == HAL_SPI_Transmit_DMA(&ILI9341_SPI_PORT, pixels, width * height * 2)) {
                     tftDirtyBits &= ~(1UL << part);
                     pushToTftInProgress = true;
+                    pushedBytes += width * height * 2;
                 }
             }
             part = (part + 1) % TFT_NUMBER_OF_PARTS;
@@ -702,13 +892,13 @@ void TftDisplay::clearMixerValues() {
     newAction.param3 = 80;
     newAction.param4 = 190;
     newAction.param5 = COLOR_BLACK;
-    tftActions.insert(newAction);
+    insertAction(newAction);
     // Clear info line
     newAction.param1 = 0;
     newAction.param2 = 50;
     newAction.param3 = 240;
     newAction.param4 = 20;
-    tftActions.insert(newAction);
+    insertAction(newAction);
 }
 
 void TftDisplay::clearMixerLabels() {
@@ -719,7 +909,7 @@ void TftDisplay::clearMixerLabels() {
     newAction.param3 = 160;
     newAction.param4 = 190;
     newAction.param5 = COLOR_BLACK;
-    tftActions.insert(newAction);
+    insertAction(newAction);
 }
 
 
@@ -728,7 +918,7 @@ void TftDisplay::clear() {
     newAction.actionType = TFT_DRAW_FILL_TFT;
     newAction.param3 = TFT_NUMBER_OF_PARTS - 1;
     newAction.param5 = COLOR_BLACK;
-    tftActions.insert(newAction);
+    insertAction(newAction);
     bHasJustBeenCleared = true;
 }
 
@@ -773,106 +963,165 @@ void TftDisplay::printFloatWithOneDecimal(float f) {
 }
 
 void TftDisplay::print(const char* str) {
-    int i = 0;
-    char c = str[i++];
-    while (c != '\0') {
-        print(c);
-        c = str[i++];
-    }
+    printRun(str, 0x7fffffff, false, charColor, charBackgroundColor);
 }
 
 bool TftDisplay::print(const char* str, int length) {
-    int i = 0;
-    char c = str[i++];
-    while (c != '\0' && i <= length) {
-        print(c);
-        c = str[i++];
-    }
-    return c == '\0';
+    return printRun(str, length, false, charColor, charBackgroundColor);
 }
 
 
 void TftDisplay::printSmallChars(const char* str) {
-    int i = 0;
-    char c = str[i++];
-    while (c != '\0') {
-        printSmallChar(c);
-        c = str[i++];
-    }
+    printRun(str, 0x7fffffff, true, charColor, charBackgroundColor);
 }
 
 void TftDisplay::printSmallChars(const char* str, int length) {
-    int i = 0;
-    char c = str[i++];
-    while (c != '\0' and i <= length) {
-        printSmallChar(c);
-        c = str[i++];
-    }
+    printRun(str, length, true, charColor, charBackgroundColor);
 }
 
 
 void TftDisplay::print(const char* str, TFT_COLOR color, TFT_COLOR bgColor) {
-
-    int i = 0;
-    char c = str[i++];
-    while (c != '\0') {
-        print(c, color, bgColor);
-        c = str[i++];
-    }
+    printRun(str, 0x7fffffff, false, color, bgColor);
 }
 
 void TftDisplay::printSpaceTillEndOfLine() {
-    while (this->cursorX <= 240 - TFT_BIG_CHAR_WIDTH) {
-        print(' ');
+    char spaces[TFT_GLYPH_RUN_MAX_CHARS + 1];
+    int numberOfSpaces = 0;
+    if (this->cursorX <= 240 - TFT_BIG_CHAR_WIDTH) {
+        numberOfSpaces = (240 - this->cursorX) / TFT_BIG_CHAR_WIDTH;
     }
+    memset(spaces, ' ', numberOfSpaces);
+    spaces[numberOfSpaces] = '\0';
+    print(spaces);
 }
 
 void TftDisplay::print(int n) {
-    unsigned char buf[12];
-    unsigned long i = 0;
+    char buf[12];
+    int i = 11;
+    bool negative = n < 0;
 
-    if (unlikely(n == 0)) {
-        print('0');
-        return;
+    if (negative) {
+        n = -n;
     }
 
-    if (unlikely(n < 0)) {
-        print('-');
+    buf[i] = '\0';
+    do {
+        buf[--i] = '0' + n % 10;
+        n /= 10;
+    } while (n > 0);
+
+    if (negative) {
+        buf[--i] = '-';
+    }
+    print(&buf[i]);
+}
+
+void TftDisplay::printSmallChar(int n) {
+    char buf[12];
+    int i = 11;
+    bool negative = n < 0;
+
+    if (negative) {
         n = -n;
     }
 
-    while (n > 0) {
-        buf[i++] = n % 10;
+    buf[i] = '\0';
+    do {
+        buf[--i] = '0' + n % 10;
         n /= 10;
-    }
+    } while (n > 0);
 
-    for (; i > 0; i--) {
-        print((char) ('0' + buf[i - 1]));
+    if (negative) {
+        buf[--i] = '-';
     }
+    printSmallChars(&buf[i]);
 }
 
-void TftDisplay::printSmallChar(int n) {
-    unsigned char buf[12];
-    unsigned long i = 0;
+/*
+ * Print up to length chars of str.
+ * Returns true if the whole string has been printed.
+ */
+bool TftDisplay::printRun(const char* str, int length, bool smallChars, uint8_t color, uint8_t bgColor) {
+    uint8_t glyphWidth = smallChars ? TFT_SMALL_CHAR_WIDTH : TFT_BIG_CHAR_WIDTH;
+    int i = 0;
+    while (i < length && str[i] != '\0') {
+        if (shadowMatch(cursorX, cursorY, smallChars, glyphIndex(str[i], smallChars), color, bgColor)) {
+            // Already on screen
+            shadowHits++;
+            cursorX += glyphWidth;
+            i++;
+            continue;
+        }
+        // Chars that differ from the screen
+        int numberOfChars = 1;
+        while (i + numberOfChars < length && str[i + numberOfChars] != '\0'
+                && !shadowMatch(cursorX + numberOfChars * glyphWidth, cursorY, smallChars, glyphIndex(str[i + numberOfChars], smallChars), color, bgColor)) {
+            numberOfChars++;
+        }
+        numberOfChars = queueGlyphRun(str + i, numberOfChars, smallChars, color, bgColor);
+        if (numberOfChars == 0) {
+            // Single char or end of line
+            queueChar(str[i], smallChars, color, bgColor);
+            numberOfChars = 1;
+        } else {
+            shadowMisses += numberOfChars;
+        }
+        i += numberOfChars;
+    }
+    return str[i] == '\0';
+}
 
-    if (unlikely(n == 0)) {
-        printSmallChar('0');
-        return;
+/*
+ * Queue the chars of str that fit on the current line as one action.
+ * Returns the number of chars consumed, 0 if a run is not worth it.
+ */
+int TftDisplay::queueGlyphRun(const char* str, int length, bool smallChars, uint8_t color, uint8_t bgColor) {
+    uint8_t glyphWidth = smallChars ? TFT_SMALL_CHAR_WIDTH : TFT_BIG_CHAR_WIDTH;
+    int maxChars = cursorX < 240 ? (240 - cursorX) / glyphWidth : 0;
+    if (maxChars > TFT_GLYPH_RUN_MAX_CHARS) {
+        maxChars = TFT_GLYPH_RUN_MAX_CHARS;
+    }
+    if (maxChars > length) {
+        maxChars = length;
+    }
+    int poolFree = TFT_GLYPH_RUN_POOL_SIZE - (uint16_t) (glyphRunPoolWrite - glyphRunPoolRead) - 2;
+    if (maxChars > poolFree) {
+        maxChars = poolFree;
     }
 
-    if (unlikely(n < 0)) {
-        printSmallChar('-');
-        n = -n;
+    int numberOfChars = 0;
+    while (numberOfChars < maxChars && str[numberOfChars] != '\0') {
+        numberOfChars++;
+    }
+    if (numberOfChars < 2) {
+        return 0;
     }
 
-    while (n > 0) {
-        buf[i++] = n % 10;
-        n /= 10;
+    uint8_t x = cursorX;
+    cursorX += numberOfChars * glyphWidth;
+    if (unlikely(tftActions.isFull())) {
+        numberOfDroppedActions++;
+        return numberOfChars;
     }
 
-    for (; i > 0; i--) {
-        printSmallChar((char) ('0' + buf[i - 1]));
+    uint16_t poolIndex = glyphRunPoolWrite;
+    glyphRunPool[poolIndex++ & TFT_GLYPH_RUN_POOL_MASK] = color;
+    glyphRunPool[poolIndex++ & TFT_GLYPH_RUN_POOL_MASK] = bgColor;
+    for (int g = 0; g < numberOfChars; g++) {
+        glyphRunPool[poolIndex++ & TFT_GLYPH_RUN_POOL_MASK] = glyphIndex(str[g], smallChars);
     }
+
+    TFTAction newAction;
+    newAction.actionType = TFT_DISPLAY_GLYPH_RUN;
+    newAction.param1 = x;
+    newAction.param2 = cursorY;
+    newAction.param3 = numberOfChars;
+    newAction.param4 = glyphRunPoolWrite;
+    newAction.param5 = smallChars ? 1 : 0;
+    // The entry must be in the pool before the action is visible to tic
+    glyphRunPoolWrite = poolIndex;
+    insertAction(newAction);
+    return numberOfChars;
 }
 
 void TftDisplay::print(char c, TFT_COLOR color, TFT_COLOR bgColor) {
@@ -885,53 +1134,175 @@ void TftDisplay::print(char c, TFT_COLOR color, TFT_COLOR bgColor) {
     } else {
         newAction.param3 = 35;
     }
+    if (shadowMatch(cursorX, cursorY, false, newAction.param3, color, bgColor)) {
+        shadowHits++;
+        cursorX += TFT_BIG_CHAR_WIDTH;
+        return;
+    }
+    shadowMisses++;
     newAction.param4 = color;
     newAction.param5 = bgColor;
-    tftActions.insert(newAction);
+    insertAction(newAction);
     cursorX += TFT_BIG_CHAR_WIDTH;
 }
 
 void TftDisplay::print(char c) {
-    TFTAction newAction;
-    newAction.actionType = TFT_DISPLAY_ONE_CHAR;
-    newAction.param1 = cursorX;
-    newAction.param2 = cursorY;
-    if ((c >= 32) && (c <= 32 + NUMBER_OF_CHARS)) {
-        newAction.param3 = c - 32;
-    } else {
-        newAction.param3 = 3;
-    }
-    newAction.param4 = charColor;
-    newAction.param5 = charBackgroundColor;
-    tftActions.insert(newAction);
-    cursorX += TFT_BIG_CHAR_WIDTH;
+    queueChar(c, false, charColor, charBackgroundColor);
 }
 
 void TftDisplay::printSmallChar(char c) {
+    queueChar(c, true, charColor, charBackgroundColor);
+}
+
+void TftDisplay::queueChar(char c, bool smallChars, uint8_t color, uint8_t bgColor) {
     TFTAction newAction;
-    newAction.actionType = TFT_DISPLAY_ONE_SMALL_CHAR;
+    newAction.actionType = smallChars ? TFT_DISPLAY_ONE_SMALL_CHAR : TFT_DISPLAY_ONE_CHAR;
     newAction.param1 = cursorX;
     newAction.param2 = cursorY;
-    if ((c >= 32) && (c < 32 + 97)) {
-        newAction.param3 = c - 32;
+    newAction.param3 = glyphIndex(c, smallChars);
+    newAction.param4 = color;
+    newAction.param5 = bgColor;
+    cursorX += smallChars ? TFT_SMALL_CHAR_WIDTH : TFT_BIG_CHAR_WIDTH;
+    if (shadowMatch(newAction.param1, newAction.param2, smallChars, newAction.param3, color, bgColor)) {
+        shadowHits++;
+        return;
+    }
+    shadowMisses++;
+    insertAction(newAction);
+}
+
+bool TftDisplay::insertAction(const TFTAction &action) {
+    if (unlikely(tftActions.isFull())) {
+        // Screen and shadow grids keep their previous content
+        numberOfDroppedActions++;
+        return false;
+    }
+    tftActions.insert(action);
+    shadowUpdate(action);
+    return true;
+}
+
+bool TftDisplay::shadowMatch(int x, uint16_t y, bool smallChars, uint8_t glyph, uint8_t color, uint8_t bgColor) {
+    uint32_t *cell = shadowCell(x, y, smallChars);
+    return cell != 0 && *cell == shadowKey(glyph, color, bgColor);
+}
+
+void TftDisplay::shadowSetChar(uint8_t x, uint16_t y, bool smallChars, uint8_t glyph, uint8_t color, uint8_t bgColor) {
+    uint32_t *cell = shadowCell(x, y, smallChars);
+    if (smallChars) {
+        shadowGridArea(tftShadowBig, TFT_SHADOW_BIG_COLUMNS, TFT_SHADOW_BIG_ROWS, TFT_BIG_CHAR_WIDTH, TFT_BIG_CHAR_HEIGHT, 18,
+                x, y, TFT_SMALL_CHAR_WIDTH, TFT_SMALL_CHAR_HEIGHT, 0);
+        if (cell == 0) {
+            shadowGridArea(tftShadowSmall, TFT_SHADOW_SMALL_COLUMNS, TFT_SHADOW_SMALL_ROWS, TFT_SMALL_CHAR_WIDTH, TFT_SMALL_CHAR_HEIGHT,
+                    TFT_SMALL_CHAR_HEIGHT, x, y, TFT_SMALL_CHAR_WIDTH, TFT_SMALL_CHAR_HEIGHT, 0);
+        }
     } else {
-        newAction.param3 = 3;
+        shadowGridArea(tftShadowSmall, TFT_SHADOW_SMALL_COLUMNS, TFT_SHADOW_SMALL_ROWS, TFT_SMALL_CHAR_WIDTH, TFT_SMALL_CHAR_HEIGHT,
+                TFT_SMALL_CHAR_HEIGHT, x, y, TFT_BIG_CHAR_WIDTH, 18, 0);
+        if (cell == 0) {
+            shadowGridArea(tftShadowBig, TFT_SHADOW_BIG_COLUMNS, TFT_SHADOW_BIG_ROWS, TFT_BIG_CHAR_WIDTH, TFT_BIG_CHAR_HEIGHT, 18,
+                    x, y, TFT_BIG_CHAR_WIDTH, 18, 0);
+        }
+    }
+    if (cell != 0) {
+        *cell = shadowKey(glyph, color, bgColor);
     }
-    newAction.param4 = charColor;
-    newAction.param5 = charBackgroundColor;
-    tftActions.insert(newAction);
-    cursorX += TFT_SMALL_CHAR_WIDTH;
 }
 
+void TftDisplay::shadowFill(uint8_t x, uint16_t y, uint8_t width, uint16_t height, uint8_t color) {
+    uint32_t fillKey = shadowKey(0, color, color);
+    shadowGridArea(tftShadowBig, TFT_SHADOW_BIG_COLUMNS, TFT_SHADOW_BIG_ROWS, TFT_BIG_CHAR_WIDTH, TFT_BIG_CHAR_HEIGHT, 18,
+            x, y, width, height, fillKey);
+    shadowGridArea(tftShadowSmall, TFT_SHADOW_SMALL_COLUMNS, TFT_SHADOW_SMALL_ROWS, TFT_SMALL_CHAR_WIDTH, TFT_SMALL_CHAR_HEIGHT,
+            TFT_SMALL_CHAR_HEIGHT, x, y, width, height, fillKey);
+}
+
+void TftDisplay::shadowInvalidate(uint8_t x, uint16_t y, uint8_t width, uint16_t height) {
+    shadowGridArea(tftShadowBig, TFT_SHADOW_BIG_COLUMNS, TFT_SHADOW_BIG_ROWS, TFT_BIG_CHAR_WIDTH, TFT_BIG_CHAR_HEIGHT, 18,
+            x, y, width, height, 0);
+    shadowGridArea(tftShadowSmall, TFT_SHADOW_SMALL_COLUMNS, TFT_SHADOW_SMALL_ROWS, TFT_SMALL_CHAR_WIDTH, TFT_SMALL_CHAR_HEIGHT,
+            TFT_SMALL_CHAR_HEIGHT, x, y, width, height, 0);
+}
+
+/*
+ * Keep the shadow grids in sync with the tftMemory content a queued action will produce
+ */
+void TftDisplay::shadowUpdate(const TFTAction &action) {
+    switch (action.actionType) {
+    case TFT_DISPLAY_ONE_CHAR:
+    case TFT_DISPLAY_ONE_SMALL_CHAR:
+        shadowSetChar(action.param1, action.param2, action.actionType == TFT_DISPLAY_ONE_SMALL_CHAR, action.param3, action.param4, action.param5);
+        break;
+    case TFT_DISPLAY_GLYPH_RUN: {
+        bool smallChars = action.param5 == 1;
+        uint8_t glyphWidth = smallChars ? TFT_SMALL_CHAR_WIDTH : TFT_BIG_CHAR_WIDTH;
+        uint16_t poolIndex = action.param4;
+        uint8_t color = glyphRunPool[poolIndex++ & TFT_GLYPH_RUN_POOL_MASK];
+        uint8_t bgColor = glyphRunPool[poolIndex++ & TFT_GLYPH_RUN_POOL_MASK];
+        for (int g = 0; g < action.param3; g++) {
+            shadowSetChar(action.param1 + g * glyphWidth, action.param2, smallChars,
+                    glyphRunPool[(poolIndex + g) & TFT_GLYPH_RUN_POOL_MASK], color, bgColor);
+        }
+        break;
+    }
+    case TFT_DRAW_FILL_TFT:
+        shadowFill(0, 0, 240, 320, action.param5);
+        break;
+    case TFT_DRAW_FILL_AREA:
+        shadowFill(action.param1, action.param2, action.param3, action.param4, action.param5);
+        break;
+    case TFT_DRAW_OSCILLO:
+        shadowInvalidate(TFT_OSCILLO_X, TFT_OSCILLO_Y, 160, 100);
+        break;
+    case TFT_DRAW_ALGO:
+    case TFT_HIGHLIGHT_ALGO_OPERATOR:
+    case TFT_ERASE_HIGHLIGHT_ALGO_OPERATOR:
+    case TFT_HIGHTLIGHT_ALGO_IM:
+    case TFT_ERASE_HIGHTLIGHT_ALGO_IM:
+    case TFT_CLEAR_ALGO_FG:
+        shadowInvalidate(TFT_ALGO_X, TFT_ALGO_Y, 80, 100);
+        break;
+    }
+}
+
+/*
+ * Called from the main loop.
+ * Reads the capture tap behind the audio interrupt write index, syncs on a rising edge and decimates
+ * to OSCILLO_WIDTH pixels.
+ */
 void TftDisplay::oscilloRrefresh() {
-    float oscilloSampleReadPtr = oscilloSamplePeriod - oscilloPhaseIndexToUse;
+    float samplesPerPixel;
+    uint32_t searchLength;
+    if (oscilloTimebase == OSCILLO_TIMEBASE_AUTO) {
+        // One period of the lowest note
+        samplesPerPixel = oscilloSampleInc;
+        searchLength = (uint32_t) oscilloSamplePeriod;
+    } else {
+        samplesPerPixel = (float) (1 << (oscilloTimebase - 1));
+        searchLength = OSCILLO_BUFFER_SIZE;
+    }
+    uint32_t span = (uint32_t) (OSCILLO_WIDTH * samplesPerPixel) + 1;
+
+    // The interrupt keeps writing after this index, at most a few blocks during this refresh,
+    // far from the oldest sample read here (span + searchLength <= 1281 + 1024, 37 ms of slack)
+    uint32_t end = oscilloTapWriteIndex - span;
+    uint32_t start = end;
+    for (uint32_t s = 0; s < searchLength; s++) {
+        uint32_t index = end - s;
+        if (oscilloTap[(index - 1) & OSCILLO_TAP_MASK] <= 0.0f && oscilloTap[index & OSCILLO_TAP_MASK] > 0.0f) {
+            start = index;
+            break;
+        }
+    }
+
+    float oscilloSampleReadPtr = 0.0f;
     bool saturate = false;
     int32_t maxYValue = 0;
     float multiplier = olscilloYScale * 50.0f;
     uint32_t total = 0;
     for (int x = 0; x < 160; x++) {
         // Use _usat on value before multiplying ?????
-        int8_t oValue = (int8_t) (oscilloFullPeriodSampl[(int) oscilloSampleReadPtr] * multiplier);
+        int8_t oValue = (int8_t) (oscilloTap[(start + (uint32_t) oscilloSampleReadPtr) & OSCILLO_TAP_MASK] * multiplier);
         total += abs(oValue);
         if (unlikely(oValue > 50)) {
             saturate = true;
@@ -953,10 +1324,7 @@ void TftDisplay::oscilloRrefresh() {
             }
         }
 
-        oscilloSampleReadPtr += oscilloSampleInc;
-        if (oscilloSampleReadPtr > oscilloSamplePeriod) {
-            oscilloSampleReadPtr -= oscilloSamplePeriod;
-        }
+        oscilloSampleReadPtr += samplesPerPixel;
     }
 
     // flatOscillo must be displayed only once
@@ -992,7 +1360,7 @@ void TftDisplay::oscilloRrefresh() {
         //newAction.param1 = saturate ? 1 : 0;
         newAction.param1 = 0;
         newAction.param3 = 0;
-        tftActions.insert(newAction);
+        insertAction(newAction);
 
         // Dynamically adjust olscilloYScale
         if (saturate) {
@@ -1003,8 +1371,6 @@ void TftDisplay::oscilloRrefresh() {
             }
         }
     }
-    // We can start filling again the oscillo buffer
-	oscilloDataWritePtr = 0;
 }
 
 void TftDisplay::fillArea(uint8_t x, uint16_t y, uint8_t width, uint16_t height, uint8_t color) {
@@ -1015,7 +1381,7 @@ void TftDisplay::fillArea(uint8_t x, uint16_t y, uint8_t width, uint16_t height,
     newAction.param3 = width;
     newAction.param4 = height;
     newAction.param5 = color;
-    tftActions.insert(newAction);
+    insertAction(newAction);
 
 }
 
@@ -1025,20 +1391,20 @@ void TftDisplay::oscilloNewLowerFrequency(float lf) {
         oscilloSamplePeriod = OSCILLO_BUFFER_SIZE;
     }
     oscilloSampleInc = (float) oscilloSamplePeriod / OSCILLO_WIDTH;
-
-    // oscilloPhaseIndexToUse = oscilloSamplePeriod - (oscilloPhaseIndex % ((int)oscilloSamplePeriod + 1));
-    int divInt = oscilloPhaseIndex / oscilloSamplePeriod;
-
-    oscilloPhaseIndexToUse = oscilloPhaseIndex - divInt * oscilloSamplePeriod;
 }
 
-void TftDisplay::oscilloRecord32Samples(float *samples) {
-    oscilloPhaseIndex += 32.0f;
-    if (oscilloDataWritePtr < oscilloSamplePeriod) {
-        for (int r = 0; r < 32; r++) {
-            oscilloFullPeriodSampl[oscilloDataWritePtr++] = samples[r * 2];
-        }
+/*
+ * Called from the audio interrupt : copy the left channel and bump the write index.
+ * Single producer, the only reader is oscilloRrefresh in the main loop.
+ */
+void TftDisplay::oscilloRecordSamples(float *samples, int numberOfSamples) {
+    uint32_t writeIndex = oscilloTapWriteIndex;
+    for (int r = 0; r < numberOfSamples; r++) {
+        oscilloTap[(writeIndex + r) & OSCILLO_TAP_MASK] = samples[r * 2];
     }
+    // Samples must be in memory before the new index is visible
+    __DMB();
+    oscilloTapWriteIndex = writeIndex + numberOfSamples;
 }
 
 void TftDisplay::drawAlgo(int algo) {
@@ -1046,13 +1412,13 @@ void TftDisplay::drawAlgo(int algo) {
     newAction.actionType = TFT_DRAW_ALGO;
     newAction.param1 = algo;
     newAction.param3 = 0;
-    tftActions.insert(newAction);
+    insertAction(newAction);
 }
 
 void TftDisplay::clearAlgoFG() {
     TFTAction newAction;
     newAction.actionType = TFT_CLEAR_ALGO_FG;
-    tftActions.insert(newAction);
+    insertAction(newAction);
 }
 
 void TftDisplay::highlightOperator(int op) {
@@ -1060,7 +1426,7 @@ void TftDisplay::highlightOperator(int op) {
     newAction.actionType = TFT_HIGHLIGHT_ALGO_OPERATOR;
     newAction.param1 = op;
     newAction.param3 = 0;
-    tftActions.insert(newAction);
+    insertAction(newAction);
 }
 
 void TftDisplay::eraseHighlightOperator(int op) {
@@ -1068,7 +1434,7 @@ void TftDisplay::eraseHighlightOperator(int op) {
     newAction.actionType = TFT_ERASE_HIGHLIGHT_ALGO_OPERATOR;
     newAction.param1 = op;
     newAction.param3 = 0;
-    tftActions.insert(newAction);
+    insertAction(newAction);
 }
 
 void TftDisplay::highlightIM(uint8_t imNum, uint8_t opSource, uint8_t opDest) {
@@ -1078,7 +1444,7 @@ void TftDisplay::highlightIM(uint8_t imNum, uint8_t opSource, uint8_t opDest) {
     newAction.param3 = 0;
     newAction.param4 = opSource;
     newAction.param5 = opDest;
-    tftActions.insert(newAction);
+    insertAction(newAction);
 }
 
 void TftDisplay::eraseHighlightIM(uint8_t imNum, uint8_t opSource, uint8_t opDest) {
@@ -1088,19 +1454,19 @@ void TftDisplay::eraseHighlightIM(uint8_t imNum, uint8_t opSource, uint8_t opDes
     newAction.param3 = 0;
     newAction.param4 = opSource;
     newAction.param5 = opDest;
-    tftActions.insert(newAction);
+    insertAction(newAction);
 }
 
 void TftDisplay::restartRefreshTft() {
     TFTAction newAction;
     newAction.actionType = TFT_RESTART_REFRESH;
-    tftActions.insert(newAction);
+    insertAction(newAction);
 }
 
 void TftDisplay::pauseRefresh() {
     TFTAction newAction;
     newAction.actionType = TFT_PAUSE_REFRESH;
-    tftActions.insert(newAction);
+    insertAction(newAction);
 }
 
 
@@ -1108,7 +1474,7 @@ void TftDisplay::waitCycle(uint16_t waitCycle) {
     TFTAction newAction;
     newAction.actionType = TFT_WAITCYCLE;
     newAction.param2 = waitCycle;
-    tftActions.insert(newAction);
+    insertAction(newAction);
 }
 
 #define BUTTON_WIDTH 72
@@ -4,7 +4,7 @@
 extern DMA_HandleTypeDef hdma_spi1_tx;
 extern uint8_t dmaReady;
 
-uint16_t windowLastX = 9999;
+uint32_t windowLastX = 0xffffffff;
 
 uint8_t dummyDataOut[] = { 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255 };
 uint8_t dummyDataIn[16];
@@ -15,7 +15,7 @@ static void ILI9341_Reset() {
     HAL_Delay(5);
     ILI9341_Select();
     HAL_GPIO_WritePin(ILI9341_RES_GPIO_Port, ILI9341_RES_Pin, GPIO_PIN_SET);
-    windowLastX = 9999;
+    windowLastX = 0xffffffff;
 }
 
 static HAL_StatusTypeDef ILI9341_WriteCommand(uint8_t cmd) {
@@ -63,17 +63,18 @@ HAL_StatusTypeDef ILI9341_ReadPixelFormat(uint8_t buff[3]) {
 
 
 
-HAL_StatusTypeDef ILI9341_SetAddressWindow(uint16_t y0, uint16_t y1) {
-    static uint8_t dataX[] = { 0, 0, 0, 239 };
-    // column address set
-    if (windowLastX != 0) {
-        windowLastX = 0;
+HAL_StatusTypeDef ILI9341_SetAddressWindow(uint16_t x0, uint16_t x1, uint16_t y0, uint16_t y1) {
+    // column address set, only when it changes
+    uint32_t windowX = (x0 << 16) | x1;
+    if (windowLastX != windowX) {
+        uint8_t dataX[] = { (x0 >> 8) & 0xFF, x0 & 0xFF, (x1 >> 8) & 0xFF, x1 & 0xFF };
         if (ILI9341_WriteCommand(0x2A) != HAL_OK) {
             return HAL_ERROR;
         }
         if (ILI9341_WriteData(dataX, 4) != HAL_OK) {
             return HAL_ERROR;
         }
+        windowLastX = windowX;
     }
     // row address set
     // Optimization removed to fix a button refresh problem
@@ -0,0 +1,423 @@
+/*
+ * Copyright 2021 Xavier Hosxe
+ *
+ * Author: Xavier Hosxe (xavier . hosxe (at) gmail . com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Audition of every patch of the .bnk files and every mixer of the .mix files of a folder.
+ * Built by bankAudition.sh with the firmware engine sources (see scripts/host).
+ *
+ * The firmware engine is made of globals : the records are shared between worker processes,
+ * one per core, that take the next record to render from a shared counter.
+ * Each record plays the phrase of HostEngine and gives a WAV preview and one line of audition.csv :
+ * peak and RMS level, clipped samples, saturated engine blocks and the CPU time of the render.
+ */
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <dirent.h>
+#include <strings.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// FatFs DIR and dirent DIR share the same name
+typedef DIR HostDir;
+#define DIR FF_DIR
+#include "HostEngine.h"
+#include "PatchBank.h"
+#include "SynthState.h"
+
+#define AUDITION_MAX_SECONDS 30.0f
+#define AUDITION_MAX_FILES 512
+// 24 bits full scale minus one LSB
+#define AUDITION_CLIP_LEVEL (1.0f - 1.0f / 0x7fffff)
+
+#define AUDITION_MAX_FRAMES ((int) (PREENFM_FREQUENCY * AUDITION_MAX_SECONDS))
+
+enum AuditionFileType {
+    AUDITION_BANK = 0,
+    AUDITION_MIXER
+};
+
+struct AuditionFile {
+    char name[256];
+    AuditionFileType fileType;
+    int numberOfRecords;
+};
+
+struct AuditionJob {
+    int file;
+    int record;
+};
+
+struct AuditionResult {
+    bool rendered;
+    char name[13];
+    float peak;
+    float rms;
+    uint32_t clippedSamples;
+    uint32_t saturatedBlocks;
+    double cpuSeconds;
+};
+
+struct AuditionSettings {
+    int jobs;
+    float seconds;
+    int numberOfVoices;
+    float send;
+    bool writeWav;
+    const char *folder;
+    const char *outputFolder;
+};
+
+// In shared memory, written by the workers
+struct AuditionShared {
+    int nextJob;
+    struct AuditionResult results[];
+};
+
+static HostEngine engine;
+static struct AuditionFile files[AUDITION_MAX_FILES];
+static int numberOfFiles;
+static struct AuditionJob *jobs;
+static int numberOfJobs;
+static struct AuditionShared *shared;
+
+static float renderBuffer[AUDITION_MAX_FRAMES * 2 + BLOCK_SIZE * 2];
+static char record[FULL_MIXER_SIZE];
+
+static double cpuTime() {
+    struct timespec now;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+    return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+static bool hasExtension(const char *name, const char *extension) {
+    int length = strlen(name);
+    return length > 4 && strcasecmp(name + length - 4, extension) == 0;
+}
+
+static bool compareFiles(const struct AuditionFile &file1, const struct AuditionFile &file2) {
+    return strcmp(file1.name, file2.name) < 0;
+}
+
+static void listFiles(const char *folder) {
+    HostDir *dir = opendir(folder);
+    if (dir == 0) {
+        return;
+    }
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != 0 && numberOfFiles < AUDITION_MAX_FILES) {
+        struct AuditionFile &file = files[numberOfFiles];
+        struct stat fileStat;
+        snprintf(file.name, sizeof(file.name), "%s/%s", folder, entry->d_name);
+        // default.mix is smaller, like in MixerBank::isCorrectFile
+        if (stat(file.name, &fileStat) != 0 || fileStat.st_size < 100000) {
+            continue;
+        }
+        if (hasExtension(entry->d_name, ".bnk")) {
+            file.fileType = AUDITION_BANK;
+            file.numberOfRecords = std::min((int) (fileStat.st_size / ALIGNED_PATCH_SIZE), NUMBER_OF_PATCHES_PER_BANK);
+            numberOfFiles++;
+        } else if (hasExtension(entry->d_name, ".mix")) {
+            file.fileType = AUDITION_MIXER;
+            file.numberOfRecords = std::min((int) (fileStat.st_size / FULL_MIXER_SIZE), NUMBER_OF_MIXERS_PER_BANK);
+            numberOfFiles++;
+        }
+    }
+    closedir(dir);
+    std::sort(files, files + numberOfFiles, compareFiles);
+}
+
+static const char* baseName(const char *fileName) {
+    const char *slash = strrchr(fileName, '/');
+    return slash == 0 ? fileName : slash + 1;
+}
+
+static bool readRecord(const struct AuditionFile *file, int recordNumber, int recordSize) {
+    FILE *input = fopen(file->name, "rb");
+    if (input == 0) {
+        return false;
+    }
+    bool read = fseek(input, (long) recordNumber * recordSize, SEEK_SET) == 0 && fread(record, 1, recordSize, input) == (size_t) recordSize;
+    fclose(input);
+    // Empty slot
+    for (int b = 0; read && b < recordSize; b++) {
+        if (record[b] != 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool writeWav(const char *fileName, const float *stereo, int frames) {
+    FILE *wav = fopen(fileName, "wb");
+    if (wav == 0) {
+        return false;
+    }
+    uint32_t sampleRate = (uint32_t) PREENFM_FREQUENCY;
+    uint32_t dataSize = frames * 2 * sizeof(int16_t);
+    uint32_t riffSize = 36 + dataSize;
+    uint32_t formatSize = 16;
+    uint16_t format = 1, channels = 2, bits = 16, blockAlign = 4;
+    uint32_t byteRate = sampleRate * blockAlign;
+
+    fwrite("RIFF", 1, 4, wav);
+    fwrite(&riffSize, 4, 1, wav);
+    fwrite("WAVEfmt ", 1, 8, wav);
+    fwrite(&formatSize, 4, 1, wav);
+    fwrite(&format, 2, 1, wav);
+    fwrite(&channels, 2, 1, wav);
+    fwrite(&sampleRate, 4, 1, wav);
+    fwrite(&byteRate, 4, 1, wav);
+    fwrite(&blockAlign, 2, 1, wav);
+    fwrite(&bits, 2, 1, wav);
+    fwrite("data", 1, 4, wav);
+    fwrite(&dataSize, 4, 1, wav);
+    for (int s = 0; s < frames * 2; s++) {
+        int16_t sample = (int16_t) lrintf(fmaxf(-1.0f, fminf(1.0f, stereo[s])) * 32767.0f);
+        fwrite(&sample, 2, 1, wav);
+    }
+    return fclose(wav) == 0;
+}
+
+static void renderJob(const struct AuditionSettings *settings, int jobNumber) {
+    const struct AuditionJob &job = jobs[jobNumber];
+    const struct AuditionFile &file = files[job.file];
+    struct AuditionResult &result = shared->results[jobNumber];
+
+    engine.reset(settings->numberOfVoices, settings->send);
+    if (file.fileType == AUDITION_BANK) {
+        if (!readRecord(&file, job.record, ALIGNED_PATCH_SIZE)) {
+            return;
+        }
+        engine.loadPresetRecord(0, (uint8_t*) record);
+        snprintf(result.name, sizeof(result.name), "%s", engine.getPresetName(0));
+    } else {
+        if (!readRecord(&file, job.record, FULL_MIXER_SIZE)) {
+            return;
+        }
+        engine.loadMixerRecord(record, FULL_MIXER_SIZE);
+        snprintf(result.name, sizeof(result.name), "%s", engine.getMixerState()->mixName_);
+    }
+
+    // The phrase is sent on every channel an instrument listens to
+    uint16_t channels = 0;
+    for (int t = 0; t < NUMBER_OF_TIMBRES; t++) {
+        const struct MixerInstrumentState &instrument = engine.getMixerState()->instrumentState_[t];
+        if (instrument.numberOfVoices > 0) {
+            channels |= 1 << (instrument.midiChannel == 0 ? 0 : instrument.midiChannel - 1);
+        }
+    }
+
+    const int numberOfBlocks = (int) (settings->seconds * PREENFM_FREQUENCY) / BLOCK_SIZE;
+    unsigned int nextEvent = 0;
+    double start = cpuTime();
+    for (int b = 0; b < numberOfBlocks; b++) {
+        float time = b * BLOCK_SIZE / PREENFM_FREQUENCY;
+        const struct HostNoteEvent *event;
+        while ((event = hostPhraseEvent(time, &nextEvent)) != 0) {
+            for (int c = 0; c < 16; c++) {
+                if (channels & (1 << c)) {
+                    engine.midiMessage(MIDI_NOTE_ON + c, event->note, event->velocity);
+                }
+            }
+        }
+        if (engine.nextBlock(&renderBuffer[b * BLOCK_SIZE * 2]) != 0) {
+            result.saturatedBlocks++;
+        }
+    }
+    result.cpuSeconds = cpuTime() - start;
+
+    const int frames = numberOfBlocks * BLOCK_SIZE;
+    double sum = 0.0;
+    for (int s = 0; s < frames * 2; s++) {
+        float level = fabsf(renderBuffer[s]);
+        result.peak = fmaxf(result.peak, level);
+        result.clippedSamples += (level >= AUDITION_CLIP_LEVEL);
+        sum += (double) renderBuffer[s] * renderBuffer[s];
+    }
+    result.rms = sqrt(sum / (frames * 2));
+    result.rendered = true;
+
+    if (settings->writeWav) {
+        char wavName[512];
+        char name[13];
+        // File system friendly preset name
+        for (int c = 0; c < 13; c++) {
+            char n = result.name[c];
+            name[c] = (n == 0 || isalnum(n) || n == '-') ? n : '_';
+        }
+        snprintf(wavName, sizeof(wavName), "%s/%s_%03d_%s.wav", settings->outputFolder, baseName(file.name), job.record + 1, name);
+        if (!writeWav(wavName, renderBuffer, frames)) {
+            fprintf(stderr, "Cannot write %s\n", wavName);
+        }
+    }
+}
+
+static void worker(const struct AuditionSettings *settings) {
+    int jobNumber;
+    while ((jobNumber = __atomic_fetch_add(&shared->nextJob, 1, __ATOMIC_RELAXED)) < numberOfJobs) {
+        renderJob(settings, jobNumber);
+    }
+}
+
+static bool writeCsv(const struct AuditionSettings *settings) {
+    char csvName[512];
+    snprintf(csvName, sizeof(csvName), "%s/audition.csv", settings->outputFolder);
+    FILE *csv = fopen(csvName, "w");
+    if (csv == 0) {
+        fprintf(stderr, "Cannot write %s\n", csvName);
+        return false;
+    }
+    fprintf(csv, "file,number,name,peak_dbfs,rms_dbfs,clipped_samples,saturated_blocks,cpu_ms,cpu_percent\n");
+    for (int j = 0; j < numberOfJobs; j++) {
+        const struct AuditionResult &result = shared->results[j];
+        if (result.rendered) {
+            fprintf(csv, "%s,%d,\"%s\",%.2f,%.2f,%u,%u,%.2f,%.2f\n", baseName(files[jobs[j].file].name), jobs[j].record + 1, result.name,
+                hostToDb(result.peak), hostToDb(result.rms), result.clippedSamples, result.saturatedBlocks,
+                result.cpuSeconds * 1000.0, result.cpuSeconds * 100.0 / settings->seconds);
+        }
+    }
+    return fclose(csv) == 0;
+}
+
+static void printSummary(const struct AuditionSettings *settings, double seconds) {
+    int rendered = 0;
+    int clipping = 0;
+    int heaviest = -1;
+    for (int j = 0; j < numberOfJobs; j++) {
+        const struct AuditionResult &result = shared->results[j];
+        if (result.rendered) {
+            rendered++;
+            clipping += (result.clippedSamples > 0 || result.saturatedBlocks > 0);
+            if (heaviest == -1 || result.cpuSeconds > shared->results[heaviest].cpuSeconds) {
+                heaviest = j;
+            }
+        }
+    }
+    printf("%d record(s) of %d file(s) rendered in %.2f s by %d worker(s), %d clipping\n",
+        rendered, numberOfFiles, seconds, settings->jobs, clipping);
+    if (heaviest >= 0) {
+        const struct AuditionResult &result = shared->results[heaviest];
+        printf("heaviest : %s %d \"%s\", %.1f %% of one core\n", baseName(files[jobs[heaviest].file].name), jobs[heaviest].record + 1,
+            result.name, result.cpuSeconds * 100.0 / settings->seconds);
+    }
+}
+
+static void usage() {
+    printf("bankAudition [--jobs n] [--seconds s] [--voices n] [--send s] [--no-wav] [--sdcard folder] folder output_folder\n");
+    printf("  folder    : .bnk and .mix files to audition\n");
+    printf("  --jobs    : worker processes (default : number of cores)\n");
+    printf("  --seconds : length of each render (default 3.0)\n");
+    printf("  --voices  : voices of the patches (default 8)\n");
+    printf("  --send    : reverb send of the patches (default 0.3)\n");
+    printf("  --no-wav  : only write audition.csv\n");
+    printf("  --sdcard  : folder that contains pfm3/, for scala scales and user waveforms\n");
+}
+
+int main(int argc, char *argv[]) {
+    struct AuditionSettings settings = { (int) sysconf(_SC_NPROCESSORS_ONLN), 3.0f, 8, .3f, true, 0, 0 };
+    const char *sdCardFolder = 0;
+    int a = 1;
+    for (; a < argc && argv[a][0] == '-'; a++) {
+        if (strcmp(argv[a], "--jobs") == 0 && a + 1 < argc) {
+            settings.jobs = atoi(argv[++a]);
+        } else if (strcmp(argv[a], "--seconds") == 0 && a + 1 < argc) {
+            settings.seconds = atof(argv[++a]);
+        } else if (strcmp(argv[a], "--voices") == 0 && a + 1 < argc) {
+            settings.numberOfVoices = atoi(argv[++a]);
+        } else if (strcmp(argv[a], "--send") == 0 && a + 1 < argc) {
+            settings.send = atof(argv[++a]);
+        } else if (strcmp(argv[a], "--no-wav") == 0) {
+            settings.writeWav = false;
+        } else if (strcmp(argv[a], "--sdcard") == 0 && a + 1 < argc) {
+            sdCardFolder = argv[++a];
+        } else {
+            usage();
+            return 2;
+        }
+    }
+    if (a + 2 != argc || settings.jobs < 1 || settings.seconds <= 0.0f || settings.seconds > AUDITION_MAX_SECONDS
+            || settings.numberOfVoices < 1 || settings.numberOfVoices > MAX_NUMBER_OF_VOICES) {
+        usage();
+        return 2;
+    }
+    settings.folder = argv[a];
+    settings.outputFolder = argv[a + 1];
+    mkdir(settings.outputFolder, 0755);
+
+    listFiles(settings.folder);
+    for (int f = 0; f < numberOfFiles; f++) {
+        numberOfJobs += files[f].numberOfRecords;
+    }
+    if (numberOfJobs == 0) {
+        printf("No .bnk or .mix file in %s\n", settings.folder);
+        return 1;
+    }
+    jobs = new struct AuditionJob[numberOfJobs];
+    for (int f = 0, j = 0; f < numberOfFiles; f++) {
+        for (int r = 0; r < files[f].numberOfRecords; r++, j++) {
+            jobs[j].file = f;
+            jobs[j].record = r;
+        }
+    }
+    size_t sharedSize = sizeof(struct AuditionShared) + numberOfJobs * sizeof(struct AuditionResult);
+    shared = (struct AuditionShared*) mmap(0, sharedSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (shared == MAP_FAILED) {
+        perror("mmap");
+        return 1;
+    }
+
+    engine.init(sdCardFolder);
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    settings.jobs = std::min(settings.jobs, numberOfJobs);
+    for (int w = 0; w < settings.jobs; w++) {
+        pid_t pid = fork();
+        if (pid == 0) {
+            worker(&settings);
+            _exit(0);
+        }
+        if (pid < 0) {
+            perror("fork");
+            break;
+        }
+    }
+    int status;
+    int failedWorkers = 0;
+    while (wait(&status) > 0) {
+        failedWorkers += !(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    bool csvWritten = writeCsv(&settings);
+    printSummary(&settings, (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) * 1e-9);
+    if (failedWorkers > 0) {
+        // The record a crashed worker was rendering is missing from audition.csv
+        printf("%d worker(s) failed\n", failedWorkers);
+    }
+    return csvWritten && failedWorkers == 0 ? 0 : 1;
+}
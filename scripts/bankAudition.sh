@@ -0,0 +1,17 @@
+#!/bin/bash
+
+# Audition of all the patches and mixers of a folder, on all cores (see bankAudition.cpp).
+# usage : bankAudition.sh [--jobs n] [--seconds s] [--voices n] [--send s] [--no-wav] [--sdcard folder] folder output_folder
+#
+# output_folder gets one WAV preview per patch or mixer and audition.csv :
+# peak and RMS levels, clipped samples and render CPU time of each of them.
+
+SCRIPT_DIR=$(cd $(dirname "$0") && pwd)
+BUILD_DIR=$(mktemp -d)
+
+${SCRIPT_DIR}/host/build.sh ${BUILD_DIR}/bankAudition ${SCRIPT_DIR}/bankAudition.cpp || { rm -rf ${BUILD_DIR}; exit 1; }
+${BUILD_DIR}/bankAudition "$@"
+RESULT=$?
+
+rm -rf ${BUILD_DIR}
+exit ${RESULT}
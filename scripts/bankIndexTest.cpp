@@ -0,0 +1,277 @@
+/*
+ * Copyright 2021 Xavier Hosxe
+ *
+ * Author: Xavier Hosxe (xavier . hosxe (at) gmail . com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Host test of the v3 bank index against banks written by older firmwares.
+ * Built by bankIndexTest.sh with the firmware engine sources (see scripts/host).
+ *
+ * A patch bank is created with its index in a temporary sd card folder, a mixer bank is created
+ * without (createMixerBank draws its progress) and gets it with its first save.
+ * A record is then copied over another one behind the index, as an older firmware saves it :
+ * the record is valid but the CRC and the name of its index entry are stale.
+ * The record must load and its index entry must be updated, but only by a load the user asks for :
+ * the prefetch and the set list don't write.
+ * Records that are not well formed (garbage, a NaN parameter) are refused and the bank is not touched.
+ * The patch cache must not give the records of a renamed bank to the new bank that takes its name.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "HostCheck.h"
+#include "HostEngine.h"
+#include "MixerBank.h"
+#include "PatchBank.h"
+#include "Storage.h"
+#include "SynthState.h"
+
+// The file names are copied on 12 characters, as the menu gives them
+static char patchBankName[13] = "Stale.bnk";
+static char mixerBankName[13] = "Stale.mix";
+static char otherBankName[13] = "Other.bnk";
+static char renamedBankName[13] = "Renamed.bnk";
+
+static HostEngine engine;
+static char sdCardRoot[] = "/tmp/bankIndexTestXXXXXX";
+
+static const char* getFileName(const char *bankName) {
+    static char fileName[512];
+    snprintf(fileName, sizeof(fileName), "%s/pfm3/%s", sdCardRoot, bankName);
+    return fileName;
+}
+
+// What an older firmware does : the record is written, the index is not touched
+static bool copyRecord(const char *bankName, int recordSize, int from, int to) {
+    FILE *file = fopen(getFileName(bankName), "r+b");
+    if (file == 0) {
+        return false;
+    }
+    char *record = (char*) malloc(recordSize);
+    bool copied = fseek(file, from * recordSize, SEEK_SET) == 0 && fread(record, 1, recordSize, file) == (size_t) recordSize
+        && fseek(file, to * recordSize, SEEK_SET) == 0 && fwrite(record, 1, recordSize, file) == (size_t) recordSize;
+    free(record);
+    fclose(file);
+    return copied;
+}
+
+// Garbage that reads back the same each time
+static bool corruptRecord(const char *bankName, int recordSize, int record) {
+    FILE *file = fopen(getFileName(bankName), "r+b");
+    if (file == 0) {
+        return false;
+    }
+    uint32_t seed = 0x12345678;
+    bool corrupted = fseek(file, record * recordSize, SEEK_SET) == 0;
+    for (int b = 0; b < recordSize && corrupted; b++) {
+        seed = seed * 1664525 + 1013904223;
+        corrupted = fputc(seed >> 24, file) != EOF;
+    }
+    fclose(file);
+    return corrupted;
+}
+
+// A record that is well formed but for one parameter
+static bool setNaN(const char *bankName, int offset) {
+    FILE *file = fopen(getFileName(bankName), "r+b");
+    if (file == 0) {
+        return false;
+    }
+    uint32_t nan = 0x7fc00000;
+    bool written = fseek(file, offset, SEEK_SET) == 0 && fwrite(&nan, 4, 1, file) == 1;
+    fclose(file);
+    return written;
+}
+
+// Whole bank file, to check nothing was written
+static long readBank(const char *bankName, char *buffer, long size) {
+    FILE *file = fopen(getFileName(bankName), "rb");
+    if (file == 0) {
+        return -1;
+    }
+    long byteRead = fread(buffer, 1, size, file);
+    fclose(file);
+    return byteRead;
+}
+
+static bool isBankUnchanged(const char *bankName, const char *before, long size) {
+    static char after[FULL_MIXER_SIZE * NUMBER_OF_MIXERS_PER_BANK + BANK_INDEX_SIZE(NUMBER_OF_PATCHES_PER_BANK)];
+    return readBank(bankName, after, sizeof(after)) == size && memcmp(before, after, size) == 0;
+}
+
+static void testPatchBank() {
+    const char *test = "stale patch entry";
+    PatchBank *patchBank = engine.getPatchBank();
+    patchBank->createPatchBank(patchBankName);
+    const struct PFM3File *bank = patchBank->getFile(patchBank->getFileIndex(patchBankName));
+
+    struct OneSynthParams params = preenMainPreset;
+    strcpy(params.presetName, "Saved by v3");
+    patchBank->savePatch(bank, 3, &params);
+    hostCheck(strcmp(patchBank->loadPatchName(bank, 5), preenMainPreset.presetName) == 0, test, "name before the copy");
+
+    hostCheck(copyRecord(patchBankName, ALIGNED_PATCH_SIZE, 3, 5), test, "cannot copy the record");
+
+    struct OneSynthParams loaded = defaultPreset;
+    patchBank->loadPatch(bank, 5, &loaded);
+    hostCheck(strcmp(loaded.presetName, "Saved by v3") == 0, test, "stale record not loaded");
+    hostCheck(strcmp(patchBank->loadPatchName(bank, 5), "Saved by v3") == 0, test, "index name not updated");
+
+    // The entry is fixed in the file, not only in memory : a fresh bank list reads it again
+    patchBank->addEmptyFile(otherBankName);
+    bank = patchBank->getFile(patchBank->getFileIndex(patchBankName));
+    hostCheck(strcmp(patchBank->loadPatchName(bank, 5), "Saved by v3") == 0, test, "index entry not saved");
+
+    // The records the index matches are still read as before
+    loaded = defaultPreset;
+    patchBank->loadPatch(bank, 7, &loaded);
+    hostCheck(strcmp(loaded.presetName, preenMainPreset.presetName) == 0, test, "other record");
+    printf("%-28s done\n", test);
+
+    static char before[NUMBER_OF_PATCHES_PER_BANK * ALIGNED_PATCH_SIZE + BANK_INDEX_SIZE(NUMBER_OF_PATCHES_PER_BANK)];
+    test = "patch prefetch";
+    hostCheck(copyRecord(patchBankName, ALIGNED_PATCH_SIZE, 3, 9), test, "cannot copy the record");
+    long bankSize = readBank(patchBankName, before, sizeof(before));
+    uint32_t prefetches = patchBank->getCachePrefetches();
+    // 9 is the first neighbour of 8
+    patchBank->prefetchNeighbours(bank, 8);
+    hostCheck(patchBank->getCachePrefetches() == prefetches, test, "stale record prefetched");
+    hostCheck(isBankUnchanged(patchBankName, before, bankSize), test, "bank written");
+    hostCheck(strcmp(patchBank->loadPatchName(bank, 9), preenMainPreset.presetName) == 0, test, "index name changed");
+    loaded = defaultPreset;
+    patchBank->loadPatch(bank, 9, &loaded);
+    hostCheck(strcmp(loaded.presetName, "Saved by v3") == 0, test, "stale record not loaded after the prefetch");
+    hostCheck(strcmp(patchBank->loadPatchName(bank, 9), "Saved by v3") == 0, test, "index name not updated by the load");
+    printf("%-28s done\n", test);
+
+    test = "corrupted patch";
+    hostCheck(corruptRecord(patchBankName, ALIGNED_PATCH_SIZE, 10), test, "cannot corrupt the record");
+    hostCheck(copyRecord(patchBankName, ALIGNED_PATCH_SIZE, 3, 11), test, "cannot copy the record");
+    hostCheck(setNaN(patchBankName, 11 * ALIGNED_PATCH_SIZE + 4), test, "cannot write the NaN");
+    bankSize = readBank(patchBankName, before, sizeof(before));
+    patchBank->prefetchNeighbours(bank, 9);
+    for (int r = 10; r <= 11; r++) {
+        loaded = defaultPreset;
+        patchBank->loadPatch(bank, r, &loaded);
+        hostCheck(strcmp(loaded.presetName, "##") == 0, test, r == 10 ? "garbage loaded" : "NaN loaded");
+        hostCheck(strcmp(patchBank->loadPatchName(bank, r), preenMainPreset.presetName) == 0, test, "index name changed");
+    }
+    hostCheck(isBankUnchanged(patchBankName, before, bankSize), test, "bank written");
+    printf("%-28s done\n", test);
+}
+
+// The patch cache is keyed by bank name
+static void testPatchCacheRename() {
+    const char *test = "patch cache rename";
+    PatchBank *patchBank = engine.getPatchBank();
+    const struct PFM3File *bank = patchBank->getFile(patchBank->getFileIndex(patchBankName));
+    struct OneSynthParams loaded = defaultPreset;
+    patchBank->loadPatch(bank, 3, &loaded);
+    hostCheck(strcmp(loaded.presetName, "Saved by v3") == 0, test, "record before the rename");
+
+    hostCheck(patchBank->renameFile(bank, renamedBankName) == 0, test, "cannot rename the bank");
+    patchBank->createPatchBank(patchBankName);
+    bank = patchBank->getFile(patchBank->getFileIndex(patchBankName));
+    loaded = defaultPreset;
+    patchBank->loadPatch(bank, 3, &loaded);
+    hostCheck(strcmp(loaded.presetName, preenMainPreset.presetName) == 0, test, "new bank gets the cached record");
+
+    bank = patchBank->getFile(patchBank->getFileIndex(renamedBankName));
+    loaded = defaultPreset;
+    patchBank->loadPatch(bank, 3, &loaded);
+    hostCheck(strcmp(loaded.presetName, "Saved by v3") == 0, test, "record of the renamed bank");
+    printf("%-28s done\n", test);
+}
+
+static void testMixerBank() {
+    const char *test = "stale mixer entry";
+    MixerBank *mixerBank = engine.getStorage()->getMixerBank();
+    MixerState *mixerState = engine.getMixerState();
+    // v1 bank of empty records
+    FILE *file = fopen(getFileName(mixerBankName), "wb");
+    static char emptyRecord[FULL_MIXER_SIZE];
+    for (int m = 0; m < NUMBER_OF_MIXERS_PER_BANK && file != 0; m++) {
+        fwrite(emptyRecord, 1, FULL_MIXER_SIZE, file);
+    }
+    hostCheck(file != 0 && fclose(file) == 0, test, "cannot create the bank");
+    const struct PFM3File *mixer = mixerBank->getFile(mixerBank->getFileIndex(mixerBankName));
+
+    char mixerName[13] = "Saved by v3 ";
+    mixerBank->saveMixer(mixer, 1, mixerName);
+    hostCheck(mixer->version == BANK_LAYOUT_V3, test, "bank not upgraded to v3");
+    hostCheck(copyRecord(mixerBankName, FULL_MIXER_SIZE, 1, 2), test, "cannot copy the record");
+
+    mixerState->mixName_[0] = 0;
+    hostCheck(mixerBank->loadMixer(mixer, 2), test, "stale record not loaded");
+    hostCheck(strncmp(mixerState->mixName_, "Saved by v3", 11) == 0, test, "mixer name");
+    hostCheck(strncmp(mixerBank->loadMixerName(mixer, 2), "Saved by v3", 11) == 0, test, "index name not updated");
+
+    printf("%-28s done\n", test);
+
+    // The set list path reads the record and doesn't write
+    static char before[FULL_MIXER_SIZE * NUMBER_OF_MIXERS_PER_BANK + BANK_INDEX_SIZE(NUMBER_OF_MIXERS_PER_BANK)];
+    test = "set list stale mixer";
+    hostCheck(copyRecord(mixerBankName, FULL_MIXER_SIZE, 1, 4), test, "cannot copy the record");
+    long bankSize = readBank(mixerBankName, before, sizeof(before));
+    static char record[FULL_MIXER_SIZE];
+    hostCheck(mixerBank->readMixerRecord(mixer, 4, record), test, "stale set list record not read");
+    hostCheck(strncmp(MixerState::getMixNameFromFile(record), "Saved by v3", 11) == 0, test, "set list record");
+    hostCheck(isBankUnchanged(mixerBankName, before, bankSize), test, "bank written");
+    printf("%-28s done\n", test);
+
+    test = "corrupted mixer";
+    hostCheck(corruptRecord(mixerBankName, FULL_MIXER_SIZE, 5), test, "cannot corrupt the record");
+    hostCheck(copyRecord(mixerBankName, FULL_MIXER_SIZE, 1, 6), test, "cannot copy the record");
+    // A float of the third timbre
+    hostCheck(setNaN(mixerBankName, 6 * FULL_MIXER_SIZE + ALIGNED_MIXER_SIZE + 2 * ALIGNED_PATCH_SIZE + 8), test, "cannot write the NaN");
+    bankSize = readBank(mixerBankName, before, sizeof(before));
+    for (int m = 5; m <= 6; m++) {
+        mixerState->mixName_[0] = 0;
+        hostCheck(!mixerBank->loadMixer(mixer, m), test, m == 5 ? "garbage loaded" : "NaN loaded");
+        hostCheck(strcmp(mixerState->mixName_, "##") == 0, test, "mixer name");
+        hostCheck(!mixerBank->readMixerRecord(mixer, m, record), test, "set list record read");
+    }
+    hostCheck(isBankUnchanged(mixerBankName, before, bankSize), test, "bank written");
+    printf("%-28s done\n", test);
+}
+
+int main() {
+    char folder[512];
+    if (mkdtemp(sdCardRoot) == 0) {
+        printf("Cannot create the sd card folder\n");
+        return 1;
+    }
+    snprintf(folder, sizeof(folder), "%s/pfm3", sdCardRoot);
+    mkdir(folder, 0755);
+
+    engine.init(sdCardRoot);
+    testPatchBank();
+    testPatchCacheRename();
+    testMixerBank();
+
+    char command[600];
+    snprintf(command, sizeof(command), "rm -rf %s", sdCardRoot);
+    if (system(command) != 0) {
+        printf("Cannot remove %s\n", sdCardRoot);
+    }
+
+    return hostCheckResult();
+}
@@ -0,0 +1,13 @@
+#!/bin/bash
+
+# Host test of the v3 bank index against banks saved by older firmwares (see bankIndexTest.cpp).
+
+SCRIPT_DIR=$(cd $(dirname "$0") && pwd)
+BUILD_DIR=$(mktemp -d)
+
+${SCRIPT_DIR}/host/build.sh ${BUILD_DIR}/bankIndexTest ${SCRIPT_DIR}/bankIndexTest.cpp || { rm -rf ${BUILD_DIR}; exit 1; }
+${BUILD_DIR}/bankIndexTest
+RESULT=$?
+
+rm -rf ${BUILD_DIR}
+exit ${RESULT}
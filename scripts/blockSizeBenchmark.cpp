@@ -0,0 +1,92 @@
+/*
+ * Copyright 2021 Xavier Hosxe
+ *
+ * Author: Xavier Hosxe (xavier . hosxe (at) gmail . com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Host benchmark of the BLOCK_SIZE trade off.
+ * Built by blockSizeBenchmark.sh with the firmware engine sources (see scripts/host), once per BLOCK_SIZE.
+ *
+ * Each preset of Presets.cpp is rendered with no note, then with all its voices held :
+ * matrix, LFOs, envelopes, operators, filters, FX and the bus are all in the measure.
+ * The render without note is the fixed cost of a block, the difference is the cost of the voices.
+ * Only the ratio between block sizes is meaningful, not the absolute number of voices.
+ */
+
+#include <chrono>
+#include <cstdio>
+
+#include "HostEngine.h"
+
+#define BENCH_SECONDS 4.0f
+#define BENCH_NUMBER_OF_VOICES MAX_NUMBER_OF_VOICES
+#define BENCH_SEND .3f
+// Best of, the other processes of the host only make a render slower
+#define BENCH_REPEAT 3
+
+static HostEngine engine;
+static float block[BLOCK_SIZE * 2];
+
+// Seconds to render BENCH_SECONDS of the preset with numberOfNotes held
+static double render(const struct OneSynthParams *preset, int numberOfNotes) {
+    const int numberOfBlocks = (int) (PREENFM_FREQUENCY * BENCH_SECONDS) / BLOCK_SIZE;
+    double best = 0.0;
+
+    for (int r = 0; r < BENCH_REPEAT; r++) {
+        engine.reset(BENCH_NUMBER_OF_VOICES, BENCH_SEND);
+        engine.loadPreset(0, preset);
+        for (int n = 0; n < numberOfNotes; n++) {
+            engine.noteOn(0, 36 + n * 3, 100);
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        for (int b = 0; b < numberOfBlocks; b++) {
+            engine.nextBlock(block);
+        }
+        auto end = std::chrono::steady_clock::now();
+
+        double seconds = std::chrono::duration<double>(end - start).count();
+        if (r == 0 || seconds < best) {
+            best = seconds;
+        }
+    }
+    return best;
+}
+
+int main() {
+    engine.init(0);
+
+    const struct OneSynthParams *presets[] = { &defaultPreset, &preenMainPreset, &newPresetParams };
+    double fixedTime = 0.0;
+    double voiceTime = 0.0;
+
+    for (unsigned int p = 0; p < ARRAY_SIZE(presets); p++) {
+        double idle = render(presets[p], 0);
+        double full = render(presets[p], BENCH_NUMBER_OF_VOICES);
+        fixedTime += idle;
+        voiceTime += (full - idle) / BENCH_NUMBER_OF_VOICES;
+    }
+
+    // CPU share of one second of sound
+    double fixedShare = fixedTime / (ARRAY_SIZE(presets) * BENCH_SECONDS);
+    double voiceShare = voiceTime / (ARRAY_SIZE(presets) * BENCH_SECONDS);
+
+    printf("BLOCK_SIZE %2d : latency %5.2f ms, fixed %6.3f%%, %7.3f ms per voice second, %8.1f voices per CPU\n",
+        BLOCK_SIZE, 2000.0f * BLOCK_SIZE / PREENFM_FREQUENCY, fixedShare * 100.0, voiceShare * 1000.0,
+        (1.0 - fixedShare) / voiceShare);
+    return 0;
+}
@@ -0,0 +1,26 @@
+#!/bin/bash
+
+# Compare the voices per CPU of the synth engine for each supported BLOCK_SIZE on the host
+# (see blockSizeBenchmark.cpp). The gain is given relative to the default BLOCK_SIZE (32).
+
+SCRIPT_DIR=$(cd $(dirname "$0") && pwd)
+BUILD_DIR=$(mktemp -d)
+BASE_CXXFLAGS=${CXXFLAGS:--Ofast}
+
+for blockSize in 16 32 64
+do
+    CXXFLAGS="${BASE_CXXFLAGS} -DBLOCK_SIZE=${blockSize}" ${SCRIPT_DIR}/host/build.sh ${BUILD_DIR}/bench${blockSize} \
+        ${SCRIPT_DIR}/blockSizeBenchmark.cpp || { rm -rf ${BUILD_DIR}; exit 1; }
+    ${BUILD_DIR}/bench${blockSize} | tee ${BUILD_DIR}/result${blockSize}
+done
+
+voices32=$(sed -E 's/.* ([0-9.]+) voices per CPU.*/\1/' ${BUILD_DIR}/result32)
+
+echo ""
+for blockSize in 16 32 64
+do
+    voices=$(sed -E 's/.* ([0-9.]+) voices per CPU.*/\1/' ${BUILD_DIR}/result${blockSize})
+    awk -v bs=${blockSize} -v v=${voices} -v ref=${voices32} 'BEGIN { printf("BLOCK_SIZE %2d : voices per CPU x%.2f\n", bs, v / ref) }'
+done
+
+rm -rf ${BUILD_DIR}
@@ -0,0 +1,150 @@
+/*
+ * Copyright 2021 Xavier Hosxe
+ *
+ * Author: Xavier Hosxe (xavier . hosxe (at) gmail . com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Host test of DelayArena, the FX2 delay memory of the timbres.
+ * Built by delayArenaTest.sh with firmware/Src/synth/DelayArena.cpp.
+ *
+ * The sizes are the ones of the FX2 types, in an arena of the firmware capacity.
+ * Every buffer is stamped with its timbre before each request : a buffer that moves keeps
+ * its content, the new one and the ones brought back to their minimum are cleared.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+
+#include "DelayArena.h"
+#include "HostCheck.h"
+
+#define TEST_BUFFER_SIZE 2048
+#define TEST_CAPACITY (NUMBER_OF_TIMBRES * TEST_BUFFER_SIZE)
+#define TEST_NUMBER_OF_REQUESTS 100000
+
+// Preferred and minimum sizes : off, modulation, bode, delay, grain
+static const int testSizes[][2] = {
+    { 0, 0 },
+    { TEST_BUFFER_SIZE, TEST_BUFFER_SIZE },
+    { 1024, 1024 },
+    { TEST_BUFFER_SIZE * 4, TEST_BUFFER_SIZE },
+    { TEST_BUFFER_SIZE * 2, TEST_BUFFER_SIZE }
+};
+
+static float memory[TEST_CAPACITY];
+static float *boundBuffer[NUMBER_OF_TIMBRES];
+static int boundSize[NUMBER_OF_TIMBRES];
+
+static float stamp(int timbre, int s) {
+    return timbre * 100000 + s + 1;
+}
+
+// Same layout as the arena : packed in timbre order from the beginning of the memory
+static void checkLayout(DelayArena *arena, const char *test) {
+    int offset = 0;
+    for (int t = 0; t < NUMBER_OF_TIMBRES; t++) {
+        int size = arena->getSize(t);
+        hostCheck(boundSize[t] == size && boundBuffer[t] == arena->getBuffer(t), test, "binding not updated");
+        hostCheck(size == 0 || arena->getBuffer(t) == memory + offset, test, "buffers not packed");
+        offset += size;
+    }
+    hostCheck(offset + arena->getFreeSize() == TEST_CAPACITY, test, "free size");
+}
+
+static void testSingleTimbre() {
+    const char *test = "preferred size when free";
+    DelayArena arena(memory, TEST_CAPACITY);
+    for (int t = 0; t < NUMBER_OF_TIMBRES; t++) {
+        arena.bind(t, &boundBuffer[t], &boundSize[t]);
+    }
+    hostCheck(arena.setSize(2, TEST_BUFFER_SIZE * 4, TEST_BUFFER_SIZE) == TEST_BUFFER_SIZE * 4, test, "delay size");
+    hostCheck(arena.setSize(0, TEST_BUFFER_SIZE * 2, TEST_BUFFER_SIZE) == TEST_BUFFER_SIZE * 2, test, "grain size");
+    checkLayout(&arena, test);
+    hostCheck(arena.getFreeSize() == 0, test, "arena not full");
+
+    // Half of what it prefers is free
+    test = "smaller size when full";
+    arena.setSize(0, 0, 0);
+    hostCheck(arena.setSize(1, TEST_BUFFER_SIZE, TEST_BUFFER_SIZE) == TEST_BUFFER_SIZE, test, "modulation size");
+    hostCheck(arena.setSize(0, TEST_BUFFER_SIZE * 4, TEST_BUFFER_SIZE) == TEST_BUFFER_SIZE, test, "delay size");
+    checkLayout(&arena, test);
+
+    // Timbre 2 gives back what it has above its minimum
+    test = "minimum taken from others";
+    for (int t = 3; t < NUMBER_OF_TIMBRES; t++) {
+        hostCheck(arena.setSize(t, TEST_BUFFER_SIZE, TEST_BUFFER_SIZE) == TEST_BUFFER_SIZE, test, "minimum not given");
+    }
+    hostCheck(arena.getSize(2) == TEST_BUFFER_SIZE, test, "delay not brought back to its minimum");
+    hostCheck(arena.getSize(0) == TEST_BUFFER_SIZE, test, "other delay resized");
+    checkLayout(&arena, test);
+
+    // Nothing left, even for the minimum : the arena stays consistent
+    test = "minimums above capacity";
+    hostCheck(arena.setSize(4, TEST_BUFFER_SIZE * 2, TEST_BUFFER_SIZE * 2) == 0, test, "size given");
+    checkLayout(&arena, test);
+    printf("%-28s done\n", "single requests");
+}
+
+static void testRandomRequests() {
+    const char *test = "random requests";
+    DelayArena arena(memory, TEST_CAPACITY);
+    int minimumSize[NUMBER_OF_TIMBRES] = { 0 };
+    for (int t = 0; t < NUMBER_OF_TIMBRES; t++) {
+        arena.bind(t, &boundBuffer[t], &boundSize[t]);
+    }
+
+    srand(3);
+    for (int r = 0; r < TEST_NUMBER_OF_REQUESTS && hostCheckFailures() == 0; r++) {
+        int timbre = rand() % NUMBER_OF_TIMBRES;
+        const int *sizes = testSizes[rand() % (sizeof(testSizes) / sizeof(testSizes[0]))];
+        int sizeBefore[NUMBER_OF_TIMBRES];
+        for (int t = 0; t < NUMBER_OF_TIMBRES; t++) {
+            sizeBefore[t] = arena.getSize(t);
+            for (int s = 0; s < sizeBefore[t]; s++) {
+                boundBuffer[t][s] = stamp(t, s);
+            }
+        }
+
+        int size = arena.setSize(timbre, sizes[0], sizes[1]);
+        minimumSize[timbre] = sizes[1];
+
+        hostCheck(size == arena.getSize(timbre), test, "returned size");
+        hostCheck(size >= sizes[1] && size <= sizes[0] && (size & (size - 1)) == 0, test, "size out of range");
+        // Less than preferred only when the arena is full
+        hostCheck(size == sizes[0] || arena.getFreeSize() < size, test, "smaller size with free memory");
+        checkLayout(&arena, test);
+        for (int t = 0; t < NUMBER_OF_TIMBRES; t++) {
+            int tSize = arena.getSize(t);
+            bool cleared = t == timbre || tSize != sizeBefore[t];
+            hostCheck(t == timbre || tSize == sizeBefore[t] || tSize == minimumSize[t], test, "other timbre not at its minimum");
+            for (int s = 0; s < tSize; s++) {
+                if (boundBuffer[t][s] != (cleared ? 0 : stamp(t, s))) {
+                    hostCheck(false, test, cleared ? "buffer not cleared" : "buffer content lost");
+                    break;
+                }
+            }
+        }
+    }
+    printf("%-28s done\n", test);
+}
+
+int main() {
+    testSingleTimbre();
+    testRandomRequests();
+
+    return hostCheckResult();
+}
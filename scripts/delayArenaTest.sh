@@ -0,0 +1,17 @@
+#!/bin/bash
+
+# Host test of the FX2 delay memory of the timbres (see delayArenaTest.cpp).
+
+CXX=${CXX:-g++}
+SCRIPT_DIR=$(cd $(dirname "$0") && pwd)
+SYNTH_DIR=${SCRIPT_DIR}/../firmware/Src/synth
+HOST_DIR=${SCRIPT_DIR}/host
+BUILD_DIR=$(mktemp -d)
+
+${CXX} -O2 -Wall -fsanitize=address,undefined -I${SYNTH_DIR} -I${HOST_DIR} -o ${BUILD_DIR}/delayArenaTest \
+    ${SCRIPT_DIR}/delayArenaTest.cpp ${SYNTH_DIR}/DelayArena.cpp ${HOST_DIR}/HostCheck.cpp || { rm -rf ${BUILD_DIR}; exit 1; }
+${BUILD_DIR}/delayArenaTest
+RESULT=$?
+
+rm -rf ${BUILD_DIR}
+exit ${RESULT}
@@ -0,0 +1,190 @@
+/*
+ * Copyright 2021 Xavier Hosxe
+ *
+ * Author: Xavier Hosxe (xavier . hosxe (at) gmail . com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Host test of the bootloader FirmwareUpdate : which sectors are erased and programmed.
+ * Built by firmwareUpdateTest.sh with bootloader/Src/FirmwareUpdate.cpp.
+ *
+ * The file and the flash are in memory. The flash behaves like the real one :
+ * erase sets a whole sector to 0xff, programming can only clear bits.
+ * Small sectors and blocks keep the images small, the last sector is always partial.
+ * Each byte of the file must be read once.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "FirmwareUpdate.h"
+#include "HostCheck.h"
+
+#define TEST_SECTOR_SIZE 1024
+#define TEST_BLOCK_SIZE 256
+#define TEST_NUMBER_OF_SECTORS 4
+#define TEST_IMAGE_SIZE (TEST_SECTOR_SIZE * (TEST_NUMBER_OF_SECTORS - 1) + 300)
+
+class MemoryFirmwareUpdate : public FirmwareUpdate {
+public:
+    MemoryFirmwareUpdate(const uint8_t *file, uint32_t size, uint8_t *flash) : FirmwareUpdate(size, TEST_SECTOR_SIZE, sectorBuffer_) {
+        file_ = file;
+        fileSize_ = size;
+        filePosition_ = 0;
+        flash_ = flash;
+        readFailsAt_ = 0xffffffff;
+        bytesRead_ = 0;
+        numberOfErases_ = 0;
+        programmedOverData_ = false;
+        memset(erased_, 0, sizeof(erased_));
+    }
+
+    void run(FirmwareUpdateResult *results) {
+        for (uint32_t sector = 0; sector < getNumberOfSectors(); sector++) {
+            results[sector] = updateSector(sector);
+        }
+    }
+
+    uint32_t readFailsAt_;
+    uint32_t bytesRead_;
+    int numberOfErases_;
+    bool erased_[TEST_NUMBER_OF_SECTORS];
+    bool programmedOverData_;
+
+protected:
+    bool readBlock(uint8_t *block, uint32_t maxSize, uint32_t *blockSize) {
+        uint32_t size = fileSize_ - filePosition_;
+        size = size < TEST_BLOCK_SIZE ? size : TEST_BLOCK_SIZE;
+        size = size < maxSize ? size : maxSize;
+        if (size == 0 || filePosition_ >= readFailsAt_) {
+            return false;
+        }
+        memcpy(block, file_ + filePosition_, size);
+        *blockSize = size;
+        filePosition_ += size;
+        bytesRead_ += size;
+        return true;
+    }
+
+    const uint8_t* getFlash(uint32_t offset) {
+        return flash_ + offset;
+    }
+
+    bool eraseSector(uint32_t sector) {
+        memset(flash_ + sector * TEST_SECTOR_SIZE, 0xff, TEST_SECTOR_SIZE);
+        erased_[sector] = true;
+        numberOfErases_++;
+        return true;
+    }
+
+    bool program(uint32_t offset, const uint8_t *block, uint32_t size) {
+        for (uint32_t b = 0; b < size; b++) {
+            if (flash_[offset + b] != 0xff) {
+                programmedOverData_ = true;
+            }
+            flash_[offset + b] &= block[b];
+        }
+        return true;
+    }
+
+private:
+    const uint8_t *file_;
+    uint32_t fileSize_;
+    uint32_t filePosition_;
+    uint8_t *flash_;
+    uint8_t sectorBuffer_[TEST_SECTOR_SIZE];
+};
+
+static uint8_t image[TEST_IMAGE_SIZE];
+static uint8_t flash[TEST_SECTOR_SIZE * TEST_NUMBER_OF_SECTORS];
+
+static uint32_t imageCrc() {
+    crc32Init();
+    return crc32Update(0xffffffff, image, TEST_IMAGE_SIZE);
+}
+
+// Updates the flash with image and checks the result of each sector
+static void update(const char *test, FirmwareUpdateResult expected0, FirmwareUpdateResult expected1,
+    FirmwareUpdateResult expected2, FirmwareUpdateResult expected3) {
+    MemoryFirmwareUpdate firmwareUpdate(image, TEST_IMAGE_SIZE, flash);
+    FirmwareUpdateResult expected[TEST_NUMBER_OF_SECTORS] = { expected0, expected1, expected2, expected3 };
+    FirmwareUpdateResult results[TEST_NUMBER_OF_SECTORS];
+
+    hostCheck(firmwareUpdate.getNumberOfSectors() == TEST_NUMBER_OF_SECTORS, test, "number of sectors");
+    hostCheck(firmwareUpdate.getSectorSize(TEST_NUMBER_OF_SECTORS - 1) == 300, test, "size of the last sector");
+    firmwareUpdate.run(results);
+    for (int s = 0; s < TEST_NUMBER_OF_SECTORS; s++) {
+        hostCheck(results[s] == expected[s], test, "sector result");
+        hostCheck(firmwareUpdate.erased_[s] == (expected[s] == UPDATE_PROGRAMMED), test, "erased sector");
+    }
+    hostCheck(!firmwareUpdate.programmedOverData_, test, "programmed a sector that was not erased");
+    hostCheck(memcmp(flash, image, TEST_IMAGE_SIZE) == 0, test, "flash differs from the image");
+    hostCheck(firmwareUpdate.getFileCrc() == imageCrc(), test, "file CRC");
+    hostCheck(firmwareUpdate.bytesRead_ == TEST_IMAGE_SIZE, test, "file not read once");
+    printf("%-28s %d sector(s) erased\n", test, firmwareUpdate.numberOfErases_);
+}
+
+int main() {
+    srand(1);
+    for (int b = 0; b < TEST_IMAGE_SIZE; b++) {
+        image[b] = rand();
+    }
+    memset(flash, 0xff, sizeof(flash));
+
+    // Blank flash
+    update("blank flash", UPDATE_PROGRAMMED, UPDATE_PROGRAMMED, UPDATE_PROGRAMMED, UPDATE_PROGRAMMED);
+
+    // Same image again
+    update("unchanged image", UPDATE_SKIPPED, UPDATE_SKIPPED, UPDATE_SKIPPED, UPDATE_SKIPPED);
+
+    // One byte in the middle of a block of sector 1
+    image[TEST_SECTOR_SIZE + 700] ^= 0x01;
+    update("one byte in sector 1", UPDATE_SKIPPED, UPDATE_PROGRAMMED, UPDATE_SKIPPED, UPDATE_SKIPPED);
+
+    // Last byte of the partial last sector, what follows the image is erased
+    memset(flash + TEST_IMAGE_SIZE, 0x00, sizeof(flash) - TEST_IMAGE_SIZE);
+    image[TEST_IMAGE_SIZE - 1] ^= 0x80;
+    update("last byte of the image", UPDATE_SKIPPED, UPDATE_SKIPPED, UPDATE_SKIPPED, UPDATE_PROGRAMMED);
+    bool erasedAfterImage = true;
+    for (uint32_t b = TEST_IMAGE_SIZE; b < sizeof(flash); b++) {
+        erasedAfterImage = erasedAfterImage && flash[b] == 0xff;
+    }
+    hostCheck(erasedAfterImage, "last byte of the image", "end of the last sector not erased");
+
+    // The first block differs but the second one cannot be read : nothing is erased
+    image[0] ^= 0x10;
+    {
+        MemoryFirmwareUpdate firmwareUpdate(image, TEST_IMAGE_SIZE, flash);
+        firmwareUpdate.readFailsAt_ = TEST_BLOCK_SIZE;
+        hostCheck(firmwareUpdate.updateSector(0) == UPDATE_READ_ERROR, "read error in the sector", "sector result");
+        hostCheck(firmwareUpdate.numberOfErases_ == 0, "read error in the sector", "sector erased");
+        hostCheck(flash[0] == (image[0] ^ 0x10), "read error in the sector", "flash modified");
+        printf("%-28s %d sector(s) erased\n", "read error in the sector", firmwareUpdate.numberOfErases_);
+    }
+
+    // The file is at its end : a read error, not a skipped sector. Only the first run erased sector 0
+    {
+        MemoryFirmwareUpdate firmwareUpdate(image, TEST_IMAGE_SIZE, flash);
+        FirmwareUpdateResult results[TEST_NUMBER_OF_SECTORS];
+        firmwareUpdate.run(results);
+        hostCheck(firmwareUpdate.updateSector(0) == UPDATE_READ_ERROR, "read past the end", "sector result");
+        hostCheck(firmwareUpdate.numberOfErases_ == 1, "read past the end", "sector erased");
+        printf("%-28s %d sector(s) erased\n", "read past the end", firmwareUpdate.numberOfErases_);
+    }
+
+    return hostCheckResult();
+}
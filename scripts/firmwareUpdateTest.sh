@@ -0,0 +1,17 @@
+#!/bin/bash
+
+# Host test of the bootloader sector compare, erase and skip (see firmwareUpdateTest.cpp).
+
+CXX=${CXX:-g++}
+SCRIPT_DIR=$(cd $(dirname "$0") && pwd)
+BOOTLOADER_DIR=${SCRIPT_DIR}/../bootloader
+HOST_DIR=${SCRIPT_DIR}/host
+BUILD_DIR=$(mktemp -d)
+
+${CXX} -O2 -Wall -fsanitize=address,undefined -I${BOOTLOADER_DIR}/Inc -I${HOST_DIR} -o ${BUILD_DIR}/firmwareUpdateTest \
+    ${SCRIPT_DIR}/firmwareUpdateTest.cpp ${BOOTLOADER_DIR}/Src/FirmwareUpdate.cpp ${HOST_DIR}/HostCheck.cpp || { rm -rf ${BUILD_DIR}; exit 1; }
+${BUILD_DIR}/firmwareUpdateTest
+RESULT=$?
+
+rm -rf ${BUILD_DIR}
+exit ${RESULT}
@@ -0,0 +1,413 @@
+/*
+ * Copyright 2021 Xavier Hosxe
+ *
+ * Author: Xavier Hosxe (xavier . hosxe (at) gmail . com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Golden audio regression check of the synth engine.
+ * Built by goldenAudio.sh with the firmware engine sources (see scripts/host).
+ *
+ * The same notes are played through the presets of Presets.cpp, through the delay and grain FX2
+ * types (Fx2, none of the presets uses them) and through every patch of the banks found in <sdcard>/pfm3. Each render is cut in windows and reduced to
+ * a peak and a set of band levels (dB). Those are compared to the golden files
+ * with a tolerance : the floating point rounding of another compiler passes,
+ * a changed sound does not.
+ * The render time of each preset is printed next to the result.
+ */
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "HostEngine.h"
+#include "PatchBank.h"
+#include "SynthState.h"
+
+#define GOLDEN_SECONDS 3.0f
+#define GOLDEN_WINDOW_SIZE 4096
+#define GOLDEN_NUMBER_OF_BANDS 20
+#define GOLDEN_LOWEST_BAND 50.0f
+#define GOLDEN_HIGHEST_BAND 20000.0f
+// Differences below this level are not audible in a preenfm3 patch
+#define GOLDEN_COMPARE_FLOOR_DB -80.0f
+#define GOLDEN_NUMBER_OF_VOICES 6
+#define GOLDEN_SEND .3f
+
+#define GOLDEN_MAX_WINDOWS ((int) (PREENFM_FREQUENCY * GOLDEN_SECONDS) / GOLDEN_WINDOW_SIZE)
+#define GOLDEN_MAX_PRESETS (NUMBER_OF_PATCHES_PER_BANK)
+#define GOLDEN_VALUES_PER_WINDOW (GOLDEN_NUMBER_OF_BANDS + 1)
+
+struct GoldenRender {
+    char name[13];
+    bool valid;
+    int numberOfWindows;
+    float values[GOLDEN_MAX_WINDOWS][GOLDEN_VALUES_PER_WINDOW];
+};
+
+struct GoldenSettings {
+    bool record;
+    const char *goldenFolder;
+    const char *sdCardFolder;
+    float peakTolerance;
+    float bandTolerance;
+};
+
+// Fx2 presets : preenMainPreset through the FX2 types that read far back in their buffer
+struct GoldenFx2 {
+    const char *name;
+    int type;
+    float param1;
+    float param2;
+};
+
+static const struct GoldenFx2 goldenFx2[] = {
+    { "Delay crunch", FILTER2_DELAYCRUNCH, .7f, .5f },
+    { "Ping pong", FILTER2_PINGPONG, .7f, .5f },
+    { "Grain 1", FILTER2_GRAIN1, .8f, .4f },
+    { "Grain 2", FILTER2_GRAIN2, .5f, .4f },
+    { "Long crunch", FILTER2_LONGCRUNCH, .7f, .5f },
+    { "Long pingpon", FILTER2_LONGPINGPONG, .7f, .5f },
+    { "Long grain 1", FILTER2_LONGGRAIN1, .8f, .4f },
+    { "Long grain 2", FILTER2_LONGGRAIN2, .5f, .4f }
+};
+
+static HostEngine engine;
+static float renderBuffer[GOLDEN_MAX_WINDOWS * GOLDEN_WINDOW_SIZE * 2 + BLOCK_SIZE * 2];
+static struct GoldenRender renders[GOLDEN_MAX_PRESETS];
+static struct GoldenRender goldens[GOLDEN_MAX_PRESETS];
+
+// In place radix 2 FFT, size is a power of 2
+static void fft(float *re, float *im, int size) {
+    for (int i = 1, j = 0; i < size; i++) {
+        int bit = size >> 1;
+        for (; j & bit; bit >>= 1) {
+            j ^= bit;
+        }
+        j ^= bit;
+        if (i < j) {
+            float t = re[i]; re[i] = re[j]; re[j] = t;
+            t = im[i]; im[i] = im[j]; im[j] = t;
+        }
+    }
+    for (int len = 2; len <= size; len <<= 1) {
+        float angle = -2.0f * M_PI / len;
+        for (int i = 0; i < size; i += len) {
+            for (int k = 0; k < len / 2; k++) {
+                float wr = cosf(angle * k);
+                float wi = sinf(angle * k);
+                float *r1 = &re[i + k], *i1 = &im[i + k];
+                float *r2 = &re[i + k + len / 2], *i2 = &im[i + k + len / 2];
+                float tr = *r2 * wr - *i2 * wi;
+                float ti = *r2 * wi + *i2 * wr;
+                *r2 = *r1 - tr; *i2 = *i1 - ti;
+                *r1 += tr; *i1 += ti;
+            }
+        }
+    }
+}
+
+// values[0] : peak, values[1..] : band levels
+static void analyseWindow(const float *stereo, float *values) {
+    static float re[GOLDEN_WINDOW_SIZE];
+    static float im[GOLDEN_WINDOW_SIZE];
+    float peak = 0.0f;
+    for (int s = 0; s < GOLDEN_WINDOW_SIZE; s++) {
+        peak = fmaxf(peak, fmaxf(fabsf(stereo[s * 2]), fabsf(stereo[s * 2 + 1])));
+        float hann = .5f - .5f * cosf(2.0f * M_PI * s / (GOLDEN_WINDOW_SIZE - 1));
+        re[s] = (stereo[s * 2] + stereo[s * 2 + 1]) * .5f * hann;
+        im[s] = 0.0f;
+    }
+    values[0] = hostToDb(peak);
+
+    fft(re, im, GOLDEN_WINDOW_SIZE);
+    const float binWidth = PREENFM_FREQUENCY / GOLDEN_WINDOW_SIZE;
+    const float bandRatio = powf(GOLDEN_HIGHEST_BAND / GOLDEN_LOWEST_BAND, 1.0f / GOLDEN_NUMBER_OF_BANDS);
+    float bandLow = GOLDEN_LOWEST_BAND;
+    for (int b = 0; b < GOLDEN_NUMBER_OF_BANDS; b++) {
+        float bandHigh = bandLow * bandRatio;
+        float energy = 0.0f;
+        for (int bin = (int) (bandLow / binWidth); bin < (int) (bandHigh / binWidth) && bin < GOLDEN_WINDOW_SIZE / 2; bin++) {
+            energy += re[bin] * re[bin] + im[bin] * im[bin];
+        }
+        // Hann window gain is .5
+        values[b + 1] = hostToDb(sqrtf(energy) * 2.0f / GOLDEN_WINDOW_SIZE);
+        bandLow = bandHigh;
+    }
+}
+
+// Returns the render time in seconds
+static double render(struct GoldenRender *goldenRender) {
+    const int numberOfBlocks = GOLDEN_MAX_WINDOWS * GOLDEN_WINDOW_SIZE / BLOCK_SIZE + 1;
+    unsigned int nextEvent = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int b = 0; b < numberOfBlocks; b++) {
+        float time = b * BLOCK_SIZE / PREENFM_FREQUENCY;
+        const struct HostNoteEvent *event;
+        while ((event = hostPhraseEvent(time, &nextEvent)) != 0) {
+            if (event->velocity > 0) {
+                engine.noteOn(0, event->note, event->velocity);
+            } else {
+                engine.noteOff(0, event->note);
+            }
+        }
+        engine.nextBlock(&renderBuffer[b * BLOCK_SIZE * 2]);
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    goldenRender->numberOfWindows = GOLDEN_MAX_WINDOWS;
+    for (int w = 0; w < GOLDEN_MAX_WINDOWS; w++) {
+        analyseWindow(&renderBuffer[w * GOLDEN_WINDOW_SIZE * 2], goldenRender->values[w]);
+    }
+    return std::chrono::duration<double>(end - start).count();
+}
+
+static void goldenFileName(char *fileName, int size, const char *folder, const char *source) {
+    snprintf(fileName, size, "%s/%s.golden", folder, source);
+}
+
+static bool writeGoldenFile(const char *fileName, const struct GoldenRender *goldenRenders, int numberOfRenders) {
+    FILE *file = fopen(fileName, "w");
+    if (file == 0) {
+        return false;
+    }
+    fprintf(file, "# preenfm3 golden audio : %d windows of %d samples, peak and %d bands in dB\n", GOLDEN_MAX_WINDOWS,
+        GOLDEN_WINDOW_SIZE, GOLDEN_NUMBER_OF_BANDS);
+    for (int p = 0; p < numberOfRenders; p++) {
+        if (!goldenRenders[p].valid) {
+            continue;
+        }
+        fprintf(file, "preset %d %s\n", p, goldenRenders[p].name);
+        for (int w = 0; w < goldenRenders[p].numberOfWindows; w++) {
+            for (int v = 0; v < GOLDEN_VALUES_PER_WINDOW; v++) {
+                fprintf(file, v == 0 ? "%.2f" : " %.2f", goldenRenders[p].values[w][v]);
+            }
+            fprintf(file, "\n");
+        }
+    }
+    fclose(file);
+    return true;
+}
+
+static bool readGoldenFile(const char *fileName, struct GoldenRender *goldenRenders) {
+    FILE *file = fopen(fileName, "r");
+    if (file == 0) {
+        return false;
+    }
+    for (int p = 0; p < GOLDEN_MAX_PRESETS; p++) {
+        goldenRenders[p].valid = false;
+    }
+
+    char line[512];
+    struct GoldenRender *current = 0;
+    while (fgets(line, sizeof(line), file) != 0) {
+        int presetNumber;
+        if (line[0] == '#') {
+            continue;
+        }
+        if (sscanf(line, "preset %d", &presetNumber) == 1) {
+            current = 0;
+            if (presetNumber >= 0 && presetNumber < GOLDEN_MAX_PRESETS) {
+                current = &goldenRenders[presetNumber];
+                current->valid = true;
+                current->numberOfWindows = 0;
+                // The name is only for the reader of the file
+                current->name[0] = 0;
+            }
+            continue;
+        }
+        if (current == 0 || current->numberOfWindows >= GOLDEN_MAX_WINDOWS) {
+            continue;
+        }
+        char *token = line;
+        float *values = current->values[current->numberOfWindows++];
+        for (int v = 0; v < GOLDEN_VALUES_PER_WINDOW; v++) {
+            values[v] = strtof(token, &token);
+        }
+    }
+    fclose(file);
+    return true;
+}
+
+// Largest difference above the compare floor, in dB
+static void compare(const struct GoldenRender *golden, const struct GoldenRender *current, float *peakDiff, float *bandDiff) {
+    *peakDiff = 0.0f;
+    *bandDiff = 0.0f;
+    if (golden->numberOfWindows != current->numberOfWindows) {
+        *peakDiff = *bandDiff = -HOST_FLOOR_DB;
+        return;
+    }
+    for (int w = 0; w < current->numberOfWindows; w++) {
+        for (int v = 0; v < GOLDEN_VALUES_PER_WINDOW; v++) {
+            float g = golden->values[w][v];
+            float c = current->values[w][v];
+            if (fmaxf(g, c) < GOLDEN_COMPARE_FLOOR_DB) {
+                continue;
+            }
+            float diff = fabsf(g - c);
+            if (v == 0) {
+                *peakDiff = fmaxf(*peakDiff, diff);
+            } else {
+                *bandDiff = fmaxf(*bandDiff, diff);
+            }
+        }
+    }
+}
+
+/*
+ * Render all the presets of one source (Presets.cpp or one bank) and compare them or record them.
+ * Returns the number of presets that drifted or have no golden.
+ */
+static int checkSource(const struct GoldenSettings *settings, const char *source, const struct PFM3File *bank,
+    const struct OneSynthParams *const *presets, int numberOfPresets) {
+    char fileName[512];
+    goldenFileName(fileName, sizeof(fileName), settings->goldenFolder, source);
+    bool hasGolden = !settings->record && readGoldenFile(fileName, goldens);
+    int failures = 0;
+    double sourceTime = 0.0;
+
+    for (int p = 0; p < numberOfPresets; p++) {
+        struct GoldenRender *current = &renders[p];
+        engine.reset(GOLDEN_NUMBER_OF_VOICES, GOLDEN_SEND);
+        if (bank == 0) {
+            engine.loadPreset(0, presets[p]);
+            current->valid = true;
+        } else {
+            current->valid = engine.loadBankPreset(0, bank, p);
+        }
+        strncpy(current->name, engine.getPresetName(0), 12);
+        current->name[12] = 0;
+        if (!current->valid) {
+            printf("%-12s %3d %-12s unreadable record\n", source, p, "");
+            failures++;
+            continue;
+        }
+
+        double seconds = render(current);
+        sourceTime += seconds;
+        printf("%-12s %3d %-12s %8.2f ms %6.1fx realtime", source, p, current->name, seconds * 1000.0,
+            GOLDEN_SECONDS / seconds);
+
+        if (settings->record) {
+            printf("  recorded\n");
+        } else if (!hasGolden || !goldens[p].valid) {
+            printf("  NO GOLDEN\n");
+            failures++;
+        } else {
+            float peakDiff, bandDiff;
+            compare(&goldens[p], current, &peakDiff, &bandDiff);
+            bool ok = peakDiff <= settings->peakTolerance && bandDiff <= settings->bandTolerance;
+            printf("  %-5s peak %5.2f dB  bands %5.2f dB\n", ok ? "OK" : "DRIFT", peakDiff, bandDiff);
+            if (!ok) {
+                failures++;
+            }
+        }
+    }
+    printf("%-12s total %8.2f ms\n", source, sourceTime * 1000.0);
+
+    if (settings->record && !writeGoldenFile(fileName, renders, numberOfPresets)) {
+        printf("Cannot write %s\n", fileName);
+        failures++;
+    }
+    return failures;
+}
+
+static bool isBankSelected(const char *bankName, int argc, char *argv[], int firstBank) {
+    if (firstBank >= argc) {
+        return true;
+    }
+    for (int a = firstBank; a < argc; a++) {
+        if (strcmp(argv[a], bankName) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void usage() {
+    printf("goldenAudio [--record] [--golden folder] [--sdcard folder] [--peak dB] [--bands dB] [bank.bnk...]\n");
+    printf("  --record  : write the golden files instead of comparing\n");
+    printf("  --golden  : folder of the .golden files (default .)\n");
+    printf("  --sdcard  : folder that contains pfm3/, all its banks are checked unless some are named\n");
+    printf("  --peak    : peak tolerance in dB (default 1.0)\n");
+    printf("  --bands   : band level tolerance in dB (default 3.0)\n");
+}
+
+int main(int argc, char *argv[]) {
+    struct GoldenSettings settings = { false, ".", 0, 1.0f, 3.0f };
+    int a = 1;
+    for (; a < argc && argv[a][0] == '-'; a++) {
+        if (strcmp(argv[a], "--record") == 0) {
+            settings.record = true;
+        } else if (strcmp(argv[a], "--golden") == 0 && a + 1 < argc) {
+            settings.goldenFolder = argv[++a];
+        } else if (strcmp(argv[a], "--sdcard") == 0 && a + 1 < argc) {
+            settings.sdCardFolder = argv[++a];
+        } else if (strcmp(argv[a], "--peak") == 0 && a + 1 < argc) {
+            settings.peakTolerance = atof(argv[++a]);
+        } else if (strcmp(argv[a], "--bands") == 0 && a + 1 < argc) {
+            settings.bandTolerance = atof(argv[++a]);
+        } else {
+            usage();
+            return 2;
+        }
+    }
+    if (a < argc && settings.sdCardFolder == 0) {
+        usage();
+        return 2;
+    }
+
+    engine.init(settings.sdCardFolder);
+
+    const struct OneSynthParams *presets[] = { &defaultPreset, &preenMainPreset, &newPresetParams };
+    int failures = checkSource(&settings, "Presets", 0, presets, ARRAY_SIZE(presets));
+
+    static struct OneSynthParams fx2Params[ARRAY_SIZE(goldenFx2)];
+    const struct OneSynthParams *fx2Presets[ARRAY_SIZE(goldenFx2)];
+    for (unsigned int p = 0; p < ARRAY_SIZE(goldenFx2); p++) {
+        fx2Params[p] = preenMainPreset;
+        fx2Params[p].effect2.type = goldenFx2[p].type;
+        fx2Params[p].effect2.param1 = goldenFx2[p].param1;
+        fx2Params[p].effect2.param2 = goldenFx2[p].param2;
+        fx2Params[p].effect2.param3 = 1.0f;
+        strncpy(fx2Params[p].presetName, goldenFx2[p].name, 12);
+        fx2Params[p].presetName[12] = 0;
+        fx2Presets[p] = &fx2Params[p];
+    }
+    failures += checkSource(&settings, "Fx2", 0, fx2Presets, ARRAY_SIZE(goldenFx2));
+
+    if (settings.sdCardFolder != 0) {
+        PatchBank *patchBank = engine.getPatchBank();
+        patchBank->prepareFiles();
+        for (int b = 0; b < NUMBEROFPREENFMBANKS; b++) {
+            const struct PFM3File *bank = patchBank->getFile(b);
+            if (bank->fileType == FILE_EMPTY) {
+                break;
+            }
+            if (isBankSelected(bank->name, argc, argv, a)) {
+                failures += checkSource(&settings, bank->name, bank, 0, NUMBER_OF_PATCHES_PER_BANK);
+            }
+        }
+    }
+
+    if (!settings.record) {
+        printf("%s : %d preset(s) drifted or without golden\n", failures == 0 ? "PASSED" : "FAILED", failures);
+    }
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,17 @@
+#!/bin/bash
+
+# Golden audio regression check of the synth engine (see goldenAudio.cpp).
+# usage : goldenAudio.sh [--record] [--sdcard folder] [--peak dB] [--bands dB] [bank.bnk...]
+#
+# The golden files are in scripts/goldenAudio. Record them again (--record) only when the sound
+# is meant to change. Add --golden <folder> to keep the goldens of your own banks elsewhere.
+
+SCRIPT_DIR=$(cd $(dirname "$0") && pwd)
+BUILD_DIR=$(mktemp -d)
+
+${SCRIPT_DIR}/host/build.sh ${BUILD_DIR}/goldenAudio ${SCRIPT_DIR}/goldenAudio.cpp || { rm -rf ${BUILD_DIR}; exit 1; }
+${BUILD_DIR}/goldenAudio --golden ${SCRIPT_DIR}/goldenAudio "$@"
+RESULT=$?
+
+rm -rf ${BUILD_DIR}
+exit ${RESULT}
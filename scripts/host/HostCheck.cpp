@@ -0,0 +1,40 @@
+/*
+ * Copyright 2021 Xavier Hosxe
+ *
+ * Author: Xavier Hosxe (xavier . hosxe (at) gmail . com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+
+#include "HostCheck.h"
+
+static int failures;
+
+void hostCheck(bool condition, const char *test, const char *what) {
+    if (!condition) {
+        printf("%-*s FAILED : %s\n", HOST_CHECK_NAME_WIDTH, test, what);
+        failures++;
+    }
+}
+
+int hostCheckFailures() {
+    return failures;
+}
+
+int hostCheckResult() {
+    printf("%s : %d failure(s)\n", failures == 0 ? "PASSED" : "FAILED", failures);
+    return failures == 0 ? 0 : 1;
+}
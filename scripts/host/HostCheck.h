@@ -0,0 +1,40 @@
+/*
+ * Copyright 2021 Xavier Hosxe
+ *
+ * Author: Xavier Hosxe (xavier . hosxe (at) gmail . com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef HOST_CHECK_H_
+#define HOST_CHECK_H_
+
+/*
+ * Checks of the host tests. HostCheck.cpp doesn't need the synth engine :
+ * the tests built without build.sh compile it with their sources.
+ */
+
+// Width of the test names in the results
+#define HOST_CHECK_NAME_WIDTH 28
+
+// Prints what failed in test when condition is false
+void hostCheck(bool condition, const char *test, const char *what);
+
+int hostCheckFailures();
+
+// Prints PASSED or FAILED with the number of failed checks, returns the exit code of the test
+int hostCheckResult();
+
+#endif /* HOST_CHECK_H_ */
@@ -0,0 +1,258 @@
+/*
+ * Copyright 2021 Xavier Hosxe
+ *
+ * Author: Xavier Hosxe (xavier . hosxe (at) gmail . com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <math.h>
+#include <new>
+#include <string.h>
+
+#include "HostEngine.h"
+#include "Synth.h"
+#include "SynthState.h"
+#include "Sequencer.h"
+#include "FMDisplaySequencer.h"
+#include "Storage.h"
+#include "Hexter.h"
+#include "MidiDecoder.h"
+
+#define INV127 .00787401574803149606f
+
+// Same names as in preenfm3.cpp, SynthState.cpp uses synth
+SynthState synthState;
+Synth synth;
+Storage sdCard;
+Hexter hexter;
+Sequencer sequencer;
+
+// Sequencer MIDI CC notify the display : not in SYNTH_MODE_SEQUENCER, it draws nothing
+static FMDisplaySequencer displaySequencer;
+static int refreshStatus;
+static int endRefreshStatus;
+
+static int32_t hostBuffer1[BLOCK_SIZE * 2];
+static int32_t hostBuffer2[BLOCK_SIZE * 2];
+static int32_t hostBuffer3[BLOCK_SIZE * 2];
+
+void HostEngine::init(const char *sdCardRoot) {
+    noiseSeed_ = HOST_RANDOM_SEED;
+    if (sdCardRoot != 0) {
+        hostFatFsSetRoot(sdCardRoot);
+    }
+    sequencer.setSynth(&synth);
+    displaySequencer.init(&synthState, 0);
+    displaySequencer.setSequencer(&sequencer);
+    displaySequencer.setRefreshStatusPointer(&refreshStatus, &endRefreshStatus);
+    sequencer.setDisplaySequencer(&displaySequencer);
+    sdCard.init(synth.getTimbre(0)->getParamRaw(), synth.getTimbre(1)->getParamRaw(), synth.getTimbre(2)->getParamRaw(),
+            synth.getTimbre(3)->getParamRaw(), synth.getTimbre(4)->getParamRaw(), synth.getTimbre(5)->getParamRaw());
+    sdCard.getMixerBank()->setMixerState(&synthState.mixerState);
+    sdCard.getPatchBank()->setArpeggiatorPartOfThePreset(&synthState.fullState.midiConfigValue[MIDICONFIG_ARPEGGIATOR_IN_PRESET]);
+    reset(1, 0.0f);
+}
+
+void HostEngine::reset(int numberOfVoices, float send) {
+    hostRandomSeed(HOST_RANDOM_SEED);
+
+    // Nothing must be left from the previous render (voices, filters, compressors, lfos...) :
+    // zeroed then constructed, as after power on. The addresses do not change.
+    synth.~Synth();
+    synthState.~SynthState();
+    memset((void*) &synthState, 0, sizeof(SynthState));
+    memset((void*) &synth, 0, sizeof(Synth));
+    new (&synthState) SynthState();
+    new (&synth) Synth();
+
+    synthState.init(0, 0, 0, 0);
+    synth.setSynthState(&synthState);
+    synth.setNoiseSeed(noiseSeed_);
+    synth.setSequencer(&sequencer);
+    synthState.insertParamListener(&synth);
+    synthState.setStorage(&sdCard);
+    synthState.setHexter(&hexter);
+    synthState.setTimbres(synth.getTimbres());
+
+    for (int t = 0; t < NUMBER_OF_TIMBRES; t++) {
+        synthState.mixerState.instrumentState_[t].numberOfVoices = (t == 0 ? numberOfVoices : 0);
+        synthState.mixerState.instrumentState_[t].send = (t == 0 ? send : 0.0f);
+    }
+    synthState.propagateAfterNewMixerLoad();
+}
+
+void HostEngine::loadPreset(int timbre, const struct OneSynthParams *params) {
+    synthState.propagateBeforeNewParamsLoad(timbre);
+    *synth.getTimbre(timbre)->getParamRaw() = *params;
+    synthState.propagateAfterNewParamsLoad(timbre);
+}
+
+bool HostEngine::loadBankPreset(int timbre, const struct PFM3File *bank, int patchNumber) {
+    char *presetName = synth.getTimbre(timbre)->getPresetName();
+    presetName[0] = 0;
+    synthState.loadPreset(timbre, bank, patchNumber, synth.getTimbre(timbre)->getParamRaw());
+    // PatchBank::loadPatch leaves the params untouched or names them "##"
+    return presetName[0] != 0 && !(presetName[0] == '#' && presetName[1] == '#' && presetName[2] == 0);
+}
+
+void HostEngine::loadPresetRecord(int timbre, uint8_t *record) {
+    synthState.propagateBeforeNewParamsLoad(timbre);
+    sdCard.getPatchBank()->decodeBufferAndApplyPreset(record, synth.getTimbre(timbre)->getParamRaw());
+    synthState.propagateAfterNewParamsLoad(timbre);
+}
+
+void HostEngine::loadMixerRecord(char *record, uint32_t recordSize) {
+    // Same as SynthState::loadMixer, from memory
+    synthState.propagateBeforeNewParamsLoad(synthState.getCurrentTimbre());
+    sdCard.getMixerBank()->applyMixerRecord(record, recordSize);
+    synthState.propagateNewTimbre(synthState.getCurrentTimbre());
+    synthState.propagateAfterNewMixerLoad();
+}
+
+const char* HostEngine::getPresetName(int timbre) {
+    return synth.getTimbre(timbre)->getPresetName();
+}
+
+void HostEngine::setNoiseSeed(uint32_t seed) {
+    noiseSeed_ = seed;
+    synth.setNoiseSeed(seed);
+}
+
+PatchBank* HostEngine::getPatchBank() {
+    return sdCard.getPatchBank();
+}
+
+MixerState* HostEngine::getMixerState() {
+    return &synthState.mixerState;
+}
+
+Synth* HostEngine::getSynth() {
+    return &synth;
+}
+
+SynthState* HostEngine::getSynthState() {
+    return &synthState;
+}
+
+Storage* HostEngine::getStorage() {
+    return &sdCard;
+}
+
+void HostEngine::noteOn(int timbre, int note, int velocity) {
+    synth.noteOn(timbre, note, velocity);
+}
+
+void HostEngine::noteOff(int timbre, int note) {
+    synth.noteOff(timbre, note);
+}
+
+void HostEngine::midiMessage(uint8_t status, uint8_t data1, uint8_t data2) {
+    int channel = status & 0xf;
+
+    for (int timbre = 0; timbre < NUMBER_OF_TIMBRES; timbre++) {
+        const struct MixerInstrumentState &instrument = synthState.mixerState.instrumentState_[timbre];
+        if (instrument.numberOfVoices == 0 || (instrument.midiChannel != 0 && instrument.midiChannel - 1 != channel)) {
+            continue;
+        }
+        int note = data1 + instrument.shiftNote;
+        bool inRange = data1 >= instrument.firstNote && data1 <= instrument.lastNote && note >= 0 && note <= 127;
+
+        switch (status & 0xf0) {
+            case MIDI_NOTE_OFF:
+                if (inRange) {
+                    synth.noteOff(timbre, note);
+                }
+                break;
+            case MIDI_NOTE_ON:
+                if (inRange) {
+                    if (data2 == 0) {
+                        synth.noteOff(timbre, note);
+                    } else {
+                        synth.noteOn(timbre, note, data2);
+                    }
+                }
+                break;
+            case MIDI_POLY_AFTER_TOUCH:
+                if (note >= 0 && note <= 127) {
+                    synth.getTimbre(timbre)->setMatrixPolyAfterTouch(note, INV127 * data2);
+                }
+                break;
+            case MIDI_AFTER_TOUCH:
+                synth.getTimbre(timbre)->setMatrixSource(MATRIX_SOURCE_AFTERTOUCH, INV127 * data1);
+                break;
+            case MIDI_PITCH_BEND:
+                synth.getTimbre(timbre)->setMatrixSource(MATRIX_SOURCE_PITCHBEND, (float) (((int) data2 << 7) + data1 - 8192) * .00012207031250000000f);
+                break;
+            case MIDI_CONTROL_CHANGE:
+                switch (data1) {
+                    case CC_MODWHEEL:
+                        synth.getTimbre(timbre)->setMatrixSource(MATRIX_SOURCE_MODWHEEL, INV127 * data2);
+                        break;
+                    case CC_BREATH:
+                        synth.getTimbre(timbre)->setMatrixSource(MATRIX_SOURCE_BREATH, INV127 * data2);
+                        break;
+                    case CC_MIXER_VOLUME:
+                        synth.setNewMixerValueFromMidi(timbre, MIXER_VALUE_VOLUME, (float) data2 * INV127);
+                        break;
+                    case CC_MIXER_PAN:
+                        synth.setNewMixerValueFromMidi(timbre, MIXER_VALUE_PAN, (float) data2 - 63);
+                        break;
+                    case CC_MIXER_SEND:
+                        synth.setNewMixerValueFromMidi(timbre, MIXER_VALUE_SEND, (float) data2 * INV127);
+                        break;
+                    case CC_HOLD_PEDAL:
+                        synth.setHoldPedal(timbre, data2);
+                        break;
+                    case CC_ALL_NOTES_OFF:
+                        synth.stopArpegiator(timbre);
+                        synth.allNoteOff(timbre);
+                        break;
+                    case CC_ALL_SOUND_OFF:
+                        synth.allSoundOff(timbre);
+                        break;
+                }
+                break;
+        }
+    }
+}
+
+uint8_t HostEngine::nextBlock(float *stereoBlock) {
+    uint8_t saturated = synth.buildNewSampleBlock(hostBuffer1, hostBuffer2, hostBuffer3);
+    // 24 bits samples, shifted left by 8 for the SAI
+    const float fullScaleInverse = 1.0f / ((float) 0x7fffff * 256.0f);
+    for (int s = 0; s < BLOCK_SIZE * 2; s++) {
+        stereoBlock[s] = (hostBuffer1[s] + hostBuffer2[s] + hostBuffer3[s]) * fullScaleInverse;
+    }
+    return saturated;
+}
+
+static const struct HostNoteEvent hostPhrase[] = {
+    { 0.0f, 60, 100 }, { 0.0f, 64, 100 }, { 0.0f, 67, 100 },
+    { 0.75f, 60, 0 }, { 0.75f, 64, 0 }, { 0.75f, 67, 0 },
+    { 1.0f, 36, 127 }, { 1.5f, 36, 0 },
+    { 1.75f, 84, 64 }, { 2.25f, 84, 0 }
+};
+
+const struct HostNoteEvent* hostPhraseEvent(float time, unsigned int *nextEvent) {
+    if (*nextEvent >= ARRAY_SIZE(hostPhrase) || hostPhrase[*nextEvent].time > time) {
+        return 0;
+    }
+    return &hostPhrase[(*nextEvent)++];
+}
+
+float hostToDb(float value) {
+    return value > 0.0f ? fmaxf(20.0f * log10f(value), HOST_FLOOR_DB) : HOST_FLOOR_DB;
+}
@@ -0,0 +1,98 @@
+/*
+ * Copyright 2021 Xavier Hosxe
+ *
+ * Author: Xavier Hosxe (xavier . hosxe (at) gmail . com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef HOST_ENGINE_H_
+#define HOST_ENGINE_H_
+
+#include "Common.h"
+
+struct PFM3File;
+class PatchBank;
+class MixerState;
+class Synth;
+class SynthState;
+class Storage;
+
+#define HOST_RANDOM_SEED 0x12345678
+
+void hostRandomSeed(uint32_t seed);
+
+#define HOST_FLOOR_DB -120.0f
+
+// Level in dB, HOST_FLOOR_DB for silence
+float hostToDb(float value);
+
+struct HostNoteEvent {
+    float time;
+    uint8_t note;
+    // 0 : note off
+    uint8_t velocity;
+};
+
+/*
+ * The phrase the audio tools play : a chord, a low note, a high note.
+ * Returns the next event at or before time (seconds), 0 if none. nextEvent starts at 0.
+ */
+const struct HostNoteEvent* hostPhraseEvent(float time, unsigned int *nextEvent);
+
+/*
+ * The firmware synth engine (Synth, Timbre, Voice, FxBus...) running on the host,
+ * wired the way dependencyInjection() in preenfm3.cpp does it, without display, MIDI or sequencer.
+ * The firmware objects are globals : there is only one engine.
+ */
+class HostEngine {
+public:
+    // sdCardRoot : folder that contains pfm3/, 0 if no file is needed
+    void init(const char *sdCardRoot);
+    // Engine as after power on, timbre 0 alone with numberOfVoices and the given reverb send
+    void reset(int numberOfVoices, float send);
+    // Noise of the next renders, kept by reset. HOST_RANDOM_SEED after init, 0 is not reproducible
+    void setNoiseSeed(uint32_t seed);
+
+    void loadPreset(int timbre, const struct OneSynthParams *params);
+    // false if the record is unreadable or corrupted
+    bool loadBankPreset(int timbre, const struct PFM3File *bank, int patchNumber);
+    // One ALIGNED_PATCH_SIZE bank record
+    void loadPresetRecord(int timbre, uint8_t *record);
+    // One FULL_MIXER_SIZE mixer record (mixer state and the 6 timbres)
+    void loadMixerRecord(char *record, uint32_t recordSize);
+    const char* getPresetName(int timbre);
+    PatchBank* getPatchBank();
+    MixerState* getMixerState();
+    // The firmware objects, for the tools that drive them directly
+    Synth* getSynth();
+    SynthState* getSynthState();
+    Storage* getStorage();
+
+    void noteOn(int timbre, int note, int velocity);
+    void noteOff(int timbre, int note);
+    // Channel voice message, routed to the timbres like MidiDecoder does it :
+    // notes, after touch, pitch bend, mod wheel, breath, hold pedal, volume, pan, send, notes/sound off
+    void midiMessage(uint8_t status, uint8_t data1, uint8_t data2);
+
+    // BLOCK_SIZE stereo samples, the 3 outputs mixed, full scale is 1.0
+    // returns the saturated output bit field of Synth::buildNewSampleBlock
+    uint8_t nextBlock(float *stereoBlock);
+
+private:
+    uint32_t noiseSeed_;
+};
+
+#endif /* HOST_ENGINE_H_ */
@@ -0,0 +1,77 @@
+#!/bin/bash
+
+# Build a host program around the firmware synth engine.
+# usage : build.sh <program> <program sources...>
+# A <program> ending with .so is built as a shared library.
+#
+# The firmware sources are compiled as they are, with the replacements of this folder
+# (dwt.h, fatfs.h, FatFs on stdio, HAL stubs) found first.
+# The display code is only there for its tables : its TFT calls stay unresolved and are never made.
+
+CXX=${CXX:-g++}
+CXXFLAGS=${CXXFLAGS:--Ofast}
+HOST_DIR=$(cd $(dirname "$0") && pwd)
+REPO_DIR=$(dirname $(dirname ${HOST_DIR}))
+FIRMWARE_DIR=${REPO_DIR}/firmware
+PROGRAM=$1
+shift
+
+if [ -z "${PROGRAM}" ] || [ $# -eq 0 ]; then
+    echo "usage : $0 <program> <sources...>"
+    exit 2
+fi
+
+OBJ_DIR=$(mktemp -d)
+
+if [ "${PROGRAM%.so}" != "${PROGRAM}" ]; then
+    # Only what the sources export is visible, the display code that is never called is removed
+    PIC="-fPIC -fvisibility=hidden -ffunction-sections -fdata-sections"
+    LINK="-shared -Wl,--gc-sections"
+    # What is left of the display symbols becomes weak : the library loads without them
+    WEAKEN="--wildcard --weaken-symbol=_ZN10TftDisplay* --weaken-symbol=_ZN18FirmwareTftDisplay* --weaken-symbol=tft"
+    WEAKEN="${WEAKEN} --weaken-symbol=tftMemory --weaken-symbol=preenfm3SwitchToMidiController"
+else
+    PIC=""
+    WEAKEN=""
+    # The unresolved TFT symbols must not be bound when the program starts
+    LINK="-no-pie -Wl,--unresolved-symbols=ignore-in-object-files"
+fi
+
+INCLUDES="-I${HOST_DIR}"
+for dir in synth midi midipal hardware filesystem utils SimpleEffect MidiController
+do
+    INCLUDES="${INCLUDES} -I${FIRMWARE_DIR}/Src/${dir}"
+done
+INCLUDES="${INCLUDES} -I${FIRMWARE_DIR}/Inc -I${REPO_DIR}/lib/Inc"
+INCLUDES="${INCLUDES} -I${FIRMWARE_DIR}/Middlewares/ST/STM32_USB_Device_Library/Core/Inc -I${FIRMWARE_DIR}/Middlewares/ST/STM32_USB_Device_Library/Class/MIDI/Inc"
+INCLUDES="${INCLUDES} -I${FIRMWARE_DIR}/Drivers/STM32H7xx_HAL_Driver/Inc -I${FIRMWARE_DIR}/Drivers/CMSIS/Device/ST/STM32H7xx/Include -I${FIRMWARE_DIR}/Drivers/CMSIS/Include"
+
+SOURCES="${FIRMWARE_DIR}/Src/synth/*.cpp ${FIRMWARE_DIR}/Src/synth/waves.c ${FIRMWARE_DIR}/Src/SimpleEffect/*.cpp"
+SOURCES="${SOURCES} ${FIRMWARE_DIR}/Src/midipal/*.cpp ${FIRMWARE_DIR}/Src/midi/Sequencer.cpp ${FIRMWARE_DIR}/Src/utils/Hexter.cpp"
+SOURCES="${SOURCES} ${FIRMWARE_DIR}/Src/filesystem/*.cpp ${FIRMWARE_DIR}/Src/hardware/Menu.cpp ${FIRMWARE_DIR}/Src/hardware/FMDisplay*.cpp"
+SOURCES="${SOURCES} ${HOST_DIR}/*.cpp $@"
+
+# Firmware code casts pointers to uint32_t : -fpermissive
+PIDS=""
+for source in ${SOURCES}
+do
+    ${CXX} -x c++ -std=gnu++14 ${CXXFLAGS} ${PIC} -w -fpermissive -DUSE_HAL_DRIVER -DSTM32H753xx ${INCLUDES} \
+        -c ${source} -o ${OBJ_DIR}/$(basename ${source}).o &
+    PIDS="${PIDS} $!"
+done
+for pid in ${PIDS}
+do
+    wait ${pid} || { rm -rf ${OBJ_DIR}; exit 1; }
+done
+if [ -n "${WEAKEN}" ]; then
+    for object in ${OBJ_DIR}/*.o
+    do
+        objcopy ${WEAKEN} ${object} || { rm -rf ${OBJ_DIR}; exit 1; }
+    done
+fi
+
+# CXXFLAGS again for -fsanitize
+${CXX} ${CXXFLAGS} ${LINK} -o ${PROGRAM} ${OBJ_DIR}/*.o -lm
+RESULT=$?
+rm -rf ${OBJ_DIR}
+exit ${RESULT}
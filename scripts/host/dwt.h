@@ -0,0 +1,74 @@
+/*
+ * Copyright 2021 Xavier Hosxe
+ *
+ * Author: Xavier Hosxe (xavier . hosxe (at) gmail . com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Host replacement of firmware/Inc/dwt.h.
+ * There is no DWT on the host : the cycle counter is a nanosecond clock.
+ */
+
+#ifndef DWT_H_
+#define DWT_H_
+
+#include "RingBuffer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+uint32_t hostCycleCounter();
+#ifdef __cplusplus
+}
+#endif
+
+#define SHOW_CPU_USAGE 1
+
+#define RESET_DWT_CYCCNT() do {} while ( 0 )
+#define ENABLE_DWT_CYCCNT() do {} while ( 0 )
+#define READ_DWT_CYCCNT() hostCycleCounter()
+
+typedef RingBuffer<uint32_t, 32> CYCCNT_buffer;
+
+class scoped_cyccnt
+{
+public:
+    scoped_cyccnt( CYCCNT_buffer &_buffer )
+: buffer( _buffer ) {
+        start = READ_DWT_CYCCNT();
+    }
+
+    ~scoped_cyccnt() {
+        buffer.insert( READ_DWT_CYCCNT() - start );
+    }
+
+private:
+    CYCCNT_buffer &buffer;
+    uint32_t start;
+};
+
+#define MACRO_CONCAT_(x,y) x##y
+#define MACRO_CONCAT(x,y) MACRO_CONCAT_(x,y)
+
+#define CYCLE_MEASURE_START( x )			\
+        {							\
+            scoped_cyccnt MACRO_CONCAT(CYCNT_,__COUNTER__)( x );	\
+            do {} while(0)
+
+#define CYCLE_MEASURE_END()			\
+        }
+
+#endif /* DWT_H_ */
@@ -0,0 +1,43 @@
+/*
+ * Copyright 2021 Xavier Hosxe
+ *
+ * Author: Xavier Hosxe (xavier . hosxe (at) gmail . com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Host replacement of lib/Inc/fatfs.h.
+ * The FatFs API of ff.h is implemented by hostFatFs.cpp on top of stdio,
+ * "0:/pfm3/..." is mapped to the folder given to hostFatFsSetRoot.
+ * The SD driver headers are left out (integer.h does not build on a 64 bits host),
+ * but what they bring to the files including fatfs.h is kept.
+ */
+
+#ifndef __fatfs_H
+#define __fatfs_H
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+#include "stm32h7xx_hal.h"
+#include "preenfm3_pins.h"
+#include "ff.h"
+
+void hostFatFsSetRoot(const char *root);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /*__fatfs_H */
@@ -0,0 +1,208 @@
+/*
+ * Copyright 2021 Xavier Hosxe
+ *
+ * Author: Xavier Hosxe (xavier . hosxe (at) gmail . com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * The part of the FatFs API used by firmware/Src/filesystem, on top of stdio.
+ * Only what the host tools need : no lock, no long file name.
+ */
+
+#include <dirent.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+
+// FatFs DIR and dirent DIR share the same name
+typedef DIR HostDir;
+#define DIR FF_DIR
+#include "fatfs.h"
+
+#define HOST_MAX_OPEN_FILES 8
+
+static char hostRoot[256] = ".";
+static char hostPath[512];
+static FILE *hostFiles[HOST_MAX_OPEN_FILES + 1];
+static HostDir *hostDirs[HOST_MAX_OPEN_FILES + 1];
+static char hostDirPaths[HOST_MAX_OPEN_FILES + 1][sizeof(hostPath)];
+
+void hostFatFsSetRoot(const char *root) {
+    snprintf(hostRoot, sizeof(hostRoot), "%s", root);
+}
+
+// "0:/pfm3/Default.bnk" -> "<root>/pfm3/Default.bnk"
+static const char* hostFullPath(const TCHAR *path) {
+    if (path[0] == '0' && path[1] == ':') {
+        path += 2;
+    }
+    snprintf(hostPath, sizeof(hostPath), "%s/%s", hostRoot, path[0] == '/' ? path + 1 : path);
+    return hostPath;
+}
+
+static long hostFileSize(FILE *file) {
+    long pos = ftell(file);
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, pos, SEEK_SET);
+    return size;
+}
+
+FRESULT f_open(FIL *fp, const TCHAR *path, BYTE mode) {
+    int slot = 1;
+    while (slot <= HOST_MAX_OPEN_FILES && hostFiles[slot] != 0) {
+        slot++;
+    }
+    if (slot > HOST_MAX_OPEN_FILES) {
+        return FR_TOO_MANY_OPEN_FILES;
+    }
+
+    const char *fullPath = hostFullPath(path);
+    FILE *file;
+    if (!(mode & FA_WRITE)) {
+        file = fopen(fullPath, "rb");
+    } else if (mode & (FA_CREATE_ALWAYS)) {
+        file = fopen(fullPath, "w+b");
+    } else {
+        file = fopen(fullPath, "r+b");
+        if (file == 0 && (mode & FA_OPEN_ALWAYS)) {
+            file = fopen(fullPath, "w+b");
+        }
+    }
+    if (file == 0) {
+        return FR_NO_FILE;
+    }
+
+    memset(fp, 0, sizeof(FIL));
+    hostFiles[slot] = file;
+    fp->obj.id = slot;
+    fp->obj.objsize = hostFileSize(file);
+    fp->flag = mode;
+    return FR_OK;
+}
+
+FRESULT f_close(FIL *fp) {
+    if (fp->obj.id == 0 || hostFiles[fp->obj.id] == 0) {
+        return FR_INVALID_OBJECT;
+    }
+    fclose(hostFiles[fp->obj.id]);
+    hostFiles[fp->obj.id] = 0;
+    fp->obj.id = 0;
+    return FR_OK;
+}
+
+FRESULT f_read(FIL *fp, void *buff, UINT btr, UINT *br) {
+    *br = fread(buff, 1, btr, hostFiles[fp->obj.id]);
+    fp->fptr += *br;
+    return FR_OK;
+}
+
+FRESULT f_write(FIL *fp, const void *buff, UINT btw, UINT *bw) {
+    *bw = fwrite(buff, 1, btw, hostFiles[fp->obj.id]);
+    fp->fptr += *bw;
+    if (fp->fptr > fp->obj.objsize) {
+        fp->obj.objsize = fp->fptr;
+    }
+    return *bw == btw ? FR_OK : FR_DISK_ERR;
+}
+
+FRESULT f_lseek(FIL *fp, FSIZE_t ofs) {
+    if (fseek(hostFiles[fp->obj.id], ofs, SEEK_SET) != 0) {
+        return FR_DISK_ERR;
+    }
+    fp->fptr = ofs;
+    return FR_OK;
+}
+
+FRESULT f_opendir(DIR *dp, const TCHAR *path) {
+    int slot = 1;
+    while (slot <= HOST_MAX_OPEN_FILES && hostDirs[slot] != 0) {
+        slot++;
+    }
+    if (slot > HOST_MAX_OPEN_FILES) {
+        return FR_TOO_MANY_OPEN_FILES;
+    }
+    HostDir *dir = opendir(hostFullPath(path));
+    if (dir == 0) {
+        return FR_NO_PATH;
+    }
+    memset(dp, 0, sizeof(DIR));
+    hostDirs[slot] = dir;
+    strcpy(hostDirPaths[slot], hostPath);
+    dp->obj.id = slot;
+    return FR_OK;
+}
+
+FRESULT f_closedir(DIR *dp) {
+    if (dp->obj.id == 0 || hostDirs[dp->obj.id] == 0) {
+        return FR_INVALID_OBJECT;
+    }
+    closedir(hostDirs[dp->obj.id]);
+    hostDirs[dp->obj.id] = 0;
+    dp->obj.id = 0;
+    return FR_OK;
+}
+
+FRESULT f_readdir(DIR *dp, FILINFO *fno) {
+    struct dirent *entry;
+    memset(fno, 0, sizeof(FILINFO));
+    // FatFs only knows 8.3 names
+    while ((entry = readdir(hostDirs[dp->obj.id])) != 0) {
+        if (entry->d_name[0] != '.' && strlen(entry->d_name) < sizeof(fno->fname)) {
+            break;
+        }
+    }
+    if (entry == 0) {
+        return FR_OK;
+    }
+    strcpy(fno->fname, entry->d_name);
+    struct stat fileStat;
+    snprintf(hostPath, sizeof(hostPath), "%s/%s", hostDirPaths[dp->obj.id], entry->d_name);
+    if (stat(hostPath, &fileStat) == 0) {
+        fno->fsize = fileStat.st_size;
+        fno->fattrib = S_ISDIR(fileStat.st_mode) ? AM_DIR : 0;
+    }
+    return FR_OK;
+}
+
+FRESULT f_stat(const TCHAR *path, FILINFO *fno) {
+    struct stat fileStat;
+    if (stat(hostFullPath(path), &fileStat) != 0) {
+        return FR_NO_FILE;
+    }
+    memset(fno, 0, sizeof(FILINFO));
+    fno->fsize = fileStat.st_size;
+    fno->fattrib = S_ISDIR(fileStat.st_mode) ? AM_DIR : 0;
+    return FR_OK;
+}
+
+FRESULT f_mkdir(const TCHAR *path) {
+    return mkdir(hostFullPath(path), 0755) == 0 ? FR_OK : FR_EXIST;
+}
+
+FRESULT f_unlink(const TCHAR *path) {
+    return remove(hostFullPath(path)) == 0 ? FR_OK : FR_NO_FILE;
+}
+
+FRESULT f_rename(const TCHAR *path_old, const TCHAR *path_new) {
+    char oldPath[sizeof(hostPath)];
+    snprintf(oldPath, sizeof(oldPath), "%s", hostFullPath(path_old));
+    return rename(oldPath, hostFullPath(path_new)) == 0 ? FR_OK : FR_NO_FILE;
+}
+
+FRESULT f_mount(FATFS *fs, const TCHAR *path, BYTE opt) {
+    return FR_OK;
+}
@@ -0,0 +1,63 @@
+/*
+ * Copyright 2021 Xavier Hosxe
+ *
+ * Author: Xavier Hosxe (xavier . hosxe (at) gmail . com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * The few HAL calls reached by the engine on the host.
+ * The RNG is a fixed LCG so that two renders of the same notes give the same samples.
+ * The display code is only linked for its parameter tables (allParameterRows...),
+ * the TFT is never called : its symbols are left unresolved (see build.sh).
+ */
+
+#include <chrono>
+
+#include "stm32h7xx_hal.h"
+#include "dwt.h"
+#include "HostEngine.h"
+
+RNG_HandleTypeDef hrng;
+uint32_t SystemCoreClock = 480000000;
+
+static uint32_t hostRandom = HOST_RANDOM_SEED;
+static const auto hostStart = std::chrono::steady_clock::now();
+
+void hostRandomSeed(uint32_t seed) {
+    hostRandom = seed;
+}
+
+// Nanoseconds : the unit of the host "cycle" counter
+uint32_t hostCycleCounter() {
+    return (uint32_t) std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - hostStart).count();
+}
+
+HAL_StatusTypeDef HAL_RNG_GenerateRandomNumber(RNG_HandleTypeDef *hrng, uint32_t *random32bit) {
+    hostRandom = hostRandom * 1664525 + 1013904223;
+    *random32bit = hostRandom;
+    return HAL_OK;
+}
+
+uint32_t HAL_GetTick(void) {
+    return (uint32_t) std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - hostStart).count();
+}
+
+void HAL_Delay(uint32_t Delay) {
+}
+
+void HAL_GPIO_WritePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin, GPIO_PinState PinState) {
+}
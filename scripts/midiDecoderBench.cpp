@@ -0,0 +1,347 @@
+/*
+ * Copyright 2021 Xavier Hosxe
+ *
+ * Author: Xavier Hosxe (xavier . hosxe (at) gmail . com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Throughput benchmark and fuzzer of MidiDecoder.
+ * Built by midiDecoderBench.sh with the firmware engine sources (see scripts/host).
+ *
+ * The decoder drives the real Synth and SynthState, as in preenfm3DecodeMidiIn :
+ * MIDI_BYTES_PER_BLOCK bytes are decoded, then one block is rendered (not timed).
+ * Each traffic gives the decoder throughput and the worst time of one newByte.
+ * --fuzz feeds random and mutated traffic : built with --asan by midiDecoderBench.sh,
+ * any out of bounds access stops the program with the stack.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+extern "C" {
+#include "usbd_midi.h"
+}
+#include "HostEngine.h"
+#include "MidiDecoder.h"
+#include "dwt.h"
+
+#define MIDI_BYTES_PER_BLOCK 64
+#define MIDI_STREAM_SIZE (1 << 20)
+#define MIDI_FUZZ_STREAM_SIZE (1 << 16)
+
+// What MidiDecoder.cpp uses of the USB device and of the USART
+USBD_HandleTypeDef hUsbDeviceFS;
+static USART_TypeDef hostUsart1;
+UART_HandleTypeDef huart1 = { &hostUsart1 };
+static uint32_t usbBytesSent;
+
+USBD_StatusTypeDef USBD_LL_Transmit(USBD_HandleTypeDef *pdev, uint8_t ep_addr, uint8_t *pbuf, uint32_t size) {
+    usbBytesSent += size;
+    return USBD_OK;
+}
+
+class HostVisualInfo: public VisualInfo {
+public:
+    void midiClock(bool show) {
+    }
+    void noteOn(int timbre, bool show) {
+    }
+};
+
+extern RingBuffer<uint8_t, 64> usartBufferOut;
+
+static HostEngine engine;
+static MidiDecoder midiDecoder;
+static HostVisualInfo visualInfo;
+static uint8_t stream[MIDI_STREAM_SIZE];
+static float block[BLOCK_SIZE * 2];
+static uint32_t randomState;
+
+static uint32_t nextRandom(uint32_t max) {
+    randomState = randomState * 1664525 + 1013904223;
+    return (randomState >> 8) % max;
+}
+
+static void resetEngine() {
+    engine.reset(8, 0.0f);
+    // Same wiring as preenfm3.cpp
+    midiDecoder.setSynthState(engine.getSynthState());
+    midiDecoder.setVisualInfo(&visualInfo);
+    midiDecoder.setSynth(engine.getSynth());
+    midiDecoder.setStorage(engine.getStorage());
+    engine.getSynthState()->insertParamListener(&midiDecoder);
+}
+
+/*
+ * Traffic generators, they return the number of bytes written
+ */
+
+// High resolution CC (MSB then LSB+32) on all channels, running status
+static int generateCC(uint8_t *bytes, int size) {
+    int n = 0;
+    while (n < size - 5) {
+        if (nextRandom(64) == 0) {
+            bytes[n++] = MIDI_CONTROL_CHANGE + nextRandom(16);
+        }
+        uint8_t cc = nextRandom(32);
+        uint16_t value = nextRandom(16384);
+        bytes[n++] = cc;
+        bytes[n++] = value >> 7;
+        bytes[n++] = cc + 32;
+        bytes[n++] = value & 0x7f;
+    }
+    return n;
+}
+
+// NRPN parameter writes, increments and decrements
+static int generateNrpn(uint8_t *bytes, int size) {
+    int n = 0;
+    while (n < size - 12) {
+        bytes[n++] = MIDI_CONTROL_CHANGE + nextRandom(16);
+        if (nextRandom(8) == 0) {
+            bytes[n++] = 96 + nextRandom(2);
+            bytes[n++] = 0;
+            continue;
+        }
+        bytes[n++] = 99;
+        bytes[n++] = nextRandom(8) == 0 ? 2 + nextRandom(2) : nextRandom(2);
+        bytes[n++] = 98;
+        bytes[n++] = nextRandom(128);
+        bytes[n++] = 6;
+        bytes[n++] = nextRandom(128);
+        bytes[n++] = 38;
+        bytes[n++] = nextRandom(128);
+    }
+    return n;
+}
+
+// Notes with running status, note off as note on velocity 0, pitch bend and after touch
+static int generateNotes(uint8_t *bytes, int size) {
+    int n = 0;
+    while (n < size - 3) {
+        switch (nextRandom(16)) {
+            case 0:
+                bytes[n++] = MIDI_NOTE_ON + nextRandom(16);
+                break;
+            case 1:
+                bytes[n++] = MIDI_PITCH_BEND + nextRandom(16);
+                bytes[n++] = nextRandom(128);
+                bytes[n++] = nextRandom(128);
+                bytes[n++] = MIDI_NOTE_ON + nextRandom(16);
+                break;
+            case 2:
+                bytes[n++] = MIDI_AFTER_TOUCH + nextRandom(16);
+                bytes[n++] = nextRandom(128);
+                bytes[n++] = MIDI_NOTE_ON + nextRandom(16);
+                break;
+            default:
+                bytes[n++] = 36 + nextRandom(48);
+                bytes[n++] = nextRandom(2) == 0 ? 0 : 1 + nextRandom(127);
+                break;
+        }
+    }
+    return n;
+}
+
+// Valid and broken SysEx : too long, unterminated, interrupted, stray ends, realtime bytes inside
+static int generateSysex(uint8_t *bytes, int size) {
+    int n = 0;
+    while (n < size - 300) {
+        int length;
+        switch (nextRandom(6)) {
+            case 0:
+                bytes[n++] = MIDI_SYSEX;
+                bytes[n++] = 0x7d;
+                bytes[n++] = nextRandom(8);
+                bytes[n++] = nextRandom(128);
+                bytes[n++] = MIDI_SYSEX_END;
+                break;
+            case 1:
+                // Longer than SYSEX_BUFFER_SIZE
+                bytes[n++] = MIDI_SYSEX;
+                length = 20 + nextRandom(250);
+                for (int k = 0; k < length; k++) {
+                    bytes[n++] = nextRandom(128);
+                }
+                bytes[n++] = MIDI_SYSEX_END;
+                break;
+            case 2:
+                // Interrupted by a note
+                bytes[n++] = MIDI_SYSEX;
+                length = nextRandom(40);
+                for (int k = 0; k < length; k++) {
+                    bytes[n++] = nextRandom(128);
+                }
+                bytes[n++] = MIDI_NOTE_ON + nextRandom(16);
+                bytes[n++] = 60;
+                bytes[n++] = 100;
+                break;
+            case 3:
+                bytes[n++] = MIDI_SYSEX_END;
+                break;
+            case 4:
+                // Short 0x7d messages
+                bytes[n++] = MIDI_SYSEX;
+                bytes[n++] = 0x7d;
+                bytes[n++] = MIDI_SYSEX_END;
+                break;
+            default:
+                bytes[n++] = MIDI_SYSEX;
+                length = nextRandom(40);
+                for (int k = 0; k < length; k++) {
+                    bytes[n++] = nextRandom(4) == 0 ? MIDI_CLOCK : nextRandom(128);
+                }
+                bytes[n++] = MIDI_SYSEX_END;
+                break;
+        }
+    }
+    return n;
+}
+
+// Anything, with more status bytes than chance gives
+static int generateRandom(uint8_t *bytes, int size) {
+    for (int n = 0; n < size; n++) {
+        bytes[n] = nextRandom(3) == 0 ? 0x80 + nextRandom(128) : nextRandom(128);
+    }
+    return size;
+}
+
+// Pieces of the other traffics, bytes flipped
+static int generateMutated(uint8_t *bytes, int size) {
+    int n = 0;
+    while (n < size - 301) {
+        int piece;
+        switch (nextRandom(4)) {
+            case 0:
+                piece = generateCC(bytes + n, 64);
+                break;
+            case 1:
+                piece = generateNrpn(bytes + n, 64);
+                break;
+            case 2:
+                piece = generateNotes(bytes + n, 64);
+                break;
+            default:
+                piece = generateSysex(bytes + n, 301);
+                break;
+        }
+        for (int f = nextRandom(4); f > 0 && piece > 0; f--) {
+            bytes[n + nextRandom(piece)] = nextRandom(256);
+        }
+        n += piece;
+    }
+    return n;
+}
+
+struct MidiTraffic {
+    const char *name;
+    int (*generate)(uint8_t *bytes, int size);
+};
+
+static const struct MidiTraffic traffics[] = {
+    { "cc14", generateCC },
+    { "nrpn", generateNrpn },
+    { "notes", generateNotes },
+    { "sysex", generateSysex },
+    { "random", generateRandom },
+    { "mutated", generateMutated }
+};
+
+struct MidiDecodeStats {
+    double seconds;
+    uint32_t worstByteTime;
+    uint8_t worstByte;
+};
+
+// timeEachByte : worst newByte time instead of the throughput
+static void decode(const uint8_t *bytes, int size, bool timeEachByte, struct MidiDecodeStats *stats) {
+    for (int b = 0; b < size; b += MIDI_BYTES_PER_BLOCK) {
+        int end = b + MIDI_BYTES_PER_BLOCK < size ? b + MIDI_BYTES_PER_BLOCK : size;
+        if (timeEachByte) {
+            for (int k = b; k < end; k++) {
+                uint32_t start = READ_DWT_CYCCNT();
+                midiDecoder.newByte(bytes[k]);
+                uint32_t time = READ_DWT_CYCCNT() - start;
+                if (time > stats->worstByteTime) {
+                    stats->worstByteTime = time;
+                    stats->worstByte = bytes[k];
+                }
+            }
+        } else {
+            uint32_t start = READ_DWT_CYCCNT();
+            for (int k = b; k < end; k++) {
+                midiDecoder.newByte(bytes[k]);
+            }
+            stats->seconds += (READ_DWT_CYCCNT() - start) * 1e-9;
+        }
+        // As the main loop, then the audio interrupt
+        midiDecoder.processAsyncActions();
+        midiDecoder.sendMidiUsbOut();
+        while (usartBufferOut.getCount() > 0) {
+            usartBufferOut.remove();
+        }
+        engine.nextBlock(block);
+    }
+}
+
+static void benchmark() {
+    printf("traffic      bytes      Mbytes/s   worst byte     (status)\n");
+    for (unsigned int t = 0; t < ARRAY_SIZE(traffics); t++) {
+        struct MidiDecodeStats stats = { 0.0, 0, 0 };
+        randomState = 1 + t;
+        int size = traffics[t].generate(stream, MIDI_STREAM_SIZE);
+
+        resetEngine();
+        decode(stream, size, false, &stats);
+        resetEngine();
+        decode(stream, size, true, &stats);
+
+        printf("%-10s %8d  %10.2f  %8u ns     (0x%02x)\n", traffics[t].name, size, size / stats.seconds / 1e6, stats.worstByteTime,
+            stats.worstByte);
+    }
+    // 31250 bauds : 3125 bytes/s on DIN. USB full speed is about 1000 times more.
+    printf("USB bytes sent back : %u\n", usbBytesSent);
+}
+
+static void fuzz(int iterations) {
+    struct MidiDecodeStats stats = { 0.0, 0, 0 };
+    long long bytes = 0;
+    for (int i = 0; i < iterations; i++) {
+        randomState = 0x1000 + i;
+        int size = traffics[nextRandom(ARRAY_SIZE(traffics))].generate(stream, MIDI_FUZZ_STREAM_SIZE);
+        if (i % 16 == 0) {
+            resetEngine();
+        }
+        decode(stream, size, false, &stats);
+        bytes += size;
+    }
+    printf("fuzz : %d streams, %lld bytes decoded\n", iterations, bytes);
+}
+
+int main(int argc, char *argv[]) {
+    engine.init(0);
+
+    if (argc == 3 && strcmp(argv[1], "--fuzz") == 0) {
+        fuzz(atoi(argv[2]));
+    } else if (argc == 1) {
+        benchmark();
+    } else {
+        printf("midiDecoderBench [--fuzz iterations]\n");
+        return 2;
+    }
+    return 0;
+}
@@ -0,0 +1,23 @@
+#!/bin/bash
+
+# Throughput benchmark and fuzzer of the MIDI decoder (see midiDecoderBench.cpp).
+# usage : midiDecoderBench.sh [--asan] [--fuzz iterations]
+#
+# --asan builds with the address and undefined behavior sanitizers, to use with --fuzz.
+# Its timings are meaningless.
+
+SCRIPT_DIR=$(cd $(dirname "$0") && pwd)
+BUILD_DIR=$(mktemp -d)
+
+if [ "$1" == "--asan" ]; then
+    export CXXFLAGS="-O1 -g -fno-omit-frame-pointer -fsanitize=address,undefined"
+    shift
+fi
+
+${SCRIPT_DIR}/host/build.sh ${BUILD_DIR}/midiDecoderBench ${SCRIPT_DIR}/midiDecoderBench.cpp \
+    ${SCRIPT_DIR}/../firmware/Src/midi/MidiDecoder.cpp || { rm -rf ${BUILD_DIR}; exit 1; }
+${BUILD_DIR}/midiDecoderBench "$@"
+RESULT=$?
+
+rm -rf ${BUILD_DIR}
+exit ${RESULT}
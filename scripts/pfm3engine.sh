@@ -0,0 +1,20 @@
+#!/bin/bash
+
+# Build libpfm3engine.so, the firmware synth engine with a C API (see pfm3engine/pfm3engine.h),
+# and pfm3engineBench, a plain C client that prints the render statistics.
+# usage : pfm3engine.sh [output folder] (default : build/pfm3engine)
+
+SCRIPT_DIR=$(cd $(dirname "$0") && pwd)
+OUTPUT_DIR=${1:-${SCRIPT_DIR}/../build/pfm3engine}
+CC=${CC:-gcc}
+
+mkdir -p ${OUTPUT_DIR} || exit 1
+OUTPUT_DIR=$(cd ${OUTPUT_DIR} && pwd)
+
+${SCRIPT_DIR}/host/build.sh ${OUTPUT_DIR}/libpfm3engine.so ${SCRIPT_DIR}/pfm3engine/pfm3engine.cpp || exit 1
+cp ${SCRIPT_DIR}/pfm3engine/pfm3engine.h ${OUTPUT_DIR}/
+
+${CC} -O2 -std=c99 -I${OUTPUT_DIR} -o ${OUTPUT_DIR}/pfm3engineBench ${SCRIPT_DIR}/pfm3engine/pfm3engineBench.c \
+    -L${OUTPUT_DIR} -lpfm3engine -Wl,-rpath,'$ORIGIN' || exit 1
+
+echo "${OUTPUT_DIR}/libpfm3engine.so"
@@ -0,0 +1,178 @@
+/*
+ * Copyright 2021 Xavier Hosxe
+ *
+ * Author: Xavier Hosxe (xavier . hosxe (at) gmail . com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+
+#include "pfm3engine.h"
+#include "HostEngine.h"
+#include "PreenFMFileType.h"
+#include "dwt.h"
+
+struct Pfm3EngineMidiEvent {
+    // Frame, counted from the first render
+    uint64_t frame;
+    uint8_t message[3];
+};
+
+static HostEngine engine;
+
+static struct Pfm3EngineMidiEvent midiQueue[PFM3ENGINE_MIDI_QUEUE_SIZE];
+static int midiQueueSize;
+
+// Last engine block, the frames not given yet start at blockPosition
+static float block[BLOCK_SIZE * 2];
+static int blockPosition = BLOCK_SIZE;
+// Frame of the next render call, and frame of the next engine block
+static uint64_t renderFrame;
+static uint64_t blockFrame;
+
+// Records are modified while converted
+static uint8_t patchRecord[ALIGNED_PATCH_SIZE];
+static char mixerRecord[FULL_MIXER_SIZE];
+
+static struct Pfm3EngineStats stats;
+
+void pfm3EngineInit(const char *sdCardRoot) {
+    engine.init(sdCardRoot);
+    pfm3EngineReset(1);
+}
+
+void pfm3EngineReset(int numberOfVoices) {
+    engine.reset(numberOfVoices, 0.0f);
+    midiQueueSize = 0;
+    blockPosition = BLOCK_SIZE;
+    renderFrame = 0;
+    blockFrame = 0;
+    pfm3EngineResetStats();
+}
+
+void pfm3EngineSetNoiseSeed(uint32_t seed) {
+    engine.setNoiseSeed(seed);
+}
+
+float pfm3EngineGetSampleRate() {
+    return PREENFM_FREQUENCY;
+}
+
+int pfm3EngineGetBlockSize() {
+    return BLOCK_SIZE;
+}
+
+int pfm3EngineLoadPatch(int instrument, const void *patch, uint32_t size) {
+    if (size != ALIGNED_PATCH_SIZE || instrument < 0 || instrument >= NUMBER_OF_TIMBRES) {
+        return 0;
+    }
+    memcpy(patchRecord, patch, ALIGNED_PATCH_SIZE);
+    engine.loadPresetRecord(instrument, patchRecord);
+    return 1;
+}
+
+int pfm3EngineLoadMixer(const void *mixer, uint32_t size) {
+    if (size != FULL_MIXER_SIZE) {
+        return 0;
+    }
+    memcpy(mixerRecord, mixer, FULL_MIXER_SIZE);
+    engine.loadMixerRecord(mixerRecord, FULL_MIXER_SIZE);
+    return 1;
+}
+
+const char* pfm3EngineGetPresetName(int instrument) {
+    return engine.getPresetName(instrument);
+}
+
+int pfm3EngineMidi(uint32_t frameOffset, const uint8_t *message, int length) {
+    if (midiQueueSize == PFM3ENGINE_MIDI_QUEUE_SIZE) {
+        stats.midiDropped++;
+        return 0;
+    }
+    struct Pfm3EngineMidiEvent &event = midiQueue[midiQueueSize++];
+    event.frame = renderFrame + frameOffset;
+    for (int b = 0; b < 3; b++) {
+        event.message[b] = b < length ? message[b] : 0;
+    }
+    if (event.frame < blockFrame) {
+        stats.midiLate++;
+    }
+    return 1;
+}
+
+// Play, in the order they were sent, the events before the end of the next engine block
+static void dispatchMidi() {
+    uint64_t blockEnd = blockFrame + BLOCK_SIZE;
+    int kept = 0;
+    for (int e = 0; e < midiQueueSize; e++) {
+        if (midiQueue[e].frame < blockEnd) {
+            engine.midiMessage(midiQueue[e].message[0], midiQueue[e].message[1], midiQueue[e].message[2]);
+        } else {
+            midiQueue[kept++] = midiQueue[e];
+        }
+    }
+    midiQueueSize = kept;
+}
+
+void pfm3EngineRender(float *stereo, uint32_t frames) {
+    uint32_t callStart = READ_DWT_CYCCNT();
+
+    for (uint32_t f = 0; f < frames; f++) {
+        if (blockPosition == BLOCK_SIZE) {
+            dispatchMidi();
+            uint32_t blockStart = READ_DWT_CYCCNT();
+            if (engine.nextBlock(block) != 0) {
+                stats.saturatedBlocks++;
+            }
+            uint32_t blockTime = READ_DWT_CYCCNT() - blockStart;
+            if (blockTime > stats.worstBlockTime) {
+                stats.worstBlockTime = blockTime;
+            }
+            blockFrame += BLOCK_SIZE;
+            blockPosition = 0;
+        }
+        *stereo++ = block[blockPosition * 2];
+        *stereo++ = block[blockPosition * 2 + 1];
+        blockPosition++;
+    }
+    renderFrame += frames;
+
+    // hostCycleCounter counts nanoseconds
+    uint32_t callTime = READ_DWT_CYCCNT() - callStart;
+    stats.calls++;
+    stats.frames += frames;
+    stats.lastCallTime = callTime;
+    stats.totalCallTime += callTime;
+    if (callTime > stats.worstCallTime) {
+        stats.worstCallTime = callTime;
+    }
+    if (frames > 0) {
+        float load = callTime * (PREENFM_FREQUENCY / 1000000000.0f) / frames;
+        if (load > stats.worstLoad) {
+            stats.worstLoad = load;
+        }
+        if (load > 1.0f) {
+            stats.overruns++;
+        }
+    }
+}
+
+void pfm3EngineGetStats(struct Pfm3EngineStats *statsCopy) {
+    *statsCopy = stats;
+}
+
+void pfm3EngineResetStats() {
+    memset(&stats, 0, sizeof(stats));
+}
@@ -0,0 +1,101 @@
+/*
+ * Copyright 2021 Xavier Hosxe
+ *
+ * Author: Xavier Hosxe (xavier . hosxe (at) gmail . com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * libpfm3engine : the firmware synth engine (Synth, Timbre, Voice, FxBus, SynthState)
+ * as a host shared library, built by scripts/pfm3engine.sh.
+ *
+ * The firmware objects are globals : there is one engine per process.
+ * pfm3EngineMidi and pfm3EngineRender must be called from the same thread (the audio thread).
+ * The load functions must not run during a render.
+ * pfm3EngineRender does no allocation and takes no lock.
+ */
+
+#ifndef PFM3ENGINE_H_
+#define PFM3ENGINE_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#pragma GCC visibility push(default)
+
+// MIDI events waiting for their render
+#define PFM3ENGINE_MIDI_QUEUE_SIZE 512
+
+struct Pfm3EngineStats {
+    uint32_t calls;
+    uint64_t frames;
+    // Time spent in pfm3EngineRender, nanoseconds
+    uint64_t lastCallTime;
+    uint64_t worstCallTime;
+    uint64_t totalCallTime;
+    // Time of one BLOCK_SIZE engine block, nanoseconds
+    uint64_t worstBlockTime;
+    // Worst call time / audio duration of the call, 1.0 is the realtime limit
+    float worstLoad;
+    // Calls slower than realtime
+    uint32_t overruns;
+    // MIDI events refused because the queue was full
+    uint32_t midiDropped;
+    // MIDI events for frames already rendered (left over block), played in the next block
+    uint32_t midiLate;
+    // Blocks with a saturated output
+    uint32_t saturatedBlocks;
+};
+
+// sdCardRoot : folder that contains pfm3/ (scala scales, user waveforms), can be 0
+void pfm3EngineInit(const char *sdCardRoot);
+// Engine as after power on, instrument 1 alone with numberOfVoices
+void pfm3EngineReset(int numberOfVoices);
+// Same seed, same MIDI : bit identical render. Kept by pfm3EngineReset, 0 is a random seed
+void pfm3EngineSetNoiseSeed(uint32_t seed);
+
+float pfm3EngineGetSampleRate();
+int pfm3EngineGetBlockSize();
+
+// patch : one bank record (1024 bytes of a .bnk file)
+// returns 0 if the size is wrong
+int pfm3EngineLoadPatch(int instrument, const void *patch, uint32_t size);
+// mixer : one mixer record (7168 bytes of a .mix file)
+// returns 0 if the size is wrong
+int pfm3EngineLoadMixer(const void *mixer, uint32_t size);
+const char* pfm3EngineGetPresetName(int instrument);
+
+// Channel voice message (1 to 3 bytes) played frameOffset frames after the start of the next render
+// MIDI is applied at the start of the engine block (BLOCK_SIZE frames) that contains frameOffset
+// returns 0 if the queue is full
+int pfm3EngineMidi(uint32_t frameOffset, const uint8_t *message, int length);
+
+// frames interleaved stereo frames, the 3 stereo outputs mixed, full scale is 1.0
+// Any number of frames : the engine block left over is kept for the next call
+void pfm3EngineRender(float *stereo, uint32_t frames);
+
+void pfm3EngineGetStats(struct Pfm3EngineStats *stats);
+void pfm3EngineResetStats();
+
+#pragma GCC visibility pop
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PFM3ENGINE_H_ */
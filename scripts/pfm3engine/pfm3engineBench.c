@@ -0,0 +1,122 @@
+/*
+ * Copyright 2021 Xavier Hosxe
+ *
+ * Author: Xavier Hosxe (xavier . hosxe (at) gmail . com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Plain C client of libpfm3engine : plays chords the way a plugin host would
+ * (callbacks of a fixed number of frames, MIDI timestamped inside the callback) and prints the render statistics.
+ * usage : pfm3engineBench [--voices n] [--frames n] [--seconds s] [bank.bnk patchNumber]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "pfm3engine.h"
+
+#define MAX_FRAMES 4096
+#define BANK_RECORD_SIZE 1024
+
+static float output[MAX_FRAMES * 2];
+
+static int loadBankPatch(const char *bankName, int patchNumber) {
+    unsigned char record[BANK_RECORD_SIZE];
+    FILE *bank = fopen(bankName, "rb");
+    if (bank == 0) {
+        return 0;
+    }
+    int ok = fseek(bank, (long) patchNumber * BANK_RECORD_SIZE, SEEK_SET) == 0
+            && fread(record, 1, BANK_RECORD_SIZE, bank) == BANK_RECORD_SIZE;
+    fclose(bank);
+    return ok && pfm3EngineLoadPatch(0, record, BANK_RECORD_SIZE);
+}
+
+int main(int argc, char *argv[]) {
+    int voices = 8;
+    int frames = 256;
+    float seconds = 10.0f;
+    const char *bankName = 0;
+    int patchNumber = 0;
+
+    for (int a = 1; a < argc; a++) {
+        if (strcmp(argv[a], "--voices") == 0 && a + 1 < argc) {
+            voices = atoi(argv[++a]);
+        } else if (strcmp(argv[a], "--frames") == 0 && a + 1 < argc) {
+            frames = atoi(argv[++a]);
+        } else if (strcmp(argv[a], "--seconds") == 0 && a + 1 < argc) {
+            seconds = atof(argv[++a]);
+        } else if (bankName == 0) {
+            bankName = argv[a];
+        } else {
+            patchNumber = atoi(argv[a]);
+        }
+    }
+    if (frames < 1 || frames > MAX_FRAMES) {
+        fprintf(stderr, "--frames : 1 to %d\n", MAX_FRAMES);
+        return 2;
+    }
+
+    pfm3EngineInit(0);
+    pfm3EngineReset(voices);
+    if (bankName != 0 && !loadBankPatch(bankName, patchNumber)) {
+        fprintf(stderr, "Cannot load patch %d of %s\n", patchNumber, bankName);
+        return 1;
+    }
+
+    float sampleRate = pfm3EngineGetSampleRate();
+    int calls = (int) (seconds * sampleRate / frames);
+    // A new chord of 'voices' notes every half second, released after 0.4 second
+    int chordLength = (int) (sampleRate * .5f);
+    int chordRelease = (int) (sampleRate * .4f);
+    int frame = 0;
+    int chord = 0;
+    float peak = 0.0f;
+
+    for (int c = 0; c < calls; c++) {
+        for (int f = frame; f < frame + frames; f++) {
+            int position = f % chordLength;
+            if (position == 0 || position == chordRelease) {
+                for (int v = 0; v < voices; v++) {
+                    uint8_t message[3] = { position == 0 ? 0x90 : 0x80, 48 + ((chord * 5 + v * 7) % 36), 100 };
+                    pfm3EngineMidi(f - frame, message, 3);
+                }
+                chord += (position == chordRelease);
+            }
+        }
+        pfm3EngineRender(output, frames);
+        for (int s = 0; s < frames * 2; s++) {
+            if (output[s] > peak) {
+                peak = output[s];
+            }
+        }
+        frame += frames;
+    }
+
+    struct Pfm3EngineStats stats;
+    pfm3EngineGetStats(&stats);
+    double audioSeconds = stats.frames / sampleRate;
+    printf("%s : %d voices, %u calls of %d frames (%.2f ms), %.1f s of audio, peak %.3f\n",
+        pfm3EngineGetPresetName(0), voices, stats.calls, frames, 1000.0f * frames / sampleRate, audioSeconds, peak);
+    printf("call  : average %8.1f us, worst %8.1f us, last %8.1f us\n",
+        stats.totalCallTime / 1000.0 / stats.calls, stats.worstCallTime / 1000.0, stats.lastCallTime / 1000.0);
+    printf("block : worst %8.1f us (%d frames)\n", stats.worstBlockTime / 1000.0, pfm3EngineGetBlockSize());
+    printf("load  : average %5.1f %%, worst %5.1f %%, %u overrun(s)\n",
+        100.0 * stats.totalCallTime / 1e9 / audioSeconds, 100.0 * stats.worstLoad, stats.overruns);
+    printf("midi  : %u dropped, %u late - %u saturated block(s)\n", stats.midiDropped, stats.midiLate, stats.saturatedBlocks);
+    return 0;
+}
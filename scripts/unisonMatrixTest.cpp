@@ -0,0 +1,157 @@
+/*
+ * Copyright 2021 Xavier Hosxe
+ *
+ * Author: Xavier Hosxe (xavier . hosxe (at) gmail . com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Host test of the unison matrix : the unison voices take the destinations of the first voice.
+ * Built twice by unisonMatrixTest.sh with the firmware engine sources (see scripts/host),
+ * the second time with UNISON_MATRIX_PER_VOICE : each voice computes its own matrix.
+ *
+ * usage : unisonMatrixTest --record <file>   renders the unison presets in file
+ *         unisonMatrixTest --compare <file>  renders them again, they must be the same
+ *
+ * The presets use a per voice source (Random), the LFOs that are the same for all voices
+ * and a timbre that leaves unison while its notes are playing.
+ */
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "HostEngine.h"
+#include "Synth.h"
+
+#define UNISON_SECONDS 2.0f
+#define UNISON_NUMBER_OF_VOICES 4
+#define UNISON_NUMBER_OF_BLOCKS ((int) (PREENFM_FREQUENCY * UNISON_SECONDS) / BLOCK_SIZE)
+// The poly case switches the play mode in the middle of the render
+#define UNISON_SWITCH_BLOCK (UNISON_NUMBER_OF_BLOCKS / 2)
+
+struct UnisonPreset {
+    const char *name;
+    struct MatrixRowParams rows[3];
+    // KSync of LFO1, < 0 : off
+    float lfo1KeybRamp;
+    bool leaveUnison;
+};
+
+static const struct UnisonPreset unisonPresets[] = {
+    { "random detune and pan", {
+        { MATRIX_SOURCE_RANDOM, 1.0f, ALL_OSC_FREQ, PAN_OSC1 },
+        { MATRIX_SOURCE_RANDOM, 2.0f, INDEX_MODULATION1, 0 },
+        { MATRIX_SOURCE_LFOENV1, 1.0f, INDEX_MODULATION2, 0 } }, 0.0f, false },
+    { "lfo and envelope", {
+        { MATRIX_SOURCE_LFO1, 1.0f, PAN_OSC1, INDEX_MODULATION1 },
+        { MATRIX_SOURCE_LFOENV1, 2.0f, INDEX_MODULATION2, 0 },
+        { MATRIX_SOURCE_LFOSEQ1, 1.0f, ALL_OSC_FREQ, 0 } }, 0.0f, false },
+    { "free running lfo", {
+        { MATRIX_SOURCE_LFO1, 1.0f, PAN_OSC1, INDEX_MODULATION1 },
+        { MATRIX_SOURCE_LFO2, .5f, LFO1_FREQ, 0 },
+        { MATRIX_SOURCE_LFOENV1, 1.0f, INDEX_MODULATION2, 0 } }, -1.0f, false },
+    { "unison then poly", {
+        { MATRIX_SOURCE_LFO1, 1.0f, PAN_OSC1, INDEX_MODULATION1 },
+        { MATRIX_SOURCE_LFOENV1, 2.0f, INDEX_MODULATION2, 0 },
+        { MATRIX_SOURCE_LFOSEQ1, 1.0f, ALL_OSC_FREQ, 0 } }, 0.0f, true }
+};
+
+#define UNISON_NUMBER_OF_PRESETS ((int) (sizeof(unisonPresets) / sizeof(unisonPresets[0])))
+
+static HostEngine engine;
+static float renderBuffer[UNISON_NUMBER_OF_BLOCKS * BLOCK_SIZE * 2];
+static float recordedBuffer[UNISON_NUMBER_OF_BLOCKS * BLOCK_SIZE * 2];
+
+static void render(const struct UnisonPreset *unisonPreset) {
+    struct OneSynthParams params = preenMainPreset;
+    params.engine1.playMode = PLAY_MODE_UNISON;
+    params.engine2.unisonDetune = .3f;
+    params.engine2.unisonSpread = .8f;
+    params.lfoOsc1.keybRamp = unisonPreset->lfo1KeybRamp;
+    struct MatrixRowParams *rows = &params.matrixRowState1;
+    for (int r = 0; r < MATRIX_SIZE; r++) {
+        rows[r] = (r < 3 ? unisonPreset->rows[r] : (struct MatrixRowParams) { MATRIX_SOURCE_NONE, 0.0f, 0.0f, 0.0f });
+    }
+
+    engine.reset(UNISON_NUMBER_OF_VOICES, 0.0f);
+    engine.loadPreset(0, &params);
+
+    unsigned int nextEvent = 0;
+    for (int b = 0; b < UNISON_NUMBER_OF_BLOCKS; b++) {
+        if (unisonPreset->leaveUnison && b == UNISON_SWITCH_BLOCK) {
+            // As the play mode encoder does : the voices still playing keep their notes
+            engine.getSynth()->getTimbre(0)->getParamRaw()->engine1.playMode = PLAY_MODE_POLY;
+        }
+        float time = b * BLOCK_SIZE / PREENFM_FREQUENCY;
+        const struct HostNoteEvent *event;
+        while ((event = hostPhraseEvent(time, &nextEvent)) != 0) {
+            if (event->velocity > 0) {
+                engine.noteOn(0, event->note, event->velocity);
+            } else {
+                engine.noteOff(0, event->note);
+            }
+        }
+        engine.nextBlock(&renderBuffer[b * BLOCK_SIZE * 2]);
+    }
+}
+
+int main(int argc, char *argv[]) {
+    if (argc != 3 || (strcmp(argv[1], "--record") != 0 && strcmp(argv[1], "--compare") != 0)) {
+        printf("usage : %s --record|--compare <file>\n", argv[0]);
+        return 2;
+    }
+    bool record = strcmp(argv[1], "--record") == 0;
+    FILE *file = fopen(argv[2], record ? "wb" : "rb");
+    if (file == 0) {
+        printf("Cannot open %s\n", argv[2]);
+        return 2;
+    }
+
+    engine.init(0);
+    int failures = 0;
+    for (int p = 0; p < UNISON_NUMBER_OF_PRESETS; p++) {
+        render(&unisonPresets[p]);
+        if (record) {
+            fwrite(renderBuffer, sizeof(float), UNISON_NUMBER_OF_BLOCKS * BLOCK_SIZE * 2, file);
+            printf("%-24s recorded\n", unisonPresets[p].name);
+            continue;
+        }
+
+        if (fread(recordedBuffer, sizeof(float), UNISON_NUMBER_OF_BLOCKS * BLOCK_SIZE * 2, file)
+            != (size_t) UNISON_NUMBER_OF_BLOCKS * BLOCK_SIZE * 2) {
+            printf("%-24s FAILED : nothing recorded\n", unisonPresets[p].name);
+            failures++;
+            continue;
+        }
+        float maxDiff = 0.0f;
+        for (int s = 0; s < UNISON_NUMBER_OF_BLOCKS * BLOCK_SIZE * 2; s++) {
+            maxDiff = fmaxf(maxDiff, fabsf(renderBuffer[s] - recordedBuffer[s]));
+        }
+        if (maxDiff == 0.0f) {
+            printf("%-24s PASSED\n", unisonPresets[p].name);
+        } else {
+            printf("%-24s FAILED : differs by %.1f dB\n", unisonPresets[p].name, hostToDb(maxDiff));
+            failures++;
+        }
+    }
+    fclose(file);
+
+    if (!record) {
+        printf("%s : %d failure(s)\n", failures == 0 ? "PASSED" : "FAILED", failures);
+    }
+    return failures == 0 ? 0 : 1;
+}
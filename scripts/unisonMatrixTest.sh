@@ -0,0 +1,17 @@
+#!/bin/bash
+
+# Host test of the unison matrix against the matrix computed by each voice (see unisonMatrixTest.cpp).
+
+SCRIPT_DIR=$(cd $(dirname "$0") && pwd)
+BUILD_DIR=$(mktemp -d)
+BASE_CXXFLAGS=${CXXFLAGS:--Ofast}
+
+CXXFLAGS="${BASE_CXXFLAGS} -DUNISON_MATRIX_PER_VOICE" ${SCRIPT_DIR}/host/build.sh ${BUILD_DIR}/unisonPerVoice \
+    ${SCRIPT_DIR}/unisonMatrixTest.cpp \
+    && CXXFLAGS="${BASE_CXXFLAGS}" ${SCRIPT_DIR}/host/build.sh ${BUILD_DIR}/unisonMatrixTest ${SCRIPT_DIR}/unisonMatrixTest.cpp \
+    || { rm -rf ${BUILD_DIR}; exit 1; }
+${BUILD_DIR}/unisonPerVoice --record ${BUILD_DIR}/perVoice.raw && ${BUILD_DIR}/unisonMatrixTest --compare ${BUILD_DIR}/perVoice.raw
+RESULT=$?
+
+rm -rf ${BUILD_DIR}
+exit ${RESULT}